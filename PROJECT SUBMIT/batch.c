@@ -0,0 +1,404 @@
+/*
+* Batch Mode
+* This file implements "--batch <list-file>": every (image, mode) job in the list is
+* simulated in process on a work-stealing thread pool sized to the host cores, and the
+* results are aggregated into a single JSON or CSV report with per-job wall time.
+* Jobs use the libmipslite API, so each one has its own simulator context.
+*
+* List file format: one image per line, optionally followed by the modes to run
+* (FS, NF, WF; all three when omitted). Paths may contain spaces. Blank lines and lines
+* starting with '#' are skipped.
+*   ../In Progress/validation_branch.txt
+*   sample_mem_image.txt NF WF
+*
+* Supported Operations:
+* - Parallel simulation of thousands of jobs
+* - JSON or CSV report (to a file or stdout) with per-job counters, timing and final-state hash
+*
+* Functions:
+* - batch_main: Parses options and the list file, runs the jobs and writes the report.
+*/
+
+#include "batch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "thread_pool.h"
+#include "sim_hash.h"
+#include "sim_util.h" // For sim_util_now_ns
+
+static const char *batch_mode_names[] = { "FS", "NF", "WF" };
+
+/*
+* Parses a mode name. Returns 0 and sets *mode on success, -1 otherwise.
+*/
+static int batch_parse_mode(const char *name, MipsLiteMode *mode) {
+    for (int m = 0; m < 3; m++) {
+        if (strcmp(name, batch_mode_names[m]) == 0) {
+            *mode = (MipsLiteMode)m;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+* Runs one job on a pool worker: load, simulate to completion, collect the results.
+*/
+static void batch_run_job(void *arg, int worker) {
+    BatchJob *job = arg;
+    uint64_t start = sim_util_now_ns();
+
+    job->worker = worker;
+    MipsLiteSim *sim = mipslite_create(job->mode);
+    if (sim && mipslite_load_file(sim, job->image) >= 0) {
+        // FS has no cycle limit of its own, so never-halting images would stall the whole batch
+        mipslite_step_instructions(sim, BATCH_MAX_INSTRUCTIONS);
+        job->halted = mipslite_halted(sim);
+        job->stop = mipslite_stop_reason(sim, &job->loop_lo, &job->loop_hi);
+        mipslite_get_stats(sim, &job->stats);
+        job->pc = mipslite_get_pc(sim);
+
+        // Final state digest, so reports from different builds can be compared cheaply
+        uint64_t hash = SIM_HASH_SEED;
+        for (int r = 0; r < 32; r++) {
+            int32_t value = mipslite_get_register(sim, r);
+            hash = sim_hash_bytes(&value, sizeof(value), hash);
+        }
+        for (uint32_t addr = 0; addr < MIPSLITE_MEMORY_WORDS * 4; addr += 4) {
+            uint32_t word = 0;
+            mipslite_read_memory(sim, addr, &word);
+            hash = sim_hash_bytes(&word, sizeof(word), hash);
+        }
+        job->state_hash = hash;
+        job->ok = 1;
+    }
+    mipslite_destroy(sim);
+
+    job->time_ns = sim_util_now_ns() - start;
+}
+
+/*
+* Returns the report status of a finished job: "ok", "limit" (did not halt within
+* BATCH_MAX_INSTRUCTIONS, or stopped by the NF/WF cycle cap or a budget), "livelock"
+* (the watchdog found an infinite loop) or "error" (image could not be loaded).
+* The watchdog marks stopped runs as halted too, so its stop reason is checked first.
+*/
+static const char *batch_status(const BatchJob *job) {
+    if (!job->ok) return "error";
+    if (job->stop == MIPSLITE_STOP_LIVELOCK) return "livelock";
+    if (job->stop != MIPSLITE_STOP_NONE || !job->halted) return "limit";
+    return "ok";
+}
+
+/*
+* Reads the whole list file into a NUL-terminated buffer. Returns NULL on error.
+*/
+static char *batch_read_list(const char *filename) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        perror("Error opening batch list file");
+        return NULL;
+    }
+    size_t size = 0, capacity = BATCH_LIST_CHUNK;
+    char *buf = malloc(capacity + 1);
+    while (buf) {
+        size_t n = fread(buf + size, 1, capacity - size, file);
+        size += n;
+        if (size < capacity) break;
+        capacity *= 2;
+        char *grown = realloc(buf, capacity + 1);
+        if (!grown) {
+            free(buf);
+            buf = NULL;
+        } else {
+            buf = grown;
+        }
+    }
+    fclose(file);
+    if (!buf) {
+        fprintf(stderr, "Error: Out of memory reading '%s'\n", filename);
+        return NULL;
+    }
+    buf[size] = '\0';
+    return buf;
+}
+
+/*
+* Builds the job list from the list file contents (tokenized in place).
+* Returns the number of jobs, or -1 on a malformed line or allocation failure.
+*/
+static long batch_parse_jobs(char *list, const char *list_name, BatchJob **jobs_out) {
+    size_t count = 0, capacity = 0;
+    BatchJob *jobs = NULL;
+    int line_no = 0;
+    char *line_save = NULL;
+
+    for (char *line = strtok_r(list, "\n", &line_save); line; line = strtok_r(NULL, "\n", &line_save)) {
+        line_no++;
+        while (*line == ' ' || *line == '\t') line++;
+        size_t len = strlen(line);
+        while (len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t' || line[len - 1] == '\r')) line[--len] = '\0';
+        if (len == 0 || line[0] == '#') continue;
+
+        // Trailing mode names are peeled off from the end, so image paths may contain spaces
+        MipsLiteMode modes[3];
+        int num_modes = 0;
+        while (1) {
+            char *sep = strrchr(line, ' ');
+            char *tab = strrchr(line, '\t');
+            if (!sep || (tab && tab > sep)) sep = tab;
+            MipsLiteMode mode;
+            if (!sep || batch_parse_mode(sep + 1, &mode) < 0) break;
+            if (num_modes == 3) {
+                fprintf(stderr, "Error: %s:%d: Too many modes\n", list_name, line_no);
+                free(jobs);
+                return -1;
+            }
+            modes[num_modes++] = mode;
+            while (sep > line && (sep[-1] == ' ' || sep[-1] == '\t')) sep--;
+            *sep = '\0';
+        }
+        const char *image = line;
+        if (num_modes == 0) {
+            modes[0] = MIPSLITE_FS;
+            modes[1] = MIPSLITE_NF;
+            modes[2] = MIPSLITE_WF;
+            num_modes = 3;
+        } else {
+            // Peeled in reverse; run them in the order written
+            for (int m = 0; m < num_modes / 2; m++) {
+                MipsLiteMode tmp = modes[m];
+                modes[m] = modes[num_modes - 1 - m];
+                modes[num_modes - 1 - m] = tmp;
+            }
+        }
+
+        for (int m = 0; m < num_modes; m++) {
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 256;
+                BatchJob *grown = realloc(jobs, capacity * sizeof(BatchJob));
+                if (!grown) {
+                    fprintf(stderr, "Error: Out of memory building the batch job list\n");
+                    free(jobs);
+                    return -1;
+                }
+                jobs = grown;
+            }
+            memset(&jobs[count], 0, sizeof(BatchJob));
+            jobs[count].image = image;
+            jobs[count].mode = modes[m];
+            count++;
+        }
+    }
+    *jobs_out = jobs;
+    return (long)count;
+}
+
+/*
+* Writes a string as a JSON string literal.
+*/
+static void batch_json_string(FILE *out, const char *str) {
+    fputc('"', out);
+    for (const char *p = str; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(out, "\\%c", *p);
+        } else if ((unsigned char)*p < 0x20) {
+            fprintf(out, "\\u%04x", (unsigned char)*p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/*
+* Writes the aggregated report as JSON.
+*/
+static void batch_write_json(FILE *out, const BatchJob *jobs, long num_jobs, int threads,
+                             long failed, uint64_t wall_ns, uint64_t job_ns) {
+    fprintf(out, "{\n");
+    fprintf(out, "  \"threads\": %d,\n", threads);
+    fprintf(out, "  \"jobs\": %ld,\n", num_jobs);
+    fprintf(out, "  \"failed\": %ld,\n", failed);
+    fprintf(out, "  \"wall_time_us\": %" PRIu64 ",\n", wall_ns / 1000);
+    fprintf(out, "  \"job_time_us\": %" PRIu64 ",\n", job_ns / 1000);
+    fprintf(out, "  \"results\": [\n");
+    for (long i = 0; i < num_jobs; i++) {
+        const BatchJob *job = &jobs[i];
+        fprintf(out, "    {\"image\": ");
+        batch_json_string(out, job->image);
+        fprintf(out, ", \"mode\": \"%s\", \"status\": \"%s\", \"worker\": %d, \"time_us\": %" PRIu64,
+                batch_mode_names[job->mode], batch_status(job), job->worker, job->time_ns / 1000);
+        if (job->ok) {
+            fprintf(out, ", \"instructions\": %" PRIu64 ", \"arithmetic\": %" PRIu64 ", \"logical\": %" PRIu64
+                         ", \"memory_access\": %" PRIu64 ", \"control_transfer\": %" PRIu64
+                         ", \"clock_cycles\": %" PRIu64 ", \"stalls\": %" PRIu64 ", \"flushes\": %" PRIu64
+                         ", \"pc\": %u, \"state_hash\": \"%016" PRIx64 "\"",
+                    job->stats.total_instructions, job->stats.arithmetic_instructions, job->stats.logical_instructions,
+                    job->stats.memory_access_instructions, job->stats.control_transfer_instructions,
+                    job->stats.clock_cycles, job->stats.total_stalls, job->stats.total_flushes,
+                    job->pc, job->state_hash);
+        }
+        if (job->ok && job->stop == MIPSLITE_STOP_LIVELOCK) {
+            fprintf(out, ", \"loop_lo\": %u, \"loop_hi\": %u", job->loop_lo, job->loop_hi);
+        }
+        fprintf(out, "}%s\n", i + 1 < num_jobs ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+/*
+* Writes the aggregated report as CSV (one row per job).
+*/
+static void batch_write_csv(FILE *out, const BatchJob *jobs, long num_jobs) {
+    fprintf(out, "image,mode,status,worker,time_us,instructions,arithmetic,logical,memory_access,"
+                 "control_transfer,clock_cycles,stalls,flushes,pc,state_hash,loop_lo,loop_hi\n");
+    for (long i = 0; i < num_jobs; i++) {
+        const BatchJob *job = &jobs[i];
+        // Quote the path, doubling embedded quotes
+        fputc('"', out);
+        for (const char *p = job->image; *p; p++) {
+            if (*p == '"') fputc('"', out);
+            fputc(*p, out);
+        }
+        fprintf(out, "\",%s,%s,%d,%" PRIu64, batch_mode_names[job->mode], batch_status(job),
+                job->worker, job->time_ns / 1000);
+        if (job->ok) {
+            fprintf(out, ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                         ",%" PRIu64 ",%u,%016" PRIx64,
+                    job->stats.total_instructions, job->stats.arithmetic_instructions, job->stats.logical_instructions,
+                    job->stats.memory_access_instructions, job->stats.control_transfer_instructions,
+                    job->stats.clock_cycles, job->stats.total_stalls, job->stats.total_flushes,
+                    job->pc, job->state_hash);
+            if (job->stop == MIPSLITE_STOP_LIVELOCK) {
+                fprintf(out, ",%u,%u\n", job->loop_lo, job->loop_hi);
+            } else {
+                fprintf(out, ",,\n");
+            }
+        } else {
+            fprintf(out, ",,,,,,,,,,,,\n");
+        }
+    }
+}
+
+/*
+* Prints the batch mode usage.
+*/
+static void print_batch_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --batch <list-file> [options]\n", prog);
+    fprintf(stderr, "List file: one '<image> [FS|NF|WF ...]' per line (all modes if none given)\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --jobs=<n>            Worker threads (default: online cores)\n");
+    fprintf(stderr, "  --report=<file>       Write the report to file (default: stdout)\n");
+    fprintf(stderr, "  --format=<json|csv>   Report format (default: csv for *.csv reports, else json)\n");
+}
+
+/*
+* Entry point for batch mode.
+* argv[0] is "--batch" and argv[1] the list file.
+* Returns 0 if every job succeeded, 1 if any job failed, 2 on usage or I/O errors.
+*/
+int batch_main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_batch_usage("simulator");
+        return 2;
+    }
+
+    const char *list_file = argv[1];
+    const char *report_file = NULL;
+    const char *format = NULL;
+    int threads = 0;
+
+    for (int i = 2; i < argc; i++) {
+        if (strncmp(argv[i], "--jobs=", 7) == 0) {
+            threads = atoi(argv[i] + 7);
+            if (threads <= 0) {
+                fprintf(stderr, "Error: Invalid thread count '%s'\n", argv[i] + 7);
+                return 2;
+            }
+        } else if (strncmp(argv[i], "--report=", 9) == 0) {
+            report_file = argv[i] + 9;
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            format = argv[i] + 9;
+            if (strcmp(format, "json") != 0 && strcmp(format, "csv") != 0) {
+                fprintf(stderr, "Error: Invalid report format '%s'\n", format);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            print_batch_usage("simulator");
+            return 2;
+        }
+    }
+    if (!format) {
+        size_t len = report_file ? strlen(report_file) : 0;
+        format = (len >= 4 && strcmp(report_file + len - 4, ".csv") == 0) ? "csv" : "json";
+    }
+
+    char *list = batch_read_list(list_file);
+    if (!list) return 2;
+    BatchJob *jobs = NULL;
+    long num_jobs = batch_parse_jobs(list, list_file, &jobs);
+    if (num_jobs < 0) {
+        free(list);
+        return 2;
+    }
+
+    if (threads <= 0) threads = thread_pool_default_size();
+    ThreadPool *pool = thread_pool_create(threads);
+    if (!pool) {
+        fprintf(stderr, "Error: Cannot start the batch thread pool\n");
+        free(jobs);
+        free(list);
+        return 2;
+    }
+
+    uint64_t start = sim_util_now_ns();
+    for (long i = 0; i < num_jobs; i++) {
+        if (thread_pool_submit(pool, batch_run_job, &jobs[i]) < 0) {
+            batch_run_job(&jobs[i], -1); // Could not queue, run it here
+        }
+    }
+    thread_pool_wait(pool);
+    uint64_t wall_ns = sim_util_now_ns() - start;
+    thread_pool_destroy(pool);
+
+    long failed = 0;
+    uint64_t job_ns = 0;
+    for (long i = 0; i < num_jobs; i++) {
+        if (strcmp(batch_status(&jobs[i]), "ok") != 0) {
+            failed++;
+            fprintf(stderr, "Error: Job %s %s failed (%s)\n", jobs[i].image, batch_mode_names[jobs[i].mode],
+                    batch_status(&jobs[i]));
+        }
+        job_ns += jobs[i].time_ns;
+    }
+
+    int result = failed ? 1 : 0;
+    FILE *out = report_file ? fopen(report_file, "w") : stdout;
+    if (!out) {
+        perror("Error opening batch report file");
+        result = 2;
+    } else {
+        if (strcmp(format, "csv") == 0) {
+            batch_write_csv(out, jobs, num_jobs);
+        } else {
+            batch_write_json(out, jobs, num_jobs, threads, failed, wall_ns, job_ns);
+        }
+        if (out != stdout && fclose(out) != 0) {
+            perror("Error writing batch report file");
+            result = 2;
+        }
+    }
+
+    fprintf(stderr, "Batch: %ld jobs (%ld failed) on %d threads in %.3f s (%.3f s of simulation)\n",
+            num_jobs, failed, threads, wall_ns / 1e9, job_ns / 1e9);
+
+    free(jobs);
+    free(list);
+    return result;
+}
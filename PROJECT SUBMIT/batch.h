@@ -0,0 +1,38 @@
+/*
+* Batch Mode Header File
+* This header file declares the batch runner, which simulates every (image, mode) job
+* listed in a file on a work-stealing thread pool and writes one aggregated report.
+*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+#include "mipslite.h" // For MipsLiteMode and MipsLiteStats
+
+#define BATCH_LIST_CHUNK 4096 // Initial list file buffer size (grows as needed)
+#define BATCH_MAX_INSTRUCTIONS 10000000ULL // Jobs that have not halted by then are reported as "limit"
+
+/*
+* BatchJob structure:
+* One simulation of one image in one mode, and its result once it has run.
+*/
+typedef struct {
+    const char *image;       // Memory image path (points into the list file buffer)
+    MipsLiteMode mode;
+    int ok;                  // 1 if the image loaded and was simulated
+    int halted;              // 1 if the run finished within BATCH_MAX_INSTRUCTIONS
+    MipsLiteStop stop;       // Why the watchdog stopped the run (cycle cap, budget, livelock)
+    uint32_t loop_lo, loop_hi; // Looping PC range when stop is MIPSLITE_STOP_LIVELOCK
+    int worker;              // Pool worker that ran the job
+    uint64_t time_ns;        // Wall time of the job (load + simulate)
+    uint32_t pc;             // Final program counter
+    uint64_t state_hash;     // Hash of the final registers and memory
+    MipsLiteStats stats;
+} BatchJob;
+
+// Entry point for "<prog> --batch <list-file> [options]"; returns 0 if every job succeeded,
+// 1 if any job failed, 2 on usage or I/O errors
+int batch_main(int argc, char *argv[]);
+
+#endif // BATCH_H
@@ -0,0 +1,154 @@
+/*
+* Checkpoint
+* This file saves and restores architectural checkpoints. A checkpoint is written to a
+* temporary file next to the target and renamed into place, so an interrupted save never
+* leaves a truncated checkpoint behind. Restoring validates the magic, format version,
+* size and checksum before touching the context.
+*
+* Functions:
+* - checkpoint_is_file: Tells whether a file starts with the checkpoint magic.
+* - checkpoint_save: Writes a context's architectural state and counters.
+* - checkpoint_load: Restores a checkpoint into a context.
+*/
+
+#include "checkpoint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "sim_context.h"
+#include "sim_hash.h"
+
+/*
+* Returns the checksum of a checkpoint image (computed with its checksum field zeroed).
+*/
+static uint64_t checkpoint_checksum(const CheckpointFile *file) {
+    CheckpointFile copy = *file;
+    copy.checksum = 0;
+    return sim_hash_bytes(&copy, sizeof(copy), SIM_HASH_SEED);
+}
+
+/*
+* Returns 1 if the file exists and starts with the checkpoint magic, 0 otherwise.
+*/
+int checkpoint_is_file(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return 0;
+    char magic[8];
+    int is_checkpoint = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                        memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return is_checkpoint;
+}
+
+/*
+* Writes the context's architectural state, change tracking and counters to path.
+* Returns 0 on success, -1 on failure.
+*/
+int checkpoint_save(const SimContext *ctx, const char *path) {
+    CheckpointFile *file = calloc(1, sizeof(CheckpointFile));
+    if (!file) {
+        perror("Error allocating checkpoint");
+        return -1;
+    }
+
+    memcpy(file->magic, CHECKPOINT_MAGIC, 8);
+    file->format_version = CHECKPOINT_FORMAT_VERSION;
+    file->size = sizeof(CheckpointFile);
+    file->state = ctx->state;
+    for (int r = 0; r < 32; r++) {
+        if (ctx->register_written[r]) file->register_written_bits |= 1u << r;
+    }
+    for (int w = 0; w < 1024; w++) {
+        if (ctx->memory_changed[w]) file->memory_changed_bits[w / 32] |= 1u << (w % 32);
+    }
+    file->total_instructions = ctx->total_instructions;
+    file->arithmetic_instructions = ctx->arithmetic_instructions;
+    file->logical_instructions = ctx->logical_instructions;
+    file->memory_access_instructions = ctx->memory_access_instructions;
+    file->control_transfer_instructions = ctx->control_transfer_instructions;
+    file->clock_cycles = ctx->clock_cycles;
+    file->total_stalls = ctx->total_stalls;
+    file->total_flushes = ctx->total_flushes;
+    file->cpi = ctx->cpi;
+    file->halted = (uint32_t)ctx->halted;
+    file->checksum = checkpoint_checksum(file);
+
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp-%ld", path, (long)getpid());
+    FILE *out = fopen(tmp_path, "wb");
+    if (!out) {
+        fprintf(stderr, "Error: Cannot write checkpoint '%s': %s\n", tmp_path, strerror(errno));
+        free(file);
+        return -1;
+    }
+    int failed = fwrite(file, sizeof(CheckpointFile), 1, out) != 1;
+    if (fclose(out) != 0) failed = 1;
+    free(file);
+    if (failed || rename(tmp_path, path) < 0) {
+        fprintf(stderr, "Error: Failed to write checkpoint '%s'\n", path);
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+* Restores the checkpoint at path into ctx: architectural state, change tracking and
+* counters. The pipeline is left alone (see resume_pipeline) and attachments are kept.
+* Returns 0 on success, -1 if the file is missing, from another format version or corrupt.
+*/
+int checkpoint_load(SimContext *ctx, const char *path) {
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        fprintf(stderr, "Error: Cannot open checkpoint '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    CheckpointFile *file = malloc(sizeof(CheckpointFile));
+    if (!file) {
+        perror("Error allocating checkpoint");
+        fclose(in);
+        return -1;
+    }
+    size_t got = fread(file, 1, sizeof(CheckpointFile), in);
+    fclose(in);
+
+    const char *problem = NULL;
+    if (got < 16 || memcmp(file->magic, CHECKPOINT_MAGIC, 8) != 0) {
+        problem = "not a checkpoint";
+    } else if (file->format_version != CHECKPOINT_FORMAT_VERSION) {
+        problem = "unsupported format version";
+    } else if (got != sizeof(CheckpointFile) || file->size != sizeof(CheckpointFile)) {
+        problem = "truncated or written by an incompatible build";
+    } else if (file->checksum != checkpoint_checksum(file)) {
+        problem = "checksum mismatch";
+    }
+    if (problem) {
+        fprintf(stderr, "Error: Cannot restore checkpoint '%s': %s\n", path, problem);
+        free(file);
+        return -1;
+    }
+
+    ctx->state = file->state;
+    for (int r = 0; r < 32; r++) {
+        ctx->register_written[r] = (file->register_written_bits >> r) & 1;
+    }
+    for (int w = 0; w < 1024; w++) {
+        ctx->memory_changed[w] = (file->memory_changed_bits[w / 32] >> (w % 32)) & 1;
+    }
+    ctx->total_instructions = file->total_instructions;
+    ctx->arithmetic_instructions = file->arithmetic_instructions;
+    ctx->logical_instructions = file->logical_instructions;
+    ctx->memory_access_instructions = file->memory_access_instructions;
+    ctx->control_transfer_instructions = file->control_transfer_instructions;
+    ctx->clock_cycles = file->clock_cycles;
+    ctx->total_stalls = file->total_stalls;
+    ctx->total_flushes = file->total_flushes;
+    ctx->cpi = file->cpi;
+    ctx->halted = (int)file->halted;
+    free(file);
+    return 0;
+}
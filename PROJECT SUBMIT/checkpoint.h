@@ -0,0 +1,50 @@
+/*
+* Checkpoint Header File
+* This header file defines the versioned binary checkpoint of a simulation's architectural
+* state: PC, registers and memory, the register/memory change-tracking bitmaps and every
+* statistics counter. A checkpoint can be restored into the FS, NF or WF simulator; the
+* pipeline models resume with an empty pipeline fetching from the checkpoint's PC.
+*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include "functional_sim.h" // For MachineState and SimContext
+#include "cpi_stack.h"      // For CpiStack
+
+#define CHECKPOINT_MAGIC "MLCHKPT1"
+#define CHECKPOINT_FORMAT_VERSION 2 // 2: CPI stack
+
+/*
+* CheckpointFile structure:
+* Fixed-size file image (host byte order). checksum is the FNV-1a hash of the whole
+* structure with the checksum field set to 0. Counters are stored as 64-bit values.
+*/
+typedef struct {
+    char magic[8];
+    uint32_t format_version;
+    uint32_t size;                     // sizeof(CheckpointFile) when written
+    uint64_t checksum;
+    MachineState state;
+    uint32_t register_written_bits;    // Bit r set if register r was written
+    uint32_t memory_changed_bits[32];  // Bit (w % 32) of word w / 32 set if memory word w was stored to
+    uint64_t total_instructions;
+    uint64_t arithmetic_instructions;
+    uint64_t logical_instructions;
+    uint64_t memory_access_instructions;
+    uint64_t control_transfer_instructions;
+    uint64_t clock_cycles;
+    uint64_t total_stalls;
+    uint64_t total_flushes;
+    CpiStack cpi;
+    uint32_t halted;
+    uint32_t reserved;
+} CheckpointFile;
+
+// Function prototypes
+int checkpoint_is_file(const char *path);
+int checkpoint_save(const SimContext *ctx, const char *path);
+int checkpoint_load(SimContext *ctx, const char *path);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,103 @@
+/*
+* Commit Trace
+* This file runs the functional simulator and records one CommitRecord per committed
+* instruction: PC, operands, effective memory address and whether a branch was taken.
+* Trace-driven timing models replay these records instead of re-executing the program.
+*
+* Functions:
+* - commit_trace_step: Executes the next instruction of a context and describes it.
+* - commit_trace_collect: Runs an image to completion and stores its commit trace.
+* - commit_trace_free: Releases a trace.
+*/
+
+#include "commit_trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "functional_sim.h"
+#include "predecode.h"   // For fetch_instruction
+#include "sim_context.h"
+
+#define COMMIT_TRACE_INITIAL 4096 // Initial record capacity (grows as needed)
+
+/*
+* Executes the next instruction of ctx functionally and fills *rec with its commit record,
+* and *decoded (unless NULL) with the instruction itself, e.g. for watchdog_commit.
+* Returns 1 if an instruction was committed, 0 once the run has finished
+* (after HALT, or when the PC has left memory).
+*/
+int commit_trace_step(SimContext *ctx, CommitRecord *rec, DecodedInstruction *decoded) {
+    if (ctx->halted) return 0;
+    if (ctx->state.pc >= 4096) {
+        ctx->halted = 1;
+        return 0;
+    }
+
+    uint32_t pc = ctx->state.pc;
+    DecodedInstruction instr = fetch_instruction(ctx, pc);
+
+    memset(rec, 0, sizeof(CommitRecord));
+    rec->pc = pc;
+    rec->opcode = (uint8_t)instr.opcode;
+    rec->type = (uint8_t)instr.type;
+    rec->rs = (uint8_t)instr.rs;
+    rec->rt = (uint8_t)instr.rt;
+    rec->rd = (uint8_t)instr.rd;
+    rec->immediate = (int16_t)instr.immediate;
+    if (instr.opcode == LDW || instr.opcode == STW) {
+        rec->mem_addr = (uint32_t)(ctx->state.registers[instr.rs] + instr.immediate);
+    }
+
+    simulate_instruction(ctx, instr);
+
+    if (instr.opcode == BZ || instr.opcode == BEQ) {
+        rec->taken = ctx->state.pc != pc + 4;
+    } else if (instr.opcode == JR) {
+        rec->taken = 1; // Always redirects fetch, even to pc + 4
+    }
+    if (instr.opcode == HALT) ctx->halted = 1;
+    if (decoded) *decoded = instr;
+    return 1;
+}
+
+/*
+* Runs the image in memory functionally (at most max_instructions instructions) and stores
+* its commit trace. trace->complete tells whether the run finished within the limit.
+* Returns 0 on success, -1 if memory cannot be allocated.
+*/
+int commit_trace_collect(const uint32_t *memory, uint64_t max_instructions, CommitTrace *trace) {
+    memset(trace, 0, sizeof(CommitTrace));
+
+    SimContext *ctx = sim_context_create();
+    if (!ctx) return -1;
+    memcpy(ctx->state.memory, memory, sizeof(ctx->state.memory));
+
+    CommitRecord rec;
+    while (trace->count < max_instructions && commit_trace_step(ctx, &rec, NULL)) {
+        if (trace->count == trace->capacity) {
+            size_t capacity = trace->capacity ? trace->capacity * 2 : COMMIT_TRACE_INITIAL;
+            CommitRecord *grown = realloc(trace->records, capacity * sizeof(CommitRecord));
+            if (!grown) {
+                commit_trace_free(trace);
+                sim_context_destroy(ctx);
+                return -1;
+            }
+            trace->records = grown;
+            trace->capacity = capacity;
+        }
+        trace->records[trace->count++] = rec;
+    }
+    trace->complete = ctx->halted;
+
+    sim_context_destroy(ctx);
+    return 0;
+}
+
+/*
+* Releases a trace's records.
+*/
+void commit_trace_free(CommitTrace *trace) {
+    free(trace->records);
+    memset(trace, 0, sizeof(CommitTrace));
+}
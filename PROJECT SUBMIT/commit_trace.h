@@ -0,0 +1,50 @@
+/*
+* Commit Trace Header File
+* This header file defines the compact per-instruction record produced by functional
+* execution (one per committed instruction, in program order) and the in-memory trace
+* that trace-driven timing models consume. Functional execution is done once and the
+* trace is shared read-only by any number of timing configurations.
+*/
+
+#ifndef COMMIT_TRACE_H
+#define COMMIT_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "instruction_decoder.h" // For DecodedInstruction
+
+typedef struct SimContext SimContext;
+
+/*
+* CommitRecord structure:
+* What a timing model needs to know about one committed instruction (16 bytes).
+*/
+typedef struct {
+    uint32_t pc;
+    uint32_t mem_addr; // Effective byte address for LDW/STW, 0 otherwise
+    uint8_t opcode;
+    uint8_t type;
+    uint8_t rs;
+    uint8_t rt;
+    uint8_t rd;
+    uint8_t taken;     // 1 if a control transfer redirected the PC
+    int16_t immediate; // Signed I-type immediate (branch offset in words for BZ/BEQ)
+} CommitRecord;
+
+/*
+* CommitTrace structure:
+* A growable array of commit records for one run.
+*/
+typedef struct {
+    CommitRecord *records;
+    size_t count;
+    size_t capacity;
+    int complete; // 1 if the run finished (HALT or PC out of memory) within the instruction limit
+} CommitTrace;
+
+// Function prototypes
+int commit_trace_step(SimContext *ctx, CommitRecord *rec, DecodedInstruction *decoded);
+int commit_trace_collect(const uint32_t *memory, uint64_t max_instructions, CommitTrace *trace);
+void commit_trace_free(CommitTrace *trace);
+
+#endif // COMMIT_TRACE_H
@@ -0,0 +1,105 @@
+/*
+* CPI Stack
+* This file implements the cycle accounting behind the CPI stack of the NF and WF models.
+* The pipeline code tags every bubble it inserts with a CpiCategory (insert_bubble); a
+* plain insert_nop() is a fill bubble. At the end of each cycle cpi_stack_account()
+* charges the cycle to the instruction or bubble that is in WB.
+*
+* Supported Operations:
+* - Base, RAW (by producer distance), load-use, branch flush, fill and drain cycles
+* - Memory and structural categories for models that have such stalls
+* - A report printed with the final state
+*
+* Functions:
+* - cpi_stack_stall_cause: Classifies the stall of the instruction in ID.
+* - cpi_stack_account: Charges the cycle that has just been simulated.
+* - cpi_stack_print: Prints the CPI stack (only if it covers every clock cycle).
+*/
+
+#include "cpi_stack.h"
+
+#include <stdio.h>
+
+#include "sim_context.h"
+
+static const char *cpi_category_names[CPI_NUM_CATEGORIES] = {
+    "Base (instruction in WB)", "RAW stall", "Load-use stall", "Branch flush",
+    "Pipeline fill", "Pipeline drain", "Memory stall", "Structural stall"
+};
+
+/*
+* Classifies a RAW stall of the instruction in ID, before the pipeline advances: finds the
+* youngest older instruction in EX or MEM that writes one of its sources. *distance is the
+* number of instructions from the producer to the consumer (1 = back to back), bubbles
+* not counted, and *producer its stage (-1 if none). Returns CPI_LOAD_USE for a LDW
+* producer, CPI_RAW otherwise.
+*/
+int cpi_stack_stall_cause(const SimContext *ctx, int *distance, int *producer) {
+    int older = 0;
+    *distance = 1;
+    *producer = -1;
+    for (int s = EX; s <= MEM; s++) {
+        const PipelineRegister *reg = &ctx->pipeline[s];
+        if (!reg->valid || is_nop(reg->instr)) continue;
+        older++;
+        int dest = get_dest_reg(reg->instr);
+        if (dest > 0 && is_source_reg(ctx->pipeline[ID].instr, dest)) {
+            *distance = older;
+            *producer = s;
+            return reg->instr.opcode == LDW ? CPI_LOAD_USE : CPI_RAW;
+        }
+    }
+    return CPI_RAW;
+}
+
+/*
+* Charges the cycle that has just been simulated to what is in WB now.
+*/
+void cpi_stack_account(SimContext *ctx) {
+    const PipelineRegister *wb = &ctx->pipeline[WB];
+    if (wb->valid) {
+        ctx->cpi.cycles[CPI_BASE]++;
+        return;
+    }
+    ctx->cpi.cycles[wb->bubble]++;
+    if (wb->bubble == CPI_RAW) {
+        int d = wb->bubble_distance < CPI_MAX_DISTANCE ? wb->bubble_distance : CPI_MAX_DISTANCE;
+        ctx->cpi.raw_distance[d - 1]++;
+    }
+}
+
+/*
+* Prints one row of the report.
+*/
+static void print_row(const char *name, uint64_t cycles, uint64_t total, uint64_t instructions) {
+    printf("  %-28s %12llu %7.2f%%  CPI %.3f\n", name, (unsigned long long)cycles,
+           total ? 100.0 * (double)cycles / (double)total : 0.0,
+           instructions ? (double)cycles / (double)instructions : 0.0);
+}
+
+/*
+* Prints the CPI stack. Nothing is printed unless the stack accounts for every clock cycle
+* (it does not for cycles timed by the trace-driven model of --split).
+*/
+void cpi_stack_print(const SimContext *ctx) {
+    const CpiStack *cpi = &ctx->cpi;
+    uint64_t total = 0;
+    for (int c = 0; c < CPI_NUM_CATEGORIES; c++) {
+        total += cpi->cycles[c];
+    }
+    if (total == 0 || total != ctx->clock_cycles) return;
+
+    // Per instruction timed by the pipeline (instructions restored or fast-forwarded are not)
+    uint64_t instructions = cpi->cycles[CPI_BASE];
+    printf("CPI stack (clock cycles by category):\n");
+    print_row(cpi_category_names[CPI_BASE], cpi->cycles[CPI_BASE], total, instructions);
+    for (int d = 0; d < CPI_MAX_DISTANCE; d++) {
+        char name[40];
+        snprintf(name, sizeof(name), "RAW stall, distance %d%s", d + 1, d + 1 == CPI_MAX_DISTANCE ? "+" : "");
+        print_row(name, cpi->raw_distance[d], total, instructions);
+    }
+    for (int c = CPI_LOAD_USE; c < CPI_NUM_CATEGORIES; c++) {
+        print_row(cpi_category_names[c], cpi->cycles[c], total, instructions);
+    }
+    print_row("Total", total, total, instructions);
+}
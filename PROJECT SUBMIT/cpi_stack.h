@@ -0,0 +1,47 @@
+/*
+* CPI Stack Header File
+* This header file declares the CPI stack of the NF and WF pipeline models: every clock
+* cycle is charged to exactly one category, so the categories always add up to
+* clock_cycles. A cycle is charged by what the WB stage holds at the end of it: an
+* instruction (base), or a bubble, which carries the cause it was created for from the
+* stage where it was inserted down to WB.
+*/
+
+#ifndef CPI_STACK_H
+#define CPI_STACK_H
+
+#include <stdint.h>
+
+#define CPI_MAX_DISTANCE 4 // RAW stalls are broken down by producer distance 1, 2, 3 and 4+
+
+// What a clock cycle is charged to
+typedef enum {
+    CPI_BASE,         // An instruction reached WB
+    CPI_RAW,          // Stall on a register written by an older non-load instruction
+    CPI_LOAD_USE,     // Stall on a register loaded by an older LDW
+    CPI_BRANCH_FLUSH, // Wrong-path instruction squashed by a taken branch or JR
+    CPI_FILL,         // Pipeline filling (start of the run, or an emptied pipeline on resume)
+    CPI_DRAIN,        // Nothing left to fetch (HALT fetched or PC past the end of memory)
+    CPI_MEMORY,       // Extra memory cycles (none in the NF/WF models yet)
+    CPI_STRUCTURAL,   // Busy pipeline resources (none in the NF/WF models yet)
+    CPI_NUM_CATEGORIES
+} CpiCategory;
+
+/*
+* CpiStack structure:
+* Lives in the SimContext and is reset with it.
+*/
+typedef struct {
+    uint64_t cycles[CPI_NUM_CATEGORIES];
+    uint64_t raw_distance[CPI_MAX_DISTANCE]; // CPI_RAW cycles by producer distance (1 = previous instruction)
+} CpiStack;
+
+// Simulator context (defined in sim_context.h)
+typedef struct SimContext SimContext;
+
+// Function prototypes
+int cpi_stack_stall_cause(const SimContext *ctx, int *distance, int *producer);
+void cpi_stack_account(SimContext *ctx);
+void cpi_stack_print(const SimContext *ctx);
+
+#endif // CPI_STACK_H
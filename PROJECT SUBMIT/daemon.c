@@ -0,0 +1,798 @@
+/*
+* Simulation Daemon
+* This file implements "--daemon <socket>": the simulator listens on a Unix domain socket and
+* runs the simulation requests of any number of concurrent clients on a work-stealing thread
+* pool. Every pool worker keeps a warm SimContext that is reset between requests, and images
+* are predecoded once and shared by all requests with the same contents (keyed by the hash
+* and size of the image text, so an edited file is predecoded again and identical images
+* sent by different clients or under different paths are predecoded only once).
+*
+* Protocol: a connection carries any number of requests, one per line; every request is
+* answered with one line of JSON.
+*   RUN <FS|NF|WF> [max_cycles=<n>] [max_instructions=<n>] [livelock=0|1] path=<image file>
+*   RUN <FS|NF|WF> [options] bytes=<n>      followed by the n bytes of the image text
+*   PING | STATS | SHUTDOWN
+* path= takes the rest of the line (paths may contain spaces) and is opened by the daemon,
+* relative to its working directory. max_cycles=0 and max_instructions=0 mean unlimited;
+* max_cycles defaults to the mode's budget and max_instructions to DAEMON_MAX_INSTRUCTIONS.
+* Example: printf 'RUN NF path=%s\n' "$PWD/sample_mem_image.txt" | socat - UNIX-CONNECT:/tmp/sim.sock
+*
+* The RUN response carries the same counters and final-state hash as a --batch report:
+*   {"status": "ok", "mode": "NF", "worker": 0, "cached": 1, "time_us": 12, "instructions": ...,
+*    "clock_cycles": ..., "pc": 100, "state_hash": "..."}
+* status is "ok" (halted), "limit" (a budget ran out), "livelock" (with loop_lo/loop_hi) or
+* "error" (with an "error" message).
+*
+* Supported Operations:
+* - Concurrent clients, each on its own connection thread; simulations on the worker pool
+* - Images by path or sent inline, predecoded once per content hash (LRU, --images=<n>)
+* - Per-request budgets and livelock detection
+* - Clean shutdown on SHUTDOWN, SIGINT or SIGTERM (in-flight requests are answered)
+*
+* Functions:
+* - daemon_main: Parses options, serves requests until shut down.
+*/
+
+#define _GNU_SOURCE // For ppoll
+
+#include "daemon.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "functional_sim.h"
+#include "mipslite.h" // For MipsLiteMode and MipsLiteStats
+#include "no_fwd.h"
+#include "sim_context.h"
+#include "sim_hash.h"
+#include "sim_util.h" // For sim_util_now_ns
+#include "thread_pool.h"
+#include "with_fwd.h"
+
+#define DAEMON_UNCACHED -1 // daemon_acquire_image: the image is owned by the request
+
+static const char *daemon_mode_names[] = { "FS", "NF", "WF" };
+
+static volatile sig_atomic_t daemon_stop_requested = 0;
+
+/*
+* DaemonServer structure:
+* State shared by the accept loop, the connection threads and the pool workers.
+* lock protects the image cache, the client table and the counters.
+*/
+typedef struct {
+    int listen_fd;
+    ThreadPool *pool;
+    int num_workers;
+    SimContext **contexts;  // Warm context of each pool worker
+
+    pthread_mutex_t lock;
+    pthread_cond_t clients_done;
+    DaemonImage *images;
+    int num_images;
+    int clients[DAEMON_MAX_CLIENTS]; // Connection sockets, -1 for a free slot
+    int num_clients;
+    int stopping;
+    uint64_t requests, errors, image_hits, image_misses;
+} DaemonServer;
+
+/*
+* DaemonClient structure:
+* One connection and its receive buffer.
+*/
+typedef struct {
+    DaemonServer *server;
+    int fd;
+    int slot;               // Index in server->clients
+    char buf[DAEMON_MAX_LINE];
+    size_t len, pos;        // Buffered bytes and the read position
+} DaemonClient;
+
+/*
+* DaemonJob structure:
+* One simulation handed to the pool, and its result once done is set.
+*/
+typedef struct {
+    DaemonServer *server;
+    MipsLiteMode mode;
+    WatchdogConfig watchdog;
+    const PredecodeFile *file;
+
+    int worker;
+    uint64_t time_ns;
+    WatchdogStop stop;
+    uint32_t loop_lo, loop_hi;
+    uint32_t pc;
+    uint64_t state_hash;
+    MipsLiteStats stats;
+
+    int done;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} DaemonJob;
+
+/*
+* SIGINT/SIGTERM handler: the accept loop sees the flag when its wait is interrupted.
+*/
+static void daemon_signal_handler(int sig) {
+    (void)sig;
+    daemon_stop_requested = 1;
+}
+
+/*
+* Runs one request on a pool worker, in the worker's warm context.
+*/
+static void daemon_run_job(void *arg, int worker) {
+    DaemonJob *job = arg;
+    SimContext *ctx = job->server->contexts[worker];
+    uint64_t start = sim_util_now_ns();
+
+    sim_context_reset(ctx);
+    ctx->watchdog.cfg = job->watchdog;
+    memcpy(ctx->state.memory, job->file->words, sizeof(ctx->state.memory));
+    ctx->predecode = job->file;
+
+    switch (job->mode) {
+        case MIPSLITE_NF:
+            while (!step_pipeline_no_forwarding(ctx)) {
+            }
+            break;
+        case MIPSLITE_WF:
+            while (!step_pipeline_with_forwarding(ctx)) {
+            }
+            break;
+        default:
+            while (!step_functional(ctx)) {
+            }
+            break;
+    }
+
+    job->worker = worker;
+    job->stop = ctx->watchdog.stop;
+    job->loop_lo = ctx->watchdog.loop_lo;
+    job->loop_hi = ctx->watchdog.loop_hi;
+    job->pc = ctx->state.pc;
+    job->stats.total_instructions = ctx->total_instructions;
+    job->stats.arithmetic_instructions = ctx->arithmetic_instructions;
+    job->stats.logical_instructions = ctx->logical_instructions;
+    job->stats.memory_access_instructions = ctx->memory_access_instructions;
+    job->stats.control_transfer_instructions = ctx->control_transfer_instructions;
+    job->stats.clock_cycles = ctx->clock_cycles;
+    job->stats.total_stalls = ctx->total_stalls;
+    job->stats.total_flushes = ctx->total_flushes;
+
+    // Same digest as the batch report (registers, then memory)
+    uint64_t hash = sim_hash_bytes(ctx->state.registers, sizeof(ctx->state.registers), SIM_HASH_SEED);
+    job->state_hash = sim_hash_bytes(ctx->state.memory, sizeof(ctx->state.memory), hash);
+
+    // The image may be evicted once the request is answered
+    ctx->predecode = NULL;
+    job->time_ns = sim_util_now_ns() - start;
+
+    pthread_mutex_lock(&job->lock);
+    job->done = 1;
+    pthread_cond_signal(&job->cond);
+    pthread_mutex_unlock(&job->lock);
+}
+
+/*
+* Looks up the image with this text in the cache, predecoding and inserting it on a miss.
+* *cached is set to 1 on a hit. Returns the cache slot (release with daemon_release_image),
+* DAEMON_UNCACHED if every slot is in use (the image belongs to the caller), or -2 if the
+* image is invalid.
+*/
+static int daemon_acquire_image(DaemonServer *srv, const char *text, size_t size,
+                                PredecodeImage **image, int *cached) {
+    uint64_t hash = sim_hash_bytes(text, size, SIM_HASH_SEED);
+    *cached = 0;
+
+    pthread_mutex_lock(&srv->lock);
+    uint64_t stamp = ++srv->requests;
+    for (int i = 0; i < srv->num_images; i++) {
+        DaemonImage *entry = &srv->images[i];
+        if (entry->image && entry->hash == hash && entry->size == size) {
+            entry->refs++;
+            entry->last_used = stamp;
+            srv->image_hits++;
+            *image = entry->image;
+            *cached = 1;
+            pthread_mutex_unlock(&srv->lock);
+            return i;
+        }
+    }
+    srv->image_misses++;
+    pthread_mutex_unlock(&srv->lock);
+
+    // Predecode outside the lock; a concurrent miss on the same image just builds it twice
+    PredecodeImage *built;
+    if (predecode_build_image(text, size, &built) < 0) return -2;
+
+    pthread_mutex_lock(&srv->lock);
+    int victim = -1;
+    for (int i = 0; i < srv->num_images; i++) {
+        DaemonImage *entry = &srv->images[i];
+        if (entry->image && entry->hash == hash && entry->size == size) {
+            // Inserted meanwhile by another request
+            entry->refs++;
+            entry->last_used = stamp;
+            *image = entry->image;
+            pthread_mutex_unlock(&srv->lock);
+            predecode_release(built);
+            return i;
+        }
+        if (!entry->image) {
+            if (victim < 0 || srv->images[victim].image) victim = i;
+        } else if (entry->refs == 0 && (victim < 0 || (srv->images[victim].image &&
+                                                       entry->last_used < srv->images[victim].last_used))) {
+            victim = i;
+        }
+    }
+    *image = built;
+    if (victim < 0) {
+        pthread_mutex_unlock(&srv->lock);
+        return DAEMON_UNCACHED;
+    }
+    DaemonImage *entry = &srv->images[victim];
+    PredecodeImage *evicted = entry->image;
+    entry->hash = hash;
+    entry->size = size;
+    entry->image = built;
+    entry->refs = 1;
+    entry->last_used = stamp;
+    pthread_mutex_unlock(&srv->lock);
+    predecode_release(evicted);
+    return victim;
+}
+
+/*
+* Releases an image returned by daemon_acquire_image.
+*/
+static void daemon_release_image(DaemonServer *srv, int slot, PredecodeImage *image) {
+    if (slot == DAEMON_UNCACHED) {
+        predecode_release(image);
+        return;
+    }
+    pthread_mutex_lock(&srv->lock);
+    srv->images[slot].refs--;
+    pthread_mutex_unlock(&srv->lock);
+}
+
+/*
+* Sends the whole buffer. Returns 0 on success, -1 if the client has gone away.
+*/
+static int daemon_send(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/*
+* Answers a request with an error and counts it.
+*/
+static int daemon_send_error(DaemonClient *client, const char *message) {
+    char response[512];
+    int len = snprintf(response, sizeof(response), "{\"status\": \"error\", \"error\": \"");
+    for (const char *p = message; *p && len < (int)sizeof(response) - 8; p++) {
+        if (*p == '"' || *p == '\\') response[len++] = '\\';
+        response[len++] = (*p >= 0x20) ? *p : ' ';
+    }
+    len += snprintf(response + len, sizeof(response) - (size_t)len, "\"}\n");
+
+    pthread_mutex_lock(&client->server->lock);
+    client->server->errors++;
+    pthread_mutex_unlock(&client->server->lock);
+    return daemon_send(client->fd, response, (size_t)len);
+}
+
+/*
+* Refills the receive buffer. Returns the number of new bytes, 0 at end of stream, -1 on error.
+*/
+static ssize_t daemon_fill(DaemonClient *client) {
+    if (client->pos > 0) {
+        memmove(client->buf, client->buf + client->pos, client->len - client->pos);
+        client->len -= client->pos;
+        client->pos = 0;
+    }
+    if (client->len == sizeof(client->buf)) return -1;
+    ssize_t n;
+    do {
+        n = recv(client->fd, client->buf + client->len, sizeof(client->buf) - client->len, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n > 0) client->len += (size_t)n;
+    return n;
+}
+
+/*
+* Reads the next request line (without the newline, NUL-terminated) into line.
+* Returns 0 on success, -1 at end of stream, on errors or for an overlong line.
+*/
+static int daemon_read_line(DaemonClient *client, char *line) {
+    while (1) {
+        char *start = client->buf + client->pos;
+        char *newline = memchr(start, '\n', client->len - client->pos);
+        if (newline) {
+            size_t n = (size_t)(newline - start);
+            if (n > 0 && start[n - 1] == '\r') n--;
+            memcpy(line, start, n);
+            line[n] = '\0';
+            client->pos += (size_t)(newline - start) + 1;
+            return 0;
+        }
+        if (daemon_fill(client) <= 0) return -1;
+    }
+}
+
+/*
+* Reads exactly size bytes of request payload into dst. Returns 0 on success, -1 otherwise.
+*/
+static int daemon_read_bytes(DaemonClient *client, char *dst, size_t size) {
+    size_t buffered = client->len - client->pos;
+    size_t n = buffered < size ? buffered : size;
+    memcpy(dst, client->buf + client->pos, n);
+    client->pos += n;
+    while (n < size) {
+        ssize_t got;
+        do {
+            got = recv(client->fd, dst + n, size - n, 0);
+        } while (got < 0 && errno == EINTR);
+        if (got <= 0) return -1;
+        n += (size_t)got;
+    }
+    return 0;
+}
+
+/*
+* Reads an image file named in a request (NUL-terminated, caller frees).
+* Returns NULL and sets errno on failure.
+*/
+static char *daemon_read_file(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+    char *buf = malloc(DAEMON_MAX_IMAGE_BYTES + 1);
+    size_t n = buf ? fread(buf, 1, DAEMON_MAX_IMAGE_BYTES + 1, file) : 0;
+    int failed = !buf || ferror(file) || n > DAEMON_MAX_IMAGE_BYTES;
+    fclose(file);
+    if (failed) {
+        free(buf);
+        errno = buf ? EFBIG : ENOMEM;
+        return NULL;
+    }
+    buf[n] = '\0';
+    *size = n;
+    return buf;
+}
+
+/*
+* Parses a numeric request option. Returns 0 on success, -1 if it is not a number.
+*/
+static int daemon_parse_u64(const char *value, uint64_t *result) {
+    char *end;
+    if (*value == '-') return -1;
+    *result = strtoull(value, &end, 0);
+    return (end == value || *end != '\0') ? -1 : 0;
+}
+
+/*
+* Handles "RUN <mode> [options]". Returns 0 to keep the connection, -1 to close it (the
+* request's payload could not be read).
+*/
+static int daemon_handle_run(DaemonClient *client, char *args) {
+    DaemonServer *srv = client->server;
+    DaemonJob job;
+    memset(&job, 0, sizeof(job));
+    job.server = srv;
+    watchdog_config_default(&job.watchdog);
+    job.watchdog.max_instructions = DAEMON_MAX_INSTRUCTIONS;
+
+    char *save = NULL;
+    char *mode = strtok_r(args, " ", &save);
+    int valid_mode = 0;
+    for (int m = 0; mode && m < 3; m++) {
+        if (strcmp(mode, daemon_mode_names[m]) == 0) {
+            job.mode = (MipsLiteMode)m;
+            valid_mode = 1;
+        }
+    }
+
+    const char *path = NULL;
+    uint64_t bytes = 0;
+    int have_bytes = 0;
+    const char *bad = NULL;
+    char *token;
+    while (!path && (token = strtok_r(NULL, " ", &save)) != NULL) {
+        uint64_t value;
+        if (strncmp(token, "path=", 5) == 0) {
+            // The rest of the line, spaces included
+            if (*save) token[strlen(token)] = ' ';
+            path = token + 5;
+        } else if (strncmp(token, "bytes=", 6) == 0) {
+            if (daemon_parse_u64(token + 6, &bytes) < 0 || bytes > DAEMON_MAX_IMAGE_BYTES) {
+                daemon_send_error(client, "invalid bytes= (payload not read, closing)");
+                return -1;
+            }
+            have_bytes = 1;
+        } else if (strncmp(token, "max_cycles=", 11) == 0 && daemon_parse_u64(token + 11, &value) == 0) {
+            job.watchdog.max_cycles = value ? value : WATCHDOG_UNLIMITED;
+        } else if (strncmp(token, "max_instructions=", 17) == 0 && daemon_parse_u64(token + 17, &value) == 0) {
+            job.watchdog.max_instructions = value;
+        } else if (strcmp(token, "livelock=0") == 0 || strcmp(token, "livelock=1") == 0) {
+            job.watchdog.detect_livelock = token[9] == '1';
+        } else if (!bad) {
+            bad = token;
+        }
+    }
+
+    // Read the payload first, so that an invalid request does not desynchronize the stream
+    char *text = NULL;
+    size_t size = 0;
+    if (have_bytes) {
+        text = malloc((size_t)bytes + 1);
+        if (!text || daemon_read_bytes(client, text, (size_t)bytes) < 0) {
+            free(text);
+            return -1;
+        }
+        text[bytes] = '\0';
+        size = (size_t)bytes;
+    }
+
+    char message[DAEMON_MAX_LINE + 64];
+    if (!valid_mode) {
+        snprintf(message, sizeof(message), "invalid mode '%s' (FS, NF or WF)", mode ? mode : "");
+    } else if (bad) {
+        snprintf(message, sizeof(message), "invalid option '%s'", bad);
+    } else if (have_bytes == !!path) {
+        snprintf(message, sizeof(message), "exactly one of path= and bytes= is required");
+    } else if (path && !(text = daemon_read_file(path, &size))) {
+        snprintf(message, sizeof(message), "cannot read '%s': %s", path, strerror(errno));
+    } else {
+        message[0] = '\0';
+    }
+    if (message[0]) {
+        free(text);
+        return daemon_send_error(client, message);
+    }
+
+    PredecodeImage *image;
+    int cached;
+    int slot = daemon_acquire_image(srv, text, size, &image, &cached);
+    free(text);
+    if (slot == -2) return daemon_send_error(client, "invalid memory image");
+
+    job.file = image->file;
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.cond, NULL);
+    if (thread_pool_submit(srv->pool, daemon_run_job, &job) < 0) {
+        daemon_release_image(srv, slot, image);
+        pthread_mutex_destroy(&job.lock);
+        pthread_cond_destroy(&job.cond);
+        return daemon_send_error(client, "cannot queue the request");
+    }
+    pthread_mutex_lock(&job.lock);
+    while (!job.done) {
+        pthread_cond_wait(&job.cond, &job.lock);
+    }
+    pthread_mutex_unlock(&job.lock);
+    pthread_mutex_destroy(&job.lock);
+    pthread_cond_destroy(&job.cond);
+    daemon_release_image(srv, slot, image);
+
+    const char *status = "ok";
+    if (job.stop == WATCHDOG_LIVELOCK) {
+        status = "livelock";
+    } else if (job.stop != WATCHDOG_RUNNING) {
+        status = "limit";
+    }
+    char response[1024];
+    int len = snprintf(response, sizeof(response),
+                       "{\"status\": \"%s\", \"mode\": \"%s\", \"worker\": %d, \"cached\": %d, \"time_us\": %" PRIu64
+                       ", \"instructions\": %" PRIu64 ", \"arithmetic\": %" PRIu64 ", \"logical\": %" PRIu64
+                       ", \"memory_access\": %" PRIu64 ", \"control_transfer\": %" PRIu64
+                       ", \"clock_cycles\": %" PRIu64 ", \"stalls\": %" PRIu64 ", \"flushes\": %" PRIu64
+                       ", \"pc\": %u, \"state_hash\": \"%016" PRIx64 "\"",
+                       status, daemon_mode_names[job.mode], job.worker, cached, job.time_ns / 1000,
+                       job.stats.total_instructions, job.stats.arithmetic_instructions, job.stats.logical_instructions,
+                       job.stats.memory_access_instructions, job.stats.control_transfer_instructions,
+                       job.stats.clock_cycles, job.stats.total_stalls, job.stats.total_flushes,
+                       job.pc, job.state_hash);
+    if (job.stop == WATCHDOG_LIVELOCK) {
+        len += snprintf(response + len, sizeof(response) - (size_t)len, ", \"loop_lo\": %u, \"loop_hi\": %u",
+                        job.loop_lo, job.loop_hi);
+    }
+    len += snprintf(response + len, sizeof(response) - (size_t)len, "}\n");
+    return daemon_send(client->fd, response, (size_t)len);
+}
+
+/*
+* Stops accepting connections; the accept loop then shuts the daemon down.
+*/
+static void daemon_request_stop(DaemonServer *srv) {
+    pthread_mutex_lock(&srv->lock);
+    if (!srv->stopping) {
+        srv->stopping = 1;
+        shutdown(srv->listen_fd, SHUT_RDWR); // Wakes up accept()
+    }
+    pthread_mutex_unlock(&srv->lock);
+}
+
+/*
+* Connection thread: serves the client's requests until it disconnects.
+*/
+static void *daemon_client_main(void *arg) {
+    DaemonClient *client = arg;
+    DaemonServer *srv = client->server;
+    char line[DAEMON_MAX_LINE];
+
+    while (daemon_read_line(client, line) == 0) {
+        int result;
+        if (strncmp(line, "RUN ", 4) == 0) {
+            result = daemon_handle_run(client, line + 4);
+        } else if (strcmp(line, "PING") == 0) {
+            result = daemon_send(client->fd, "{\"status\": \"ok\"}\n", 17);
+        } else if (strcmp(line, "STATS") == 0) {
+            char response[512];
+            int cached = 0;
+            pthread_mutex_lock(&srv->lock);
+            for (int i = 0; i < srv->num_images; i++) {
+                if (srv->images[i].image) cached++;
+            }
+            int len = snprintf(response, sizeof(response),
+                               "{\"status\": \"ok\", \"workers\": %d, \"clients\": %d, \"requests\": %" PRIu64
+                               ", \"errors\": %" PRIu64 ", \"images\": %d, \"image_hits\": %" PRIu64
+                               ", \"image_misses\": %" PRIu64 "}\n",
+                               srv->num_workers, srv->num_clients, srv->requests, srv->errors, cached,
+                               srv->image_hits, srv->image_misses);
+            pthread_mutex_unlock(&srv->lock);
+            result = daemon_send(client->fd, response, (size_t)len);
+        } else if (strcmp(line, "SHUTDOWN") == 0) {
+            result = daemon_send(client->fd, "{\"status\": \"ok\"}\n", 17);
+            daemon_request_stop(srv);
+        } else if (line[0] == '\0') {
+            result = 0;
+        } else {
+            result = daemon_send_error(client, "unknown request (RUN, PING, STATS or SHUTDOWN)");
+        }
+        if (result < 0) break;
+    }
+
+    pthread_mutex_lock(&srv->lock);
+    srv->clients[client->slot] = -1;
+    if (--srv->num_clients == 0) pthread_cond_broadcast(&srv->clients_done);
+    pthread_mutex_unlock(&srv->lock);
+    close(client->fd);
+    free(client);
+    return NULL;
+}
+
+/*
+* Creates the listening socket. A stale socket file left by a daemon that did not exit
+* cleanly is replaced; a live one is an error.
+* Returns the socket, or -1 on error.
+*/
+static int daemon_listen(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path '%s' is too long\n", path);
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        int live = probe >= 0 && S_ISSOCK(st.st_mode) && connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+        if (probe >= 0) close(probe);
+        if (live || !S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "Error: '%s' exists%s\n", path, live ? " (a daemon is already listening)" : "");
+            return -1;
+        }
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("Error creating socket");
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 64) < 0) {
+        perror("Error binding socket");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+* Prints the daemon's usage.
+*/
+static void daemon_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --daemon <socket> [options]\n", prog);
+    fprintf(stderr, "Requests (one per line, one JSON line per answer):\n");
+    fprintf(stderr, "  RUN <FS|NF|WF> [max_cycles=<n>] [max_instructions=<n>] [livelock=0|1] path=<file>\n");
+    fprintf(stderr, "  RUN <FS|NF|WF> [...] bytes=<n>  followed by n bytes of image text\n");
+    fprintf(stderr, "  PING | STATS | SHUTDOWN\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --jobs=<n>            Worker threads (default: online cores)\n");
+    fprintf(stderr, "  --images=<n>          Predecoded images kept by content hash (default %d)\n", DAEMON_DEFAULT_IMAGES);
+}
+
+/*
+* Entry point for "<prog> --daemon <socket> [options]" (argv[0] is "--daemon").
+* Serves requests until SHUTDOWN, SIGINT or SIGTERM.
+* Returns 0 on a clean shutdown, 2 on usage or socket errors.
+*/
+int daemon_main(int argc, char *argv[]) {
+    const char *prog = "simulator";
+    if (argc < 2) {
+        daemon_usage(prog);
+        return 2;
+    }
+    const char *socket_path = argv[1];
+    int threads = thread_pool_default_size();
+    int num_images = DAEMON_DEFAULT_IMAGES;
+
+    for (int i = 2; i < argc; i++) {
+        char *end;
+        if (strncmp(argv[i], "--jobs=", 7) == 0) {
+            threads = (int)strtol(argv[i] + 7, &end, 10);
+            if (*end != '\0' || threads < 1) {
+                fprintf(stderr, "Error: Invalid thread count '%s'\n", argv[i] + 7);
+                return 2;
+            }
+        } else if (strncmp(argv[i], "--images=", 9) == 0) {
+            num_images = (int)strtol(argv[i] + 9, &end, 10);
+            if (*end != '\0' || num_images < 0) {
+                fprintf(stderr, "Error: Invalid image count '%s'\n", argv[i] + 9);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            daemon_usage(prog);
+            return 2;
+        }
+    }
+
+    DaemonServer *srv = calloc(1, sizeof(DaemonServer));
+    if (!srv) {
+        fprintf(stderr, "Error: Out of memory starting the daemon\n");
+        return 2;
+    }
+    srv->num_workers = threads;
+    srv->num_images = num_images;
+    srv->contexts = calloc((size_t)threads, sizeof(SimContext *));
+    srv->images = calloc((size_t)(num_images > 0 ? num_images : 1), sizeof(DaemonImage));
+    pthread_mutex_init(&srv->lock, NULL);
+    pthread_cond_init(&srv->clients_done, NULL);
+    for (int i = 0; i < DAEMON_MAX_CLIENTS; i++) {
+        srv->clients[i] = -1;
+    }
+    int ok = srv->contexts && srv->images;
+    for (int i = 0; ok && i < threads; i++) {
+        srv->contexts[i] = sim_context_create();
+        if (!srv->contexts[i]) ok = 0;
+    }
+
+    // Only the accept loop takes SIGINT/SIGTERM (while it waits): the workers and connection
+    // threads inherit the blocked mask
+    sigset_t stop_signals, old_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+    if (ok) {
+        srv->pool = thread_pool_create(threads);
+        ok = srv->pool != NULL;
+    }
+    srv->listen_fd = ok ? daemon_listen(socket_path) : -1;
+
+    int status = 0;
+    if (srv->listen_fd < 0) {
+        if (!ok) fprintf(stderr, "Error: Cannot start %d workers\n", threads);
+        status = 2;
+    } else {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = daemon_signal_handler;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+        fprintf(stderr, "Daemon listening on %s (%d workers, %d cached images)\n", socket_path, threads, num_images);
+
+        while (!daemon_stop_requested) {
+            // The signals are only unblocked inside ppoll(), so none can slip in before the wait
+            struct pollfd pfd = { srv->listen_fd, POLLIN, 0 };
+            int ready = ppoll(&pfd, 1, NULL, &old_mask);
+            pthread_mutex_lock(&srv->lock);
+            int stopping = srv->stopping;
+            pthread_mutex_unlock(&srv->lock);
+            if (stopping || daemon_stop_requested) break;
+            if (ready <= 0) continue;
+
+            int fd = accept(srv->listen_fd, NULL, NULL);
+            if (fd < 0) {
+                if (errno != EINTR && errno != ECONNABORTED && errno != EAGAIN) perror("Error accepting connection");
+                continue;
+            }
+
+            DaemonClient *client = calloc(1, sizeof(DaemonClient));
+            pthread_mutex_lock(&srv->lock);
+            int slot = -1;
+            for (int i = 0; client && !stopping && i < DAEMON_MAX_CLIENTS; i++) {
+                if (srv->clients[i] < 0) {
+                    slot = i;
+                    break;
+                }
+            }
+            if (slot >= 0) {
+                srv->clients[slot] = fd;
+                srv->num_clients++;
+            }
+            pthread_mutex_unlock(&srv->lock);
+
+            pthread_t thread;
+            if (slot >= 0) {
+                client->server = srv;
+                client->fd = fd;
+                client->slot = slot;
+                if (pthread_create(&thread, NULL, daemon_client_main, client) == 0) {
+                    pthread_detach(thread);
+                    continue;
+                }
+                pthread_mutex_lock(&srv->lock);
+                srv->clients[slot] = -1;
+                srv->num_clients--;
+                pthread_mutex_unlock(&srv->lock);
+            }
+            const char *busy = "{\"status\": \"error\", \"error\": \"too many clients\"}\n";
+            daemon_send(fd, busy, strlen(busy));
+            close(fd);
+            free(client);
+        }
+
+        // Let every connection finish its current request, then stop
+        pthread_mutex_lock(&srv->lock);
+        srv->stopping = 1;
+        for (int i = 0; i < DAEMON_MAX_CLIENTS; i++) {
+            if (srv->clients[i] >= 0) shutdown(srv->clients[i], SHUT_RD);
+        }
+        while (srv->num_clients > 0) {
+            pthread_cond_wait(&srv->clients_done, &srv->lock);
+        }
+        pthread_mutex_unlock(&srv->lock);
+        fprintf(stderr, "Daemon stopped after %" PRIu64 " requests (%" PRIu64 " image hits, %" PRIu64 " misses)\n",
+                srv->requests, srv->image_hits, srv->image_misses);
+        close(srv->listen_fd);
+        unlink(socket_path);
+    }
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+
+    thread_pool_destroy(srv->pool);
+    for (int i = 0; srv->contexts && i < threads; i++) {
+        sim_context_destroy(srv->contexts[i]);
+    }
+    for (int i = 0; srv->images && i < num_images; i++) {
+        predecode_release(srv->images[i].image);
+    }
+    pthread_mutex_destroy(&srv->lock);
+    pthread_cond_destroy(&srv->clients_done);
+    free(srv->contexts);
+    free(srv->images);
+    free(srv);
+    return status;
+}
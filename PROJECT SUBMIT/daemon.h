@@ -0,0 +1,39 @@
+/*
+* Simulation Daemon Header File
+* This header file declares the daemon mode: a long-running simulator process that serves
+* simulation requests over a Unix domain socket, so small jobs do not pay for process
+* startup, image loading and predecoding on every run.
+*/
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "predecode.h"
+#include "watchdog.h"
+
+#define DAEMON_MAX_CLIENTS 256                // Connections served at the same time
+#define DAEMON_MAX_LINE 4608                  // Longest request line (a path may take 4KB)
+#define DAEMON_MAX_IMAGE_BYTES (1024 * 1024)  // Largest image text accepted with bytes=<n>
+#define DAEMON_DEFAULT_IMAGES 64              // Predecoded images kept by content hash
+#define DAEMON_MAX_INSTRUCTIONS 10000000ULL   // Default instruction budget of a request
+
+/*
+* DaemonImage structure:
+* One predecoded image in the daemon's image cache, keyed by the hash and size of its text.
+*/
+typedef struct {
+    uint64_t hash;
+    size_t size;
+    PredecodeImage *image;  // NULL for a free slot
+    int refs;               // Requests currently using the image (not evicted while > 0)
+    uint64_t last_used;     // Request number of the last use (LRU eviction)
+} DaemonImage;
+
+// Entry point for "<prog> --daemon <socket> [options]"; returns 0 after a SHUTDOWN request
+// or SIGINT/SIGTERM, 2 on usage or socket errors
+int daemon_main(int argc, char *argv[]);
+
+#endif // DAEMON_H
@@ -0,0 +1,292 @@
+/*
+* Dataflow Limit Analysis
+* This file implements "--ilp <image>". Each committed instruction of a functional run
+* starts as soon as its inputs are ready, with unlimited functional units, and completes
+* its class latency later:
+* - Register inputs come from the last writer of rs/rt (renaming is assumed, so only true
+*   dependences count).
+* - A load also waits for the last store to the same word.
+* - Without branch prediction, no instruction starts before the previous branch has
+*   completed; with perfect prediction, branches only order the instructions that use
+*   their inputs.
+* - With a reorder window of N instructions, an instruction cannot start before the one
+*   N older has retired (in order).
+* The critical path is the latest completion cycle, and the ILP is instructions per cycle
+* of critical path. The NF and WF trace-driven models run on the same commit stream for
+* the cycle counts of the real pipelines.
+*
+* Supported Operations:
+* - Latencies per class (--latency=alu:1,mul:1,ldw:2,stw:1,branch:1)
+* - Unlimited and windowed schedules (--window=4,16,64), each with and without prediction
+* - Comparison with the NF and WF cycle counts
+*
+* Functions:
+* - dataflow_main: Parses options, runs the analysis and prints the report.
+*/
+
+#include "dataflow.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "commit_trace.h"
+#include "instruction_decoder.h" // For opcodes and instruction types
+#include "sim_context.h"
+#include "timing_model.h"
+
+static const char *dataflow_class_names[DATAFLOW_NUM_CLASSES] = { "alu", "mul", "ldw", "stw", "branch" };
+
+/*
+* Returns the latency class of an instruction.
+*/
+static int dataflow_class(Opcode op) {
+    switch (op) {
+        case MUL: case MULI: return DATAFLOW_MUL;
+        case LDW: return DATAFLOW_LDW;
+        case STW: return DATAFLOW_STW;
+        case BZ: case BEQ: case JR: case HALT: return DATAFLOW_BRANCH;
+        default: return DATAFLOW_ALU;
+    }
+}
+
+/*
+* Returns the larger of two cycle numbers.
+*/
+static uint64_t max_cycle(uint64_t a, uint64_t b) {
+    return a > b ? a : b;
+}
+
+/*
+* Prepares a schedule. Returns 0 on success, -1 if the window cannot be allocated.
+*/
+static int schedule_init(DataflowSchedule *ds, int window, int perfect) {
+    memset(ds, 0, sizeof(DataflowSchedule));
+    ds->window = window;
+    ds->perfect = perfect;
+    if (window > 0) {
+        ds->retired = calloc((size_t)window, sizeof(uint64_t));
+        if (!ds->retired) return -1;
+    }
+    return 0;
+}
+
+/*
+* Schedules the next committed instruction (records must be given in commit order).
+*/
+static void schedule_commit(DataflowSchedule *ds, const CommitRecord *rec, const int *latency) {
+    Opcode op = (Opcode)rec->opcode;
+    int cls = dataflow_class(op);
+    uint32_t word = (rec->mem_addr / 4) % MAX_MEMORY_LINES;
+
+    // Earliest start: inputs (same operand rules as the pipelines), control and window
+    uint64_t start = 0;
+    if (op != HALT && op != NOP) {
+        if (rec->rs != 0) start = max_cycle(start, ds->reg_ready[rec->rs]);
+        if ((rec->type == R_TYPE || op == BEQ || op == STW) && rec->rt != 0) {
+            start = max_cycle(start, ds->reg_ready[rec->rt]);
+        }
+    }
+    if (op == LDW) start = max_cycle(start, ds->mem_ready[word]);
+    if (!ds->perfect) start = max_cycle(start, ds->branch_ready);
+    size_t slot = 0;
+    if (ds->window > 0) {
+        slot = (size_t)(ds->instructions % (uint64_t)ds->window);
+        if (ds->instructions >= (uint64_t)ds->window) start = max_cycle(start, ds->retired[slot]);
+    }
+    uint64_t complete = start + (uint64_t)latency[cls];
+
+    // Outputs
+    int dest = -1;
+    if (rec->type == R_TYPE) {
+        dest = rec->rd;
+    } else if (op == ADDI || op == SUBI || op == MULI || op == ORI || op == ANDI || op == XORI || op == LDW) {
+        dest = rec->rt;
+    }
+    if (dest > 0) ds->reg_ready[dest] = complete;
+    if (op == STW) ds->mem_ready[word] = complete;
+    if (cls == DATAFLOW_BRANCH) ds->branch_ready = complete;
+
+    ds->last_retire = max_cycle(ds->last_retire, complete);
+    if (ds->window > 0) ds->retired[slot] = ds->last_retire;
+    ds->critical_path = max_cycle(ds->critical_path, complete);
+    ds->instructions++;
+}
+
+/*
+* Parses "<class>:<cycles>,..." into the latency table.
+* Returns 0 on success, -1 (with a message) if malformed.
+*/
+static int parse_latencies(const char *arg, int *latency) {
+    char list[256];
+    snprintf(list, sizeof(list), "%s", arg);
+    char *save = NULL;
+    for (char *tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        char *colon = strchr(tok, ':');
+        int cls = -1;
+        for (int c = 0; colon && c < DATAFLOW_NUM_CLASSES; c++) {
+            if (strlen(dataflow_class_names[c]) == (size_t)(colon - tok) &&
+                strncmp(tok, dataflow_class_names[c], (size_t)(colon - tok)) == 0) {
+                cls = c;
+            }
+        }
+        char *end = NULL;
+        long cycles = colon ? strtol(colon + 1, &end, 10) : 0;
+        if (cls < 0 || end == colon + 1 || *end != '\0' || cycles < 1 || cycles > 1000) {
+            fprintf(stderr, "Error: Invalid latency '%s' (expected <alu|mul|ldw|stw|branch>:<cycles>)\n", tok);
+            return -1;
+        }
+        latency[cls] = (int)cycles;
+    }
+    return 0;
+}
+
+/*
+* Parses "<n>,<n>,..." into the window sizes.
+* Returns the number of windows, or -1 (with a message) if malformed.
+*/
+static int parse_windows(const char *arg, int *windows) {
+    char list[256];
+    snprintf(list, sizeof(list), "%s", arg);
+    char *save = NULL;
+    int count = 0;
+    for (char *tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        char *end;
+        long n = strtol(tok, &end, 10);
+        if (end == tok || *end != '\0' || n < 1 || n > DATAFLOW_MAX_WINDOW || count == DATAFLOW_MAX_WINDOWS) {
+            fprintf(stderr, "Error: Invalid window '%s' (1..%d, at most %d windows)\n", tok, DATAFLOW_MAX_WINDOW,
+                    DATAFLOW_MAX_WINDOWS);
+            return -1;
+        }
+        windows[count++] = (int)n;
+    }
+    return count;
+}
+
+/*
+* Prints the command line usage of the analysis.
+*/
+static void print_ilp_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --ilp <memory_image_file> [options]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --latency=<class>:<n>,... Latencies of alu, mul, ldw, stw and branch (default 1, ldw 2)\n");
+    fprintf(stderr, "  --window=<n>,...          Reorder window sizes (default 4,8,16,32,64; at most %d)\n",
+            DATAFLOW_MAX_WINDOWS);
+    fprintf(stderr, "  --max-instructions=<n>    Functional run limit (default %llu)\n",
+            (unsigned long long)DATAFLOW_DEFAULT_MAX_INSTRUCTIONS);
+}
+
+/*
+* Prints one row of the limits table.
+*/
+static void print_limit_row(const char *label, const DataflowSchedule *barrier, const DataflowSchedule *perfect) {
+    uint64_t n = perfect->instructions;
+    printf("  %-10s %12llu %8.3f %14llu %8.3f\n", label, (unsigned long long)barrier->critical_path,
+           barrier->critical_path ? (double)n / (double)barrier->critical_path : 0.0,
+           (unsigned long long)perfect->critical_path,
+           perfect->critical_path ? (double)n / (double)perfect->critical_path : 0.0);
+}
+
+/*
+* Entry point for the dataflow limit analysis.
+* argv[0] is "--ilp" and argv[1] the memory image.
+* Returns 0 on success, 2 on usage, I/O or allocation errors.
+*/
+int dataflow_main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_ilp_usage("simulator");
+        return 2;
+    }
+
+    const char *image_file = argv[1];
+    int latency[DATAFLOW_NUM_CLASSES] = { 1, 1, 2, 1, 1 }; // A load feeds a dependent one cycle late, as in WF
+    int windows[DATAFLOW_MAX_WINDOWS] = { 4, 8, 16, 32, 64 };
+    int window_count = 5;
+    uint64_t max_instructions = DATAFLOW_DEFAULT_MAX_INSTRUCTIONS;
+    for (int i = 2; i < argc; i++) {
+        if (strncmp(argv[i], "--latency=", 10) == 0) {
+            if (parse_latencies(argv[i] + 10, latency) < 0) return 2;
+        } else if (strncmp(argv[i], "--window=", 9) == 0) {
+            window_count = parse_windows(argv[i] + 9, windows);
+            if (window_count < 0) return 2;
+        } else if (strncmp(argv[i], "--max-instructions=", 19) == 0) {
+            char *end;
+            max_instructions = strtoull(argv[i] + 19, &end, 0);
+            if (end == argv[i] + 19 || *end != '\0' || max_instructions == 0) {
+                fprintf(stderr, "Error: Invalid value '%s'\n", argv[i] + 19);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            print_ilp_usage("simulator");
+            return 2;
+        }
+    }
+
+    // Schedules [0] and [1] are unlimited, then one pair per window: barriers, perfect prediction
+    int schedule_count = 2 * (window_count + 1);
+    DataflowSchedule *schedules = calloc((size_t)schedule_count, sizeof(DataflowSchedule));
+    SimContext *ctx = sim_context_create();
+    int failed = !schedules || !ctx;
+    for (int s = 0; s < schedule_count && !failed; s++) {
+        failed = schedule_init(&schedules[s], s < 2 ? 0 : windows[s / 2 - 1], s % 2) < 0;
+    }
+    if (failed) {
+        perror("Error allocating dataflow analysis");
+    } else if (read_memory_image(image_file, ctx->state.memory) < 0) {
+        fprintf(stderr, "Error: Failed to load memory image from file '%s'\n", image_file);
+        failed = 1;
+    }
+    if (failed) {
+        for (int s = 0; schedules && s < schedule_count; s++) free(schedules[s].retired);
+        free(schedules);
+        sim_context_destroy(ctx);
+        return 2;
+    }
+
+    // The real pipelines time the same commit stream
+    TimingModel nf, wf;
+    PipelineConfig cfg;
+    pipeline_config_preset(&cfg, 0);
+    timing_model_init(&nf, &cfg);
+    pipeline_config_preset(&cfg, 1);
+    timing_model_init(&wf, &cfg);
+
+    CommitRecord rec;
+    uint64_t instructions = 0;
+    while (instructions < max_instructions && commit_trace_step(ctx, &rec, NULL)) {
+        for (int s = 0; s < schedule_count; s++) schedule_commit(&schedules[s], &rec, latency);
+        timing_model_commit(&nf, &rec);
+        timing_model_commit(&wf, &rec);
+        instructions++;
+    }
+
+    printf("Dataflow limits: %llu instructions%s (latencies", (unsigned long long)instructions,
+           ctx->halted ? "" : ", stopped at the instruction limit");
+    for (int c = 0; c < DATAFLOW_NUM_CLASSES; c++) printf(" %s %d", dataflow_class_names[c], latency[c]);
+    printf(")\n");
+    printf("  %-10s %21s %23s\n", "Window", "Branch barriers", "Perfect prediction");
+    printf("  %-10s %12s %8s %14s %8s\n", "", "Cycles", "ILP", "Cycles", "ILP");
+    print_limit_row("Unlimited", &schedules[0], &schedules[1]);
+    for (int w = 0; w < window_count; w++) {
+        char label[16];
+        snprintf(label, sizeof(label), "%d", windows[w]);
+        print_limit_row(label, &schedules[2 * (w + 1)], &schedules[2 * (w + 1) + 1]);
+    }
+
+    uint64_t critical = schedules[1].critical_path; // Unlimited window, perfect prediction
+    printf("Pipelines (single issue; cycles include the pipeline fill):\n");
+    printf("  NF %12llu cycles, IPC %.3f, %.2f times the critical path\n", (unsigned long long)nf.cycles,
+           nf.cycles ? (double)instructions / (double)nf.cycles : 0.0,
+           critical ? (double)nf.cycles / (double)critical : 0.0);
+    printf("  WF %12llu cycles, IPC %.3f, %.2f times the critical path\n", (unsigned long long)wf.cycles,
+           wf.cycles ? (double)instructions / (double)wf.cycles : 0.0,
+           critical ? (double)wf.cycles / (double)critical : 0.0);
+
+    timing_model_free(&nf);
+    timing_model_free(&wf);
+    for (int s = 0; s < schedule_count; s++) free(schedules[s].retired);
+    free(schedules);
+    sim_context_destroy(ctx);
+    return 0;
+}
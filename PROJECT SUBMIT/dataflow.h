@@ -0,0 +1,52 @@
+/*
+* Dataflow Limit Analysis Header File
+* This header file declares the dataflow limit analysis: the commit stream of a functional
+* run is scheduled as a dynamic dependence graph (true register and memory dependences,
+* configurable operation latencies) with unlimited execution resources. The critical path
+* length and the available ILP are reported with every branch as a barrier and with
+* perfect branch prediction, unbounded and for reorder windows of N instructions, next to
+* the cycle counts of the NF and WF pipelines.
+*/
+
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+#include <stdint.h>
+#include "trace_reader.h" // For MAX_MEMORY_LINES
+
+#define DATAFLOW_MAX_WINDOWS 8                        // Window sizes analyzed in one run
+#define DATAFLOW_MAX_WINDOW 65536                     // Largest reorder window
+#define DATAFLOW_DEFAULT_MAX_INSTRUCTIONS 100000000ULL // Functional run limit
+
+// Operation classes with their own latency
+typedef enum {
+    DATAFLOW_ALU,    // Arithmetic and logical instructions
+    DATAFLOW_MUL,    // MUL and MULI
+    DATAFLOW_LDW,    // Loads
+    DATAFLOW_STW,    // Stores
+    DATAFLOW_BRANCH, // BZ, BEQ, JR (and HALT)
+    DATAFLOW_NUM_CLASSES
+} DataflowClass;
+
+/*
+* DataflowSchedule structure:
+* One schedule of the commit stream: the completion cycle of the last writer of every
+* register and memory word, and for windowed schedules the in-order retire cycles of the
+* last "window" instructions.
+*/
+typedef struct {
+    int window;           // Reorder window in instructions (0 = unlimited)
+    int perfect;          // 1 = perfect branch prediction, 0 = every branch is a barrier
+    uint64_t reg_ready[32];
+    uint64_t mem_ready[MAX_MEMORY_LINES];
+    uint64_t branch_ready; // Completion of the last branch (barrier for later instructions)
+    uint64_t *retired;     // Ring of retire cycles (window entries), NULL when unlimited
+    uint64_t last_retire;
+    uint64_t instructions;
+    uint64_t critical_path; // Latest completion cycle so far
+} DataflowSchedule;
+
+// Entry point for "<prog> --ilp <image> [options]"; returns 0 on success, 2 on errors
+int dataflow_main(int argc, char *argv[]);
+
+#endif // DATAFLOW_H
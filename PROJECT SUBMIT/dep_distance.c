@@ -0,0 +1,289 @@
+/*
+* Dependency Distance Analyzer
+* This file implements "--deps <image>". A functional run records, for every committed
+* instruction, the distance in committed instructions to the last writer of each source
+* register (1 = the previous instruction) and the class of that writer. The histograms
+* give the stalls of an in-order pipeline directly: a consumer at distance d of a
+* producer whose value reaches EX r instructions later waits max(0, r - d) cycles, and an
+* instruction waits for the worse of its two sources.
+*
+* The estimates count every dependence as if nothing else had stalled (a stall or a branch
+* flush between producer and consumer hides part of a later stall), and they leave out the
+* structural stalls of multi-cycle loads and multiplies. --check times the run with the
+* trace-driven model for comparison.
+*
+* Supported Operations:
+* - Source distance histograms by producer class (ALU, LDW, MUL)
+* - Stall estimates for forwarding paths, load and multiply latency, and pipeline depth
+* - Comparison with the timing model (--check)
+*
+* Functions:
+* - dep_distance_main: Parses options, runs the analysis and prints the report.
+*/
+
+#include "dep_distance.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "commit_trace.h"
+#include "instruction_decoder.h" // For opcodes and instruction types
+#include "sim_context.h"
+#include "timing_model.h"
+#include "trace_reader.h"
+
+static const char *dep_class_names[DEP_NUM_CLASSES] = { "ALU", "LDW", "MUL" };
+
+// Pipelines estimated from the histograms (NF and WF first)
+static const DepScenario dep_scenarios[] = {
+    { "NF (no forwarding)",           0, 0, 1, 1, 0 },
+    { "MEM/WB -> EX only",            0, 1, 1, 1, 0 },
+    { "EX/MEM -> EX only",            1, 0, 1, 1, 0 },
+    { "WF (both paths)",              1, 1, 1, 1, 0 },
+    { "WF, load latency 2",           1, 1, 1, 2, 0 },
+    { "WF, load latency 3",           1, 1, 1, 3, 0 },
+    { "WF, load latency 4",           1, 1, 1, 4, 0 },
+    { "WF, MUL latency 2",            1, 1, 2, 1, 0 },
+    { "WF, MUL latency 4",            1, 1, 4, 1, 0 },
+    { "NF, 6 stages (+1 after EX)",   0, 0, 1, 1, 1 },
+    { "NF, 7 stages (+2 after EX)",   0, 0, 1, 1, 2 },
+    { "WF, 6 stages (+1 after EX)",   1, 1, 1, 1, 1 },
+    { "WF, 7 stages (+2 after EX)",   1, 1, 1, 1, 2 },
+};
+#define DEP_NUM_SCENARIOS ((int)(sizeof(dep_scenarios) / sizeof(dep_scenarios[0])))
+
+/*
+* Returns the class of the value an instruction writes.
+*/
+static int producer_class(Opcode op) {
+    if (op == LDW) return DEP_LDW;
+    if (op == MUL || op == MULI) return DEP_MUL;
+    return DEP_ALU;
+}
+
+/*
+* Returns the histogram slot of a source operand's producer (0 = none).
+*/
+static int source_slot(const uint64_t *writer, const uint8_t *writer_class, uint64_t index, int reg,
+                       DepHistogram *hist) {
+    hist->sources++;
+    if (writer[reg] == 0) {
+        hist->unproduced++;
+        return 0;
+    }
+    uint64_t distance = index - writer[reg];
+    if (distance > DEP_MAX_DISTANCE) distance = DEP_MAX_DISTANCE;
+    return 1 + writer_class[reg] * DEP_MAX_DISTANCE + (int)distance - 1;
+}
+
+/*
+* Instructions after its producer at which a consumer can enter EX without waiting
+* (the same availability rules as the timing model).
+*/
+static int required_distance(const DepScenario *sc, int cls) {
+    int ex_latency = cls == DEP_MUL ? sc->mul_latency : 1;
+    int mem_latency = (cls == DEP_LDW ? sc->load_latency : 1) + sc->extra_stages;
+    if (sc->fwd_ex_ex && cls != DEP_LDW) return ex_latency;       // From EX/MEM
+    if (sc->fwd_mem_ex) return ex_latency + mem_latency;           // From MEM/WB
+    return ex_latency + mem_latency + 1;                           // From the register file after WB
+}
+
+/*
+* Returns the stall cycles a source in the given slot causes in a scenario.
+*/
+static int slot_stall(const DepScenario *sc, int slot) {
+    if (slot == 0) return 0;
+    int cls = (slot - 1) / DEP_MAX_DISTANCE;
+    int distance = (slot - 1) % DEP_MAX_DISTANCE + 1;
+    int stall = required_distance(sc, cls) - distance;
+    return stall > 0 ? stall : 0;
+}
+
+/*
+* Estimates the stalls of a scenario from the joint histogram, charging each instruction's
+* stall to the class of the source it waits on longest.
+*/
+static uint64_t estimate_stalls(const DepHistogram *hist, const DepScenario *sc, uint64_t by_class[DEP_NUM_CLASSES]) {
+    uint64_t total = 0;
+    memset(by_class, 0, DEP_NUM_CLASSES * sizeof(uint64_t));
+    for (int a = 0; a < DEP_SLOTS; a++) {
+        for (int b = 0; b < DEP_SLOTS; b++) {
+            uint64_t count = hist->joint[a][b];
+            if (!count) continue;
+            int stall_a = slot_stall(sc, a), stall_b = slot_stall(sc, b);
+            int binding = stall_a >= stall_b ? a : b;
+            int stall = stall_a >= stall_b ? stall_a : stall_b;
+            if (!stall) continue;
+            total += count * (uint64_t)stall;
+            by_class[(binding - 1) / DEP_MAX_DISTANCE] += count * (uint64_t)stall;
+        }
+    }
+    return total;
+}
+
+/*
+* Prints the command line usage of the analyzer.
+*/
+static void print_deps_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --deps <memory_image_file> [options]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --check                   Also time each configuration with the timing model\n");
+    fprintf(stderr, "  --max-instructions=<n>    Functional run limit (default %llu)\n",
+            (unsigned long long)DEP_DEFAULT_MAX_INSTRUCTIONS);
+}
+
+/*
+* Prints the distance histograms and the stall estimates.
+*/
+static void print_report(const DepHistogram *hist, const TimingModel *models, int check) {
+    uint64_t by_distance[DEP_NUM_CLASSES][DEP_MAX_DISTANCE] = {{0}};
+    for (int a = 0; a < DEP_SLOTS; a++) {
+        for (int b = 0; b < DEP_SLOTS; b++) {
+            uint64_t count = hist->joint[a][b];
+            if (a) by_distance[(a - 1) / DEP_MAX_DISTANCE][(a - 1) % DEP_MAX_DISTANCE] += count;
+            if (b) by_distance[(b - 1) / DEP_MAX_DISTANCE][(b - 1) % DEP_MAX_DISTANCE] += count;
+        }
+    }
+
+    printf("Dependency distances: %llu instructions, %llu register sources (%llu with no producer in the run)\n",
+           (unsigned long long)hist->instructions, (unsigned long long)hist->sources,
+           (unsigned long long)hist->unproduced);
+    printf("  %-10s %12s %12s %12s\n", "Distance", dep_class_names[DEP_ALU], dep_class_names[DEP_LDW],
+           dep_class_names[DEP_MUL]);
+    uint64_t totals[DEP_NUM_CLASSES] = {0};
+    for (int d = 0; d < DEP_MAX_DISTANCE; d++) {
+        char label[16];
+        snprintf(label, sizeof(label), "%d%s", d + 1, d + 1 == DEP_MAX_DISTANCE ? "+" : "");
+        printf("  %-10s", label);
+        for (int c = 0; c < DEP_NUM_CLASSES; c++) {
+            printf(" %12llu", (unsigned long long)by_distance[c][d]);
+            totals[c] += by_distance[c][d];
+        }
+        printf("\n");
+    }
+    printf("  %-10s %12llu %12llu %12llu\n", "Total", (unsigned long long)totals[DEP_ALU],
+           (unsigned long long)totals[DEP_LDW], (unsigned long long)totals[DEP_MUL]);
+
+    printf("Estimated data stall cycles (worst source per instruction, stalls assumed not to overlap):\n");
+    printf("  %-28s %10s %10s %10s %10s %8s%s\n", "Configuration", "Stalls", dep_class_names[DEP_ALU],
+           dep_class_names[DEP_LDW], dep_class_names[DEP_MUL], "Per inst", check ? "      Model" : "");
+    for (int s = 0; s < DEP_NUM_SCENARIOS; s++) {
+        uint64_t by_class[DEP_NUM_CLASSES];
+        uint64_t stalls = estimate_stalls(hist, &dep_scenarios[s], by_class);
+        printf("  %-28s %10llu %10llu %10llu %10llu %8.3f", dep_scenarios[s].name, (unsigned long long)stalls,
+               (unsigned long long)by_class[DEP_ALU], (unsigned long long)by_class[DEP_LDW],
+               (unsigned long long)by_class[DEP_MUL],
+               hist->instructions ? (double)stalls / (double)hist->instructions : 0.0);
+        if (check && dep_scenarios[s].extra_stages == 0) {
+            printf(" %10llu", (unsigned long long)models[s].stalls);
+        } else if (check) {
+            printf(" %10s", "-"); // Depth is not a timing model parameter
+        }
+        printf("\n");
+    }
+    if (check) printf("  (Model: all stalls of the trace-driven timing model, including structural ones)\n");
+}
+
+/*
+* Entry point for the dependency distance analyzer.
+* argv[0] is "--deps" and argv[1] the memory image.
+* Returns 0 on success, 2 on usage, I/O or allocation errors.
+*/
+int dep_distance_main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_deps_usage("simulator");
+        return 2;
+    }
+
+    const char *image_file = argv[1];
+    uint64_t max_instructions = DEP_DEFAULT_MAX_INSTRUCTIONS;
+    int check = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strncmp(argv[i], "--max-instructions=", 19) == 0) {
+            char *end;
+            max_instructions = strtoull(argv[i] + 19, &end, 0);
+            if (end == argv[i] + 19 || *end != '\0' || max_instructions == 0) {
+                fprintf(stderr, "Error: Invalid value '%s'\n", argv[i] + 19);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = 1;
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            print_deps_usage("simulator");
+            return 2;
+        }
+    }
+
+    SimContext *ctx = sim_context_create();
+    DepHistogram *hist = calloc(1, sizeof(DepHistogram));
+    if (!ctx || !hist) {
+        perror("Error allocating dependency analysis");
+        sim_context_destroy(ctx);
+        free(hist);
+        return 2;
+    }
+    if (read_memory_image(image_file, ctx->state.memory) < 0) {
+        fprintf(stderr, "Error: Failed to load memory image from file '%s'\n", image_file);
+        sim_context_destroy(ctx);
+        free(hist);
+        return 2;
+    }
+
+    // With --check, every configuration the timing model can express is timed alongside
+    TimingModel models[DEP_NUM_SCENARIOS];
+    if (check) {
+        for (int s = 0; s < DEP_NUM_SCENARIOS; s++) {
+            PipelineConfig cfg;
+            pipeline_config_preset(&cfg, 0);
+            cfg.fwd_ex_ex = dep_scenarios[s].fwd_ex_ex;
+            cfg.fwd_mem_ex = dep_scenarios[s].fwd_mem_ex;
+            cfg.mul_latency = dep_scenarios[s].mul_latency;
+            cfg.load_latency = dep_scenarios[s].load_latency;
+            timing_model_init(&models[s], &cfg); // Valid by construction, perfect memory allocates nothing
+        }
+    }
+
+    // Last writer of each register (1-based commit index, 0 = not written) and its class
+    uint64_t writer[32] = {0};
+    uint8_t writer_class[32] = {0};
+    CommitRecord rec;
+    while (hist->instructions < max_instructions && commit_trace_step(ctx, &rec, NULL)) {
+        uint64_t index = ++hist->instructions;
+        Opcode op = (Opcode)rec.opcode;
+
+        // Sources (same operand rules as the timing model); rt reading rs's register counts once
+        int slot_rs = 0, slot_rt = 0;
+        if (op != HALT && op != NOP) {
+            if (rec.rs != 0) slot_rs = source_slot(writer, writer_class, index, rec.rs, hist);
+            if ((rec.type == R_TYPE || op == BEQ || op == STW) && rec.rt != 0 && rec.rt != rec.rs) {
+                slot_rt = source_slot(writer, writer_class, index, rec.rt, hist);
+            }
+        }
+        hist->joint[slot_rs][slot_rt]++;
+
+        int dest = -1;
+        if (rec.type == R_TYPE) {
+            dest = rec.rd;
+        } else if (op == ADDI || op == SUBI || op == MULI || op == ORI || op == ANDI || op == XORI || op == LDW) {
+            dest = rec.rt;
+        }
+        if (dest > 0) {
+            writer[dest] = index;
+            writer_class[dest] = (uint8_t)producer_class(op);
+        }
+
+        if (check) {
+            for (int s = 0; s < DEP_NUM_SCENARIOS; s++) timing_model_commit(&models[s], &rec);
+        }
+    }
+
+    print_report(hist, models, check);
+    if (check) {
+        for (int s = 0; s < DEP_NUM_SCENARIOS; s++) timing_model_free(&models[s]);
+    }
+    sim_context_destroy(ctx);
+    free(hist);
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+* Dependency Distance Header File
+* This header file declares the dependency distance analyzer: for every committed
+* instruction it records how many instructions back the producer of each source register
+* was committed, split by producer class (ALU, LDW, MUL). From the histograms it estimates
+* the data stall cycles of other forwarding paths, pipeline depths and load latencies
+* without timing the run again.
+*/
+
+#ifndef DEP_DISTANCE_H
+#define DEP_DISTANCE_H
+
+#include <stdint.h>
+
+#define DEP_MAX_DISTANCE 8                        // Distances of 8 and more share the last bucket
+#define DEP_DEFAULT_MAX_INSTRUCTIONS 100000000ULL // Functional run limit
+
+// Producer classes (by the latency of the unit that produces the value)
+typedef enum {
+    DEP_ALU, // Single-cycle arithmetic and logical instructions
+    DEP_LDW, // Loads (value available after MEM)
+    DEP_MUL, // MUL and MULI (multi-cycle in some configurations)
+    DEP_NUM_CLASSES
+} DepClass;
+
+// Producer of one source operand: 0 = none, else 1 + class * DEP_MAX_DISTANCE + distance - 1
+#define DEP_SLOTS (1 + DEP_NUM_CLASSES * DEP_MAX_DISTANCE)
+
+/*
+* DepHistogram structure:
+* Instructions counted by the producers of both source operands (rs, then rt), so the
+* estimates can take the worse of the two for each instruction.
+*/
+typedef struct {
+    uint64_t instructions;
+    uint64_t sources;      // Register sources read (R0 excluded)
+    uint64_t unproduced;   // Sources whose register was not written earlier in the run
+    uint64_t joint[DEP_SLOTS][DEP_SLOTS];
+} DepHistogram;
+
+/*
+* DepScenario structure:
+* A pipeline whose dependence stalls are estimated (single-cycle units unless stated).
+*/
+typedef struct {
+    const char *name;
+    int fwd_ex_ex;    // EX/MEM -> EX forwarding path
+    int fwd_mem_ex;   // MEM/WB -> EX forwarding path
+    int mul_latency;  // EX cycles of MUL/MULI
+    int load_latency; // MEM cycles of LDW
+    int extra_stages; // Stages added between EX and WB (a deeper pipeline)
+} DepScenario;
+
+// Entry point for "<prog> --deps <image> [options]"; returns 0 on success, 2 on errors
+int dep_distance_main(int argc, char *argv[]);
+
+#endif // DEP_DISTANCE_H
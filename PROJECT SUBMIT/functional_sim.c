@@ -16,6 +16,8 @@
 * Functions:
 * - initialize_machine_state: Initializes the machine state
 * - simulate_instruction: Simulates a single instruction execution
+* - step_functional: Executes the next instruction
+* - run_functional_simulation: Runs the FS loop until HALT
 * - print_final_state: Prints the final state of the machine after simulation
 * - main: Main function to run the simulator based on command line arguments
 */
@@ -24,41 +26,52 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include <unistd.h> // For getpid (default live statistics paths).
 #include "instruction_decoder.h"
 #include "functional_sim.h"
 #include "trace_reader.h"
 #include "no_fwd.h" // For pipeline simulator with no forwarding call.
 #include "with_fwd.h" // For pipeline simulator with forwarding call.
-
-// Register Written Tracking and Memory Change Tracking
-int register_written[32] = {0};
-int memory_changed[1024] = {0}; // Tracks which memory addresses were modified
-
-MachineState state; // Global machine state
-
-// Define the debug flag
+#include "kanata.h" // For the pipeline viewer export options.
+#include "trace_diff.h" // For the --diff trace comparison tool.
+#include "batch.h" // For the --batch parallel runner.
+#include "daemon.h" // For the --daemon socket server.
+#include "sweep.h" // For the --sweep design-space exploration.
+#include "segment.h" // For the --segmented parallel timing mode.
+#include "sample.h" // For the --sample statistical sampling mode.
+#include "simpoint.h" // For the --simpoint phase analysis mode.
+#include "dep_distance.h" // For the --deps dependency distance analyzer.
+#include "dataflow.h" // For the --ilp dataflow limit analysis.
+#include "host_perf.h" // For the --host-counters phase counters.
+#include "split_sim.h" // For the --split producer/consumer mode.
+#include "spsc_ring.h" // For SPSC_RING_DEFAULT_CAPACITY.
+#include "result_cache.h" // For the --cache-dir result cache.
+#include "predecode.h" // For the --predecode warm-start cache and fetch_instruction.
+#include "sim_context.h" // For the per-run simulator state.
+#include "checkpoint.h" // For --save-checkpoint and restoring checkpoints.
+#include "watchdog.h" // For the budgets and livelock detection.
+#include "progress.h" // For the --progress heartbeat.
+#include "live_stats.h" // For --stats-page, --stats-snapshot and --stats-read.
+#include "cpi_stack.h" // For the CPI stack printed with the final state.
+#include "pc_profile.h" // For the --pc-profile per-PC stall and flush profile.
+#include "stage_probe.h" // For the stage timing table of -DSTAGE_PROBES builds.
+
+// Define the debug flag (process-wide, only set while parsing the command line)
 int debug_enabled = 0;
 
-// Instruction counters
-int total_instructions = 0;
-int arithmetic_instructions = 0;
-int logical_instructions = 0;
-int memory_access_instructions = 0;
-int control_transfer_instructions = 0;
-
 /*
 * Initializes the machine state.
 * Sets the program counter (PC) to 0, initializes all registers to 0,
 * initializes memory to 0, and resets the tracking arrays for register writes
-* and memory changes.
+* and memory changes of the given simulation context.
 */
-void initialize_machine_state() {
-    state.pc = 0; // Initialize PC to 0
-    memset(state.registers, 0, sizeof(state.registers)); // Initialize registers to 0
-    memset(state.memory, 0, sizeof(state.memory)); // Initialize memory to 0
-    memset(register_written, 0, sizeof(register_written)); // Reset register written tracking
-    memset(memory_changed, 0, sizeof(memory_changed)); // Reset memory change tracking
-    // Note: clock_cycles, total_stalls, total_flushes are in no_fwd.c and initialized there
+void initialize_machine_state(SimContext *ctx) {
+    ctx->state.pc = 0; // Initialize PC to 0
+    memset(ctx->state.registers, 0, sizeof(ctx->state.registers)); // Initialize registers to 0
+    memset(ctx->state.memory, 0, sizeof(ctx->state.memory)); // Initialize memory to 0
+    memset(ctx->register_written, 0, sizeof(ctx->register_written)); // Reset register written tracking
+    memset(ctx->memory_changed, 0, sizeof(ctx->memory_changed)); // Reset memory change tracking
+    // Note: clock_cycles, total_stalls, total_flushes are reset with the rest of the context
 }
 
 /*
@@ -67,10 +80,10 @@ void initialize_machine_state() {
 * It updates the machine state accordingly, including the program counter,
 * registers, and memory.
 */
-void simulate_instruction(DecodedInstruction instr) {
+void simulate_instruction(SimContext *ctx, DecodedInstruction instr) {
     // Debug Statement
     DBG_PRINTF("SIMULATE_INSTRUCTION called with PC (arch before this instr)=%u, Opcode=0x%X, rs=%d, rt=%d, rd=%d, imm=%d\n",
-           state.pc, instr.opcode, instr.rs, instr.rt, instr.rd, instr.immediate);
+           ctx->state.pc, instr.opcode, instr.rs, instr.rt, instr.rd, instr.immediate);
     // R0 (register 0) is always 0 and cannot be written
     if (instr.type == R_TYPE && instr.rd == 0) {
         // Attempting to write to R0. Do nothing, R0 remains 0.
@@ -81,140 +94,140 @@ void simulate_instruction(DecodedInstruction instr) {
     } else {
         // Mark destination register as written if it's not R0
         if (instr.type == R_TYPE) {
-            register_written[instr.rd] = 1;
+            ctx->register_written[instr.rd] = 1;
         } else if (instr.opcode == ADDI || instr.opcode == SUBI || instr.opcode == MULI ||
                    instr.opcode == ORI || instr.opcode == ANDI || instr.opcode == XORI ||
                    instr.opcode == LDW) {
-            register_written[instr.rt] = 1;
+            ctx->register_written[instr.rt] = 1;
         }
     }
 
 
-    total_instructions++; // Increment total instructions executed by functional sim
+    ctx->total_instructions++; // Increment total instructions executed by functional sim
 
     switch (instr.opcode) {
         // Arithmetic Instructions
         case ADD:
-            state.registers[instr.rd] = state.registers[instr.rs] + state.registers[instr.rt];
-            arithmetic_instructions++;
+            ctx->state.registers[instr.rd] = ctx->state.registers[instr.rs] + ctx->state.registers[instr.rt];
+            ctx->arithmetic_instructions++;
             break;
         case ADDI:
-            state.registers[instr.rt] = state.registers[instr.rs] + instr.immediate;
-            arithmetic_instructions++;
+            ctx->state.registers[instr.rt] = ctx->state.registers[instr.rs] + instr.immediate;
+            ctx->arithmetic_instructions++;
             break;
         case SUB:
-            state.registers[instr.rd] = state.registers[instr.rs] - state.registers[instr.rt];
-            arithmetic_instructions++;
+            ctx->state.registers[instr.rd] = ctx->state.registers[instr.rs] - ctx->state.registers[instr.rt];
+            ctx->arithmetic_instructions++;
             break;
         case SUBI:
-            state.registers[instr.rt] = state.registers[instr.rs] - instr.immediate;
-            arithmetic_instructions++;
+            ctx->state.registers[instr.rt] = ctx->state.registers[instr.rs] - instr.immediate;
+            ctx->arithmetic_instructions++;
             break;
         case MUL:
-            state.registers[instr.rd] = state.registers[instr.rs] * state.registers[instr.rt];
-            arithmetic_instructions++;
+            ctx->state.registers[instr.rd] = ctx->state.registers[instr.rs] * ctx->state.registers[instr.rt];
+            ctx->arithmetic_instructions++;
             break;
         case MULI:
-            state.registers[instr.rt] = state.registers[instr.rs] * instr.immediate;
-            arithmetic_instructions++;
+            ctx->state.registers[instr.rt] = ctx->state.registers[instr.rs] * instr.immediate;
+            ctx->arithmetic_instructions++;
             break;
 
         // Logical Instructions
         case OR:
-            state.registers[instr.rd] = state.registers[instr.rs] | state.registers[instr.rt];
-            logical_instructions++;
+            ctx->state.registers[instr.rd] = ctx->state.registers[instr.rs] | ctx->state.registers[instr.rt];
+            ctx->logical_instructions++;
             break;
         case ORI:
-            state.registers[instr.rt] = state.registers[instr.rs] | instr.immediate;
-            logical_instructions++;
+            ctx->state.registers[instr.rt] = ctx->state.registers[instr.rs] | instr.immediate;
+            ctx->logical_instructions++;
             break;
         case AND:
-            state.registers[instr.rd] = state.registers[instr.rs] & state.registers[instr.rt];
-            logical_instructions++;
+            ctx->state.registers[instr.rd] = ctx->state.registers[instr.rs] & ctx->state.registers[instr.rt];
+            ctx->logical_instructions++;
             break;
         case ANDI:
-            state.registers[instr.rt] = state.registers[instr.rs] & instr.immediate;
-            logical_instructions++;
+            ctx->state.registers[instr.rt] = ctx->state.registers[instr.rs] & instr.immediate;
+            ctx->logical_instructions++;
             break;
         case XOR:
-            state.registers[instr.rd] = state.registers[instr.rs] ^ state.registers[instr.rt];
-            logical_instructions++;
+            ctx->state.registers[instr.rd] = ctx->state.registers[instr.rs] ^ ctx->state.registers[instr.rt];
+            ctx->logical_instructions++;
             break;
         case XORI:
-            state.registers[instr.rt] = state.registers[instr.rs] ^ instr.immediate;
-            logical_instructions++;
+            ctx->state.registers[instr.rt] = ctx->state.registers[instr.rs] ^ instr.immediate;
+            ctx->logical_instructions++;
             break;
 
         // Memory Access Instructions
         case LDW: {
             // Address calculation: R[rs] + immediate (signed offset in bytes)
-            int32_t address = state.registers[instr.rs] + instr.immediate;
+            int32_t address = ctx->state.registers[instr.rs] + instr.immediate;
             // Check for unaligned access (optional, depending on ISA spec)
             if (address % 4 != 0) {
                 DBG_PRINTF(stderr, "Error: Unaligned memory access at address 0x%X for LDW\n", address);
                 // Handle error: perhaps exit or ignore, based on project spec
             }
             // Memory is word-addressable in our simulation (address / 4)
-            state.registers[instr.rt] = state.memory[address / 4];
-            memory_access_instructions++;
+            ctx->state.registers[instr.rt] = ctx->state.memory[address / 4];
+            ctx->memory_access_instructions++;
             break;
         }
         case STW: {
             // Address calculation: R[rs] + immediate (signed offset in bytes)
-            int32_t address = state.registers[instr.rs] + instr.immediate;
+            int32_t address = ctx->state.registers[instr.rs] + instr.immediate;
             // Check for unaligned access (optional)
             if (address % 4 != 0) {
                 DBG_PRINTF(stderr, "Error: Unaligned memory access at address 0x%X for STW\n", address);
                 // Handle error
             }
-            state.memory[address / 4] = state.registers[instr.rt];
-            memory_changed[address / 4] = 1; // Mark memory as changed
-            memory_access_instructions++;
+            ctx->state.memory[address / 4] = ctx->state.registers[instr.rt];
+            ctx->memory_changed[address / 4] = 1; // Mark memory as changed
+            ctx->memory_access_instructions++;
             // Debug statement.
-            DBG_PRINTF("  EXECUTED STW logic for PC (arch before this instr)=%u. About to break.\n", state.pc); // Use state.pc as it was at entry
+            DBG_PRINTF("  EXECUTED STW logic for PC (arch before this instr)=%u. About to break.\n", ctx->state.pc); // Use state.pc as it was at entry
             break;
         }
 
         // Control Transfer Instructions
         case BZ:
-            if (state.registers[instr.rs] == 0) {
-                state.pc += ((int32_t)instr.immediate) * 4;
-                control_transfer_instructions++;
+            if (ctx->state.registers[instr.rs] == 0) {
+                ctx->state.pc += ((int32_t)instr.immediate) * 4;
+                ctx->control_transfer_instructions++;
                 return; // PC has been updated, so return immediately
             }
-            control_transfer_instructions++;
+            ctx->control_transfer_instructions++;
             break; // Fall through if branch not taken
         case BEQ:
-            if (state.registers[instr.rs] == state.registers[instr.rt]) {
-                state.pc += ((int32_t)instr.immediate) * 4;
-                control_transfer_instructions++;
+            if (ctx->state.registers[instr.rs] == ctx->state.registers[instr.rt]) {
+                ctx->state.pc += ((int32_t)instr.immediate) * 4;
+                ctx->control_transfer_instructions++;
                 return; // PC has been updated, so return immediately
             }
-            control_transfer_instructions++;
+            ctx->control_transfer_instructions++;
             break; // Fall through if branch not taken
         case JR:
-            state.pc = (uint32_t)state.registers[instr.rs]; // Jump to address in Rs
-            control_transfer_instructions++;
+            ctx->state.pc = (uint32_t)ctx->state.registers[instr.rs]; // Jump to address in Rs
+            ctx->control_transfer_instructions++;
             return; // PC has been updated, so return immediately
         case HALT:
-            control_transfer_instructions++;
+            ctx->control_transfer_instructions++;
             // state.pc += 4; // Increment PC for HALT itself for accurate final PC count
             // Above line removed since it messed up FS's PC counter.
             DBG_PRINTF("--- HALT INSTRUCTION PROCESSING ---\n"); // New debug
-            DBG_PRINTF("--- Architectural PC before this HALT was: %u ---\n", state.pc - 4); // New debug
-            DBG_PRINTF("--- Architectural PC AFTER HALT increment is: %u ---\n", state.pc); // New debug
+            DBG_PRINTF("--- Architectural PC before this HALT was: %u ---\n", ctx->state.pc - 4); // New debug
+            DBG_PRINTF("--- Architectural PC AFTER HALT increment is: %u ---\n", ctx->state.pc); // New debug
             DBG_PRINTF("Program halted.\n");
             break;;
         case NOP:
             // Do nothing
             break;
         default:
-            DBG_PRINTF(stderr, "Error: Unknown opcode: 0x%02X at PC: 0x%08X\n", instr.opcode, state.pc);
+            DBG_PRINTF(stderr, "Error: Unknown opcode: 0x%02X at PC: 0x%08X\n", instr.opcode, ctx->state.pc);
             exit(1); // Exit on unknown opcode
     }
 
     // Default program counter increment (if not branched or jumped)
-    state.pc += 4;
+    ctx->state.pc += 4;
 }
 
 
@@ -226,24 +239,25 @@ void simulate_instruction(DecodedInstruction instr) {
 * This function is called when the HALT instruction is executed.
 * It can also be called at the end of the functional simulation loop.
 */
-void print_final_state() {
+void print_final_state(const SimContext *ctx) {
+    int previous_phase = host_perf_enter(HOST_PHASE_OTHER, ctx); // Printing is not part of the loops
     printf("Functional simulator output is as follows:\n\n");
 
     // Instruction counts
     printf("Instruction counts:\n");
-    printf("Total number of instructions: %d\n", total_instructions);
-    printf("Arithmetic instructions: %d\n", arithmetic_instructions);
-    printf("Logical instructions: %d\n", logical_instructions);
-    printf("Memory access instructions: %d\n", memory_access_instructions);
-    printf("Control transfer instructions: %d\n\n", control_transfer_instructions);
+    printf("Total number of instructions: %llu\n", (unsigned long long)ctx->total_instructions);
+    printf("Arithmetic instructions: %llu\n", (unsigned long long)ctx->arithmetic_instructions);
+    printf("Logical instructions: %llu\n", (unsigned long long)ctx->logical_instructions);
+    printf("Memory access instructions: %llu\n", (unsigned long long)ctx->memory_access_instructions);
+    printf("Control transfer instructions: %llu\n\n", (unsigned long long)ctx->control_transfer_instructions);
 
     // Final register state
     printf("Final register state:\n");
-    printf("Program counter: %u\n", state.pc);
+    printf("Program counter: %u\n", ctx->state.pc);
     for (int i = 0; i < 32; i++) {
         // Only print registers that were explicitly written to or are non-zero (optional, but good for debugging)
-        if (register_written[i] || state.registers[i] != 0) {
-            printf("R%d: %d\n", i, state.registers[i]);
+        if (ctx->register_written[i] || ctx->state.registers[i] != 0) {
+            printf("R%d: %d\n", i, ctx->state.registers[i]);
         }
     }
     printf("\n");
@@ -251,125 +265,690 @@ void print_final_state() {
     // Final memory state
     printf("Final memory state:\n");
     for (int i = 0; i < 1024; i++) {
-        if (memory_changed[i]) {
-            printf("Address: %d, Contents: %u\n", i * 4, state.memory[i]);
+        if (ctx->memory_changed[i]) {
+            printf("Address: %d, Contents: %u\n", i * 4, ctx->state.memory[i]);
         }
     }
     printf("\n");
 
     // Total clock cycles:
     // This clock_cycles is from the pipeline simulator (no_fwd.c)
-    printf("Total stalls: %d\n", total_stalls);
+    printf("Total stalls: %llu\n", (unsigned long long)ctx->total_stalls);
     printf("Timing Simulator:\n");
-    printf("Total number of clock cycles: %d\n", clock_cycles);
+    printf("Total number of clock cycles: %llu\n", (unsigned long long)ctx->clock_cycles);
+    cpi_stack_print(ctx); // NF/WF: where the cycles went
+    host_perf_enter(previous_phase, ctx);
+}
+
+/*
+* Executes the next instruction of the functional simulation.
+* Returns 1 once the run has finished (HALT executed, PC out of bounds or stopped by the
+* watchdog), 0 otherwise.
+*/
+int step_functional(SimContext *ctx) {
+    if (ctx->halted) return 1;
+
+    uint32_t pc_before_simulate = ctx->state.pc;
+
+    if (ctx->state.pc >= 4096) { // Check for PC out of bounds
+        DBG_PRINTF(stderr, "[FS_FOCUS_TRACE] PC out of bounds: %u\n", ctx->state.pc);
+        ctx->halted = 1;
+        return 1;
+    }
+    DecodedInstruction decoded = fetch_instruction(ctx, ctx->state.pc); // Predecoded when available
+
+    // Print key architectural state *before* the instruction is simulated (optional, but can be useful)
+    DBG_PRINTF("[FS_TRACE] PRE  PC=0x%03X: %s (Op:0x%X Rd:%d Rs:%d Rt:%d Imm:%d) || R1=%d R8=%d R10=%d R11=%d\n",
+            pc_before_simulate,
+            opcode_to_string(decoded.opcode), // Ensure opcode_to_string is available
+            decoded.opcode, decoded.rd, decoded.rs, decoded.rt, decoded.immediate,
+            ctx->state.registers[1], ctx->state.registers[8], ctx->state.registers[10], ctx->state.registers[11]);
+
+    simulate_instruction(ctx, decoded);
+    watchdog_commit(ctx, &decoded, pc_before_simulate);
+
+    // Key PC logging
+    uint32_t key_pcs[] = {0, 4, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60, 64, 68, 72, 76, 80, 84, 88, 92, 96};
+    int num_key_pcs = sizeof(key_pcs) / sizeof(uint32_t);
+    int log_this_instruction = 0;
+    for (int i = 0; i < num_key_pcs; i++) {
+        if (ctx->state.pc == key_pcs[i]) {
+            log_this_instruction = 1;
+            break;
+        }
+    }
+    // Always log branch decisions & HALT
+    if (decoded.opcode == BEQ || decoded.opcode == BZ || decoded.opcode == JR || decoded.opcode == HALT) {
+        log_this_instruction = 1;
+    }
+
+    if (log_this_instruction) {
+        DBG_PRINTF("[FS_COMMIT] PC=0x%03X; Op=%-4s(0x%02X); Rd=%2d,Rs=%2d,Rt=%2d,Imm=%-6d || R1=%-4d,R2=%-4d,R3=%-4d,R4=%-4d,R5=%-3d,R6=%-3d,R8=%-4d,R10=%-2d,R11=%-2d,R12=%-2d || NextPC=0x%03X\n",
+               ctx->state.pc, 
+               opcode_to_string(decoded.opcode), decoded.opcode,
+               decoded.rd, decoded.rs, decoded.rt, decoded.immediate,
+               ctx->state.registers[1], ctx->state.registers[2], ctx->state.registers[3], ctx->state.registers[4],
+               ctx->state.registers[5], ctx->state.registers[6], ctx->state.registers[8], ctx->state.registers[10],
+               ctx->state.registers[11], ctx->state.registers[12], 
+               ctx->state.pc); // state.pc is the PC for the *next* instruction
+        fflush(stdout);
+    }
+
+    if (decoded.opcode == HALT) {
+        ctx->halted = 1;
+        return 1;
+    }
+    if (watchdog_expired(ctx, WATCHDOG_UNLIMITED)) { // Instruction budget or infinite loop
+        ctx->halted = 1;
+        return 1;
+    }
+    PROGRESS_UPDATE(ctx);
+    LIVE_STATS_UPDATE(ctx);
+    return 0;
+}
+
+/*
+* Runs the functional simulation loop on the given context until HALT
+* (or the PC leaves memory). The caller prints the final state.
+*/
+void run_functional_simulation(SimContext *ctx) {
+    // ADDED FS Trace Start
+    DBG_PRINTF("[FS_FOCUS_TRACE_START]\n");
+    while (!step_functional(ctx)) {
+        // One instruction per step
+    }
+    DBG_PRINTF("[FS_FOCUS_TRACE_END]\n");
+}
+
+// The command line front end is left out of the libmipslite build (see mipslite.h)
+#ifndef MIPSLITE_LIBRARY
+
+/*
+* Parses a "<lo>:<hi>" range option value (decimal or 0x-prefixed hex).
+* Returns 0 on success, -1 if the value is malformed.
+*/
+static int parse_range(const char *value, unsigned long long *lo, unsigned long long *hi) {
+    char *end;
+    *lo = strtoull(value, &end, 0);
+    if (*end != ':') return -1;
+    *hi = strtoull(end + 1, &end, 0);
+    if (*end != '\0' || *hi < *lo) return -1;
+    return 0;
+}
+
+/*
+* Parses a budget option value (decimal or 0x-prefixed hex).
+* Returns 0 on success, -1 (after printing an error) if the value is malformed.
+*/
+static int parse_budget(const char *value, uint64_t *budget) {
+    char *end;
+    *budget = strtoull(value, &end, 0);
+    if (end == value || *end != '\0') {
+        fprintf(stderr, "Error: Invalid budget '%s'\n", value);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+* Prints the command line usage.
+*/
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <memory_image_file|checkpoint_file> <FS|NF|WF> [options]\n", prog);
+    fprintf(stderr, "       %s --diff <expected_trace> <actual_trace> [diff options]\n", prog);
+    fprintf(stderr, "       %s --batch <list-file> [--jobs=<n>] [--report=<file>] [--format=json|csv]\n", prog);
+    fprintf(stderr, "       %s --sweep <memory_image_file> [--param=<name>=<values>]... [--cost=<name>:<weight>,...]\n", prog);
+    fprintf(stderr, "       %s --segmented <memory_image_file> [--mode=NF|WF] [--segment=<n>] [--warmup=<n>] [--check]\n", prog);
+    fprintf(stderr, "       %s --sample <memory_image_file> [--mode=NF|WF] [--interval=<n>] [--unit=<n>] [--warmup=<n>] [--check]\n", prog);
+    fprintf(stderr, "       %s --simpoint <memory_image_file> [--mode=NF|WF] [--interval=<n>] [--max-k=<n>] [--bbv=<file>] [--check]\n", prog);
+    fprintf(stderr, "       %s --deps <memory_image_file> [--check] [--max-instructions=<n>]\n", prog);
+    fprintf(stderr, "       %s --ilp <memory_image_file> [--latency=<class>:<n>,...] [--window=<n>,...]\n", prog);
+    fprintf(stderr, "       %s --stats-read <stats_page> [--watch=<seconds>]\n", prog);
+    fprintf(stderr, "       %s --daemon <socket> [--jobs=<n>] [--images=<n>]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -d, --debug              Print debug output\n");
+    fprintf(stderr, "  --kanata=<file>          Export the NF/WF pipeline to a Kanata log (Konata viewer)\n");
+    fprintf(stderr, "  --kanata-cycles=<lo>:<hi> Only export cycles lo..hi\n");
+    fprintf(stderr, "  --kanata-pcs=<lo>:<hi>    Only export instructions with PC in lo..hi\n");
+    fprintf(stderr, "  --predecode              Load via <image>.pdc (predecode + CFG cache, rebuilt when the image changes)\n");
+    fprintf(stderr, "  --pc-profile[=<n>]       NF/WF: print stalls and flushes per instruction, sorted by cycles lost (top n rows)\n");
+    fprintf(stderr, "  --cache-dir=<dir>        Reuse/store results keyed by image, mode and model (not with -d/--kanata/--pc-profile)\n");
+    fprintf(stderr, "  --split[=NF,WF]          NF/WF: run FS on one thread feeding timing model threads via lock-free rings\n");
+    fprintf(stderr, "  --save-checkpoint=<file> Save the architectural state and counters at the end of the run\n");
+    fprintf(stderr, "  --checkpoint-at=<n>      FS: stop and save the checkpoint after n instructions\n");
+    fprintf(stderr, "  --ff=<n>|--ff=pc:<addr>  NF/WF: run functionally for n instructions (or until PC addr), then\n");
+    fprintf(stderr, "                           continue cycle-accurately from an empty pipeline; reports the region\n");
+    fprintf(stderr, "  --max-cycles=<n>         NF/WF: stop after n clock cycles (default NF 200000, WF 100000; 0 = unlimited)\n");
+    fprintf(stderr, "  --max-instructions=<n>   Stop after n committed instructions (default unlimited)\n");
+    fprintf(stderr, "  --progress[=<seconds>]   Print instructions/s and the ETA to stderr every 10 (or n) seconds\n");
+    fprintf(stderr, "  --stats-page[=<file>]    Publish live counters in a mapped page (default /dev/shm/mipslite-<pid>.stats)\n");
+    fprintf(stderr, "  --stats-snapshot[=<file>] On SIGUSR1, write all statistics as JSON (default mipslite-<pid>.json)\n");
+    fprintf(stderr, "  --host-counters          Print host cycles, instructions, branch and cache misses per phase at exit\n");
+    fprintf(stderr, "  --no-livelock            Do not stop on a detected infinite loop (repeated architectural state)\n");
+    fprintf(stderr, "A checkpoint file in place of the memory image resumes from it (NF/WF with an empty pipeline).\n");
+    fprintf(stderr, "Builds with -DSTAGE_PROBES print the time spent in each NF/WF cycle stage at exit.\n");
+}
+
+/*
+* Runs NF or WF in split mode: the functional simulator on this thread feeds one timing model
+* thread per mode in split_modes (a comma separated NF/WF list, the selected mode is always
+* timed). Prints the final state with the selected mode's timing, followed by one line per
+* additional mode. Returns 0 on success, -1 on errors.
+*/
+static int run_split_mode(SimContext *ctx, const char *mode, const char *split_modes) {
+    SplitConsumer consumers[SPLIT_MAX_CONSUMERS];
+    const char *names[SPLIT_MAX_CONSUMERS];
+    int count = 0;
+
+    // The selected mode is consumer 0; further modes are parsed from the list
+    char list[64];
+    snprintf(list, sizeof(list), "%s,%s", mode, split_modes ? split_modes : "");
+    for (char *token = strtok(list, ","); token; token = strtok(NULL, ",")) {
+        int forwarding;
+        if (strcmp(token, "NF") == 0) {
+            forwarding = 0;
+        } else if (strcmp(token, "WF") == 0) {
+            forwarding = 1;
+        } else {
+            fprintf(stderr, "Error: Invalid split mode '%s' (expected NF or WF)\n", token);
+            return -1;
+        }
+        int duplicate = 0;
+        for (int i = 0; i < count; i++) {
+            if (strcmp(names[i], token) == 0) duplicate = 1;
+        }
+        if (duplicate || count == SPLIT_MAX_CONSUMERS) continue;
+
+        names[count] = forwarding ? "WF" : "NF";
+        pipeline_config_preset(&consumers[count].cfg, forwarding);
+        uint64_t max_cycles = ctx->watchdog.cfg.max_cycles; // Same budgets as with_fwd.c / no_fwd.c
+        if (!max_cycles) max_cycles = forwarding ? WATCHDOG_WF_DEFAULT_CYCLES : WATCHDOG_NF_DEFAULT_CYCLES;
+        consumers[count].cycle_limit = max_cycles == WATCHDOG_UNLIMITED ? 0 : max_cycles;
+        count++;
+    }
+
+    if (run_split_simulation(ctx, consumers, count, SPSC_RING_DEFAULT_CAPACITY) < 0) return -1;
+
+    if (consumers[0].limit_hit && ctx->watchdog.stop == WATCHDOG_RUNNING) {
+        ctx->watchdog.stop = WATCHDOG_CYCLE_BUDGET;
+        ctx->watchdog.budget = consumers[0].cycle_limit;
+    }
+    watchdog_report(ctx); // Budget or livelock stop of the functional thread, or the cycle limit
+    ctx->clock_cycles += consumers[0].model.cycles; // On top of a restored checkpoint's counters
+    ctx->total_stalls += consumers[0].model.stalls;
+    ctx->total_flushes += consumers[0].model.flushes;
+    print_final_state(ctx);
+
+    for (int i = 1; i < count; i++) {
+        printf("Split timing %s: %llu clock cycles, %llu stalls%s\n", names[i],
+               (unsigned long long)consumers[i].model.cycles, (unsigned long long)consumers[i].model.stalls,
+               consumers[i].limit_hit ? " (cycle limit reached)" : "");
+    }
+    for (int i = 0; i < count; i++) {
+        timing_model_free(&consumers[i].model);
+    }
+    return 0;
+}
+
+/*
+* Parses a "--ff" value: an instruction count, or "pc:<addr>" for the first time the PC
+* reaches addr. Returns 0 on success, -1 if malformed.
+*/
+static int parse_fast_forward(const char *value, unsigned long long *count, long long *pc) {
+    char *end;
+    if (strncmp(value, "pc:", 3) == 0) {
+        unsigned long long address = strtoull(value + 3, &end, 0);
+        if (end == value + 3 || *end != '\0' || address >= 4096 || address % 4 != 0) return -1;
+        *pc = (long long)address;
+        return 0;
+    }
+    *count = strtoull(value, &end, 0);
+    if (end == value || *end != '\0' || *count == 0) return -1;
+    return 0;
+}
+
+/*
+* Runs the functional simulator until ff_count more instructions have committed, or until
+* the next PC is ff_pc (when ff_pc >= 0), or the program finishes.
+* Returns the number of instructions executed.
+*/
+static unsigned long long run_fast_forward(SimContext *ctx, unsigned long long ff_count, long long ff_pc) {
+    unsigned long long executed = 0;
+    while (!ctx->halted) {
+        if (ff_pc >= 0 ? ctx->state.pc == (uint32_t)ff_pc : executed == ff_count) break;
+        if (step_functional(ctx)) break;
+        executed++;
+    }
+    if (ctx->halted) executed = ctx->total_instructions; // HALT counts as executed
+    return executed;
+}
+
+/*
+* Prints the statistics of the cycle-accurate region of a fast-forwarded run
+* (everything counted since the hand-off snapshot in *start).
+*/
+static void print_detailed_region(const SimContext *ctx, const SimContext *start, unsigned long long fast_forwarded) {
+    uint64_t instructions = ctx->total_instructions - start->total_instructions;
+    uint64_t cycles = ctx->clock_cycles - start->clock_cycles;
+    printf("Fast-forward: %llu instructions, hand-off at PC %u\n", fast_forwarded, start->state.pc);
+    printf("Detailed region: %llu instructions, %llu clock cycles, %llu stalls, CPI %.4f\n",
+           (unsigned long long)instructions, (unsigned long long)cycles,
+           (unsigned long long)(ctx->total_stalls - start->total_stalls), instructions > 0 ? (double)cycles / instructions : 0.0);
 }
 
 /*
 * Main function to run the functional simulator.
 * It accepts command line arguments to specify the memory image file,
-* the mode of operation (FS, NF, WF), and an optional debug flag.
+* the mode of operation (FS, NF, WF), and optional flags (debug, pipeline export).
+* "--diff" as the first argument runs the trace differ instead, "--batch" the batch runner,
+* "--sweep" the design-space sweep, "--segmented" the segmented parallel timing,
+* "--sample" the sampled simulation, "--simpoint" the SimPoint phase analysis,
+* "--deps" the dependency distance analyzer, "--ilp" the dataflow limit analysis,
+* "--stats-read" the live statistics reader and "--daemon" the simulation server.
 * It initializes the machine state, reads the memory image, and runs the
 * appropriate simulation based on the mode specified.
 */
 int main(int argc, char *argv[]) {
-    // Accepts an optional 4th argument (“-d” or “--debug”)
-    if (argc < 3 || argc > 4) {
-         fprintf(stderr, "Usage: %s <memory_image_file> <FS|NF|WF>\n", argv[0]);
-         return 1;
+    STAGE_PROBE_INIT(); // Stage timing table at exit (builds with -DSTAGE_PROBES only)
+
+    // Trace comparison tool: compares two trace files instead of simulating
+    if (argc >= 2 && strcmp(argv[1], "--diff") == 0) {
+        return trace_diff_main(argc - 1, argv + 1);
+    }
+
+    // Batch mode: runs every (image, mode) job of a list file on a thread pool
+    if (argc >= 2 && strcmp(argv[1], "--batch") == 0) {
+        return batch_main(argc - 1, argv + 1);
+    }
+
+    // Design-space sweep: times one image under many pipeline configurations
+    if (argc >= 2 && strcmp(argv[1], "--sweep") == 0) {
+        return sweep_main(argc - 1, argv + 1);
+    }
+
+    // Segmented timing: times slices of one long run in parallel and stitches them
+    if (argc >= 2 && strcmp(argv[1], "--segmented") == 0) {
+        return segment_main(argc - 1, argv + 1);
+    }
+
+    // Sampled simulation: estimates CPI from short detailed windows
+    if (argc >= 2 && strcmp(argv[1], "--sample") == 0) {
+        return sample_main(argc - 1, argv + 1);
+    }
+
+    // SimPoint analysis: clusters interval BBVs and times one point per phase
+    if (argc >= 2 && strcmp(argv[1], "--simpoint") == 0) {
+        return simpoint_main(argc - 1, argv + 1);
     }
-    // If the user passed a 4th argument, check for debug
-    if (argc == 4 &&
-        (strcmp(argv[3], "-d") == 0 || strcmp(argv[3], "--debug") == 0)) {
-        debug_enabled = 1;
+
+    // Dependency distances: stall estimates for other pipelines from one functional run
+    if (argc >= 2 && strcmp(argv[1], "--deps") == 0) {
+        return dep_distance_main(argc - 1, argv + 1);
+    }
+
+    // Dataflow limits: critical path and ILP of the commit stream
+    if (argc >= 2 && strcmp(argv[1], "--ilp") == 0) {
+        return dataflow_main(argc - 1, argv + 1);
+    }
+
+    // Counters page reader: "--stats-read <page> [--watch=<seconds>]"
+    if (argc >= 2 && strcmp(argv[1], "--stats-read") == 0) {
+        return live_stats_read_main(argc - 1, argv + 1);
+    }
+
+    // Daemon: serves simulation requests over a Unix socket from warm contexts
+    if (argc >= 2 && strcmp(argv[1], "--daemon") == 0) {
+        return daemon_main(argc - 1, argv + 1);
+    }
+
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
     }
 
     const char *memory_image_file = argv[1];
     const char *mode = argv[2];
+    const char *kanata_file = NULL;
+    unsigned long long kanata_cycle_lo = 0, kanata_cycle_hi = UINT64_MAX;
+    unsigned long long kanata_pc_lo = 0, kanata_pc_hi = UINT32_MAX;
+    const char *cache_dir = NULL;
+    int use_predecode = 0;
+    int use_split = 0;
+    const char *split_modes = NULL;
+    const char *checkpoint_out = NULL;
+    unsigned long long checkpoint_at = 0;
+    unsigned long long ff_count = 0;
+    long long ff_pc = -1;
+    int use_ff = 0;
+    int pc_profile_rows = -1; // -1 = no per-PC profile, 0 = every instruction
+    int host_counters = 0;
+    WatchdogConfig watchdog;
+    watchdog_config_default(&watchdog);
+    int watchdog_set = 0;
+    double progress_interval = 0; // Seconds, 0 = no heartbeat
+    const char *stats_page = NULL;
+    const char *stats_snapshot = NULL;
+    char default_stats_page[64], default_stats_snapshot[64];
+    snprintf(default_stats_page, sizeof(default_stats_page), "/dev/shm/mipslite-%ld.stats", (long)getpid());
+    snprintf(default_stats_snapshot, sizeof(default_stats_snapshot), "mipslite-%ld.json", (long)getpid());
+
+    // Optional arguments after the mode
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--debug") == 0) {
+            debug_enabled = 1;
+        } else if (strncmp(argv[i], "--kanata=", 9) == 0) {
+            kanata_file = argv[i] + 9;
+        } else if (strncmp(argv[i], "--kanata-cycles=", 16) == 0) {
+            if (parse_range(argv[i] + 16, &kanata_cycle_lo, &kanata_cycle_hi) < 0) {
+                fprintf(stderr, "Error: Invalid cycle range '%s'\n", argv[i] + 16);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--kanata-pcs=", 13) == 0) {
+            if (parse_range(argv[i] + 13, &kanata_pc_lo, &kanata_pc_hi) < 0) {
+                fprintf(stderr, "Error: Invalid PC range '%s'\n", argv[i] + 13);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--pc-profile") == 0) {
+            pc_profile_rows = 0;
+        } else if (strncmp(argv[i], "--pc-profile=", 13) == 0) {
+            char *end;
+            pc_profile_rows = (int)strtol(argv[i] + 13, &end, 10);
+            if (end == argv[i] + 13 || *end != '\0' || pc_profile_rows < 0) {
+                fprintf(stderr, "Error: Invalid row count '%s'\n", argv[i] + 13);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--predecode") == 0) {
+            use_predecode = 1;
+        } else if (strncmp(argv[i], "--cache-dir=", 12) == 0) {
+            cache_dir = argv[i] + 12;
+        } else if (strcmp(argv[i], "--split") == 0) {
+            use_split = 1;
+        } else if (strncmp(argv[i], "--split=", 8) == 0) {
+            use_split = 1;
+            split_modes = argv[i] + 8;
+        } else if (strncmp(argv[i], "--save-checkpoint=", 18) == 0) {
+            checkpoint_out = argv[i] + 18;
+        } else if (strncmp(argv[i], "--ff=", 5) == 0) {
+            if (parse_fast_forward(argv[i] + 5, &ff_count, &ff_pc) < 0) {
+                fprintf(stderr, "Error: Invalid fast-forward '%s' (instruction count or pc:<addr>)\n", argv[i] + 5);
+                return 1;
+            }
+            use_ff = 1;
+        } else if (strncmp(argv[i], "--max-cycles=", 13) == 0) {
+            if (parse_budget(argv[i] + 13, &watchdog.max_cycles) < 0) return 1;
+            if (watchdog.max_cycles == 0) watchdog.max_cycles = WATCHDOG_UNLIMITED;
+            watchdog_set = 1;
+        } else if (strncmp(argv[i], "--max-instructions=", 19) == 0) {
+            if (parse_budget(argv[i] + 19, &watchdog.max_instructions) < 0) return 1;
+            watchdog_set = 1;
+        } else if (strcmp(argv[i], "--progress") == 0) {
+            progress_interval = PROGRESS_DEFAULT_INTERVAL;
+        } else if (strncmp(argv[i], "--progress=", 11) == 0) {
+            char *end;
+            progress_interval = strtod(argv[i] + 11, &end);
+            if (end == argv[i] + 11 || *end != '\0' || progress_interval <= 0) {
+                fprintf(stderr, "Error: Invalid progress interval '%s'\n", argv[i] + 11);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--stats-page") == 0) {
+            stats_page = default_stats_page;
+        } else if (strncmp(argv[i], "--stats-page=", 13) == 0) {
+            stats_page = argv[i] + 13;
+        } else if (strcmp(argv[i], "--stats-snapshot") == 0) {
+            stats_snapshot = default_stats_snapshot;
+        } else if (strncmp(argv[i], "--stats-snapshot=", 17) == 0) {
+            stats_snapshot = argv[i] + 17;
+        } else if (strcmp(argv[i], "--host-counters") == 0) {
+            host_counters = 1;
+        } else if (strcmp(argv[i], "--no-livelock") == 0) {
+            watchdog.detect_livelock = 0;
+            watchdog_set = 1;
+        } else if (strncmp(argv[i], "--checkpoint-at=", 16) == 0) {
+            char *end;
+            checkpoint_at = strtoull(argv[i] + 16, &end, 0);
+            if (*end != '\0' || checkpoint_at == 0) {
+                fprintf(stderr, "Error: Invalid instruction count '%s'\n", argv[i] + 16);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (checkpoint_at && (strcmp(mode, "FS") != 0 || !checkpoint_out)) {
+        fprintf(stderr, "Error: --checkpoint-at needs FS mode and --save-checkpoint\n");
+        return 1;
+    }
+    if (use_ff && ((strcmp(mode, "NF") != 0 && strcmp(mode, "WF") != 0) || use_split)) {
+        fprintf(stderr, "Error: --ff needs NF or WF mode (without --split)\n");
+        return 1;
+    }
+    if (pc_profile_rows >= 0 && ((strcmp(mode, "NF") != 0 && strcmp(mode, "WF") != 0) || use_split)) {
+        fprintf(stderr, "Error: --pc-profile needs NF or WF mode (without --split)\n");
+        return 1;
+    }
+    if (host_counters && use_split) {
+        fprintf(stderr, "Error: --host-counters measures this thread only and does not cover --split\n");
+        return 1;
+    }
 
     // Always initialize state before loading memory or running simulation
-    initialize_machine_state();
+    SimContext *ctx = sim_context_create();
+    if (!ctx) {
+        perror("Error allocating simulator context");
+        return 1;
+    }
+    if (host_counters) {
+        host_perf_start();
+        atexit(host_perf_report); // Covers every way the run ends
+    }
 
-    // Load memory image
-    if (read_memory_image(memory_image_file, state.memory) < 0) {
-        fprintf(stderr, "Error: Failed to load memory image from file '%s'\n", memory_image_file);
+    // Load a checkpoint, or the memory image (through the warm-start cache if requested)
+    PredecodeImage *image = NULL;
+    host_perf_enter(HOST_PHASE_LOAD, ctx);
+    int restored = checkpoint_is_file(memory_image_file);
+    int words_loaded;
+    if (restored) {
+        words_loaded = checkpoint_load(ctx, memory_image_file);
+    } else {
+        words_loaded = use_predecode ? predecode_load_image(memory_image_file, ctx->state.memory, &image)
+                                     : read_memory_image(memory_image_file, ctx->state.memory);
+    }
+    host_perf_enter(HOST_PHASE_OTHER, ctx);
+    if (words_loaded < 0) {
+        if (!restored) fprintf(stderr, "Error: Failed to load memory image from file '%s'\n", memory_image_file);
+        sim_context_destroy(ctx);
         return 1;
     }
+    if (image) ctx->predecode = image->file;
+    ctx->watchdog.cfg = watchdog;
+
+    // Heartbeat: the ETA is measured against the budgets that will end the run
+    static ProgressMeter progress;
+    if (progress_interval > 0) {
+        uint64_t max_cycles = watchdog.max_cycles;
+        if (!max_cycles) max_cycles = strcmp(mode, "WF") == 0 ? WATCHDOG_WF_DEFAULT_CYCLES : WATCHDOG_NF_DEFAULT_CYCLES;
+        if (max_cycles == WATCHDOG_UNLIMITED || strcmp(mode, "FS") == 0) max_cycles = 0;
+        progress_init(&progress, stderr, progress_interval, watchdog.max_instructions, max_cycles);
+        ctx->progress = &progress;
+    }
+
+    // Live statistics for external monitors
+    static LiveStats live_stats;
+    if (stats_page || stats_snapshot) {
+        if (live_stats_open(&live_stats, stats_page, stats_snapshot, mode) < 0) {
+            sim_context_destroy(ctx);
+            predecode_release(image);
+            return 1;
+        }
+        ctx->live_stats = &live_stats;
+        if (stats_page) fprintf(stderr, "Stats page: %s (read with --stats-read)\n", stats_page);
+        if (stats_snapshot) fprintf(stderr, "Stats snapshot: kill -USR1 %ld writes %s\n", (long)getpid(), stats_snapshot);
+    }
+
+    // Result cache: debug and pipeline export runs always simulate, since their output is the point.
+    // The key covers the initial image only, so resumed and checkpointing runs always simulate too.
+    static uint32_t input_memory[1024];
+    int use_result_cache = cache_dir && !debug_enabled && !kanata_file && pc_profile_rows < 0 && !host_counters && !restored && !checkpoint_out && !use_ff &&
+                           !watchdog_set &&
+                           (strcmp(mode, "FS") == 0 || strcmp(mode, "NF") == 0 || strcmp(mode, "WF") == 0);
+    if (use_result_cache) {
+        memcpy(input_memory, ctx->state.memory, sizeof(input_memory));
+        if (result_cache_lookup(ctx, cache_dir, input_memory, mode)) {
+            print_final_state(ctx);
+            sim_context_destroy(ctx);
+            predecode_release(image);
+            return 0;
+        }
+    }
 
     if (strcmp(mode, "FS") == 0) {
-        // Run functional simulation loop
-        // ADDED FS Trace Start
-        DBG_PRINTF("[FS_FOCUS_TRACE_START]\n");
-        while (1) {
-            uint32_t pc_before_simulate = state.pc;
-
-            if (state.pc >= 4096) { // Check for PC out of bounds
-                DBG_PRINTF(stderr, "[FS_FOCUS_TRACE] PC out of bounds: %u\n", state.pc);
-                break;
+        int status = 0;
+        host_perf_enter(HOST_PHASE_FS, ctx);
+        if (checkpoint_at) {
+            // Stop early: the checkpoint is the point of the run
+            while (ctx->total_instructions < checkpoint_at && !step_functional(ctx)) {
+                // One instruction per step
             }
-            uint32_t instr_word = state.memory[state.pc / 4];
-            DecodedInstruction decoded = decode_instruction(instr_word);
-
-            // Print key architectural state *before* the instruction is simulated (optional, but can be useful)
-            DBG_PRINT("[FS_TRACE] PRE  PC=0x%03X: %s (Op:0x%X Rd:%d Rs:%d Rt:%d Imm:%d) || R1=%d R8=%d R10=%d R11=%d\n",
-                    pc_before_simulate,
-                    opcode_to_string(decoded.opcode), // Ensure opcode_to_string is available
-                    decoded.opcode, decoded.rd, decoded.rs, decoded.rt, decoded.immediate,
-                    state.registers[1], state.registers[8], state.registers[10], state.registers[11]);
-
-            simulate_instruction(decoded);
-
-            // Key PC logging
-            uint32_t key_pcs[] = {0, 4, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60, 64, 68, 72, 76, 80, 84, 88, 92, 96};
-            int num_key_pcs = sizeof(key_pcs) / sizeof(uint32_t);
-            int log_this_instruction = 0;
-            for (int i = 0; i < num_key_pcs; i++) {
-                if (state.pc == key_pcs[i]) {
-                    log_this_instruction = 1;
-                    break;
-                }
-            }
-            // Always log branch decisions & HALT
-            if (decoded.opcode == BEQ || decoded.opcode == BZ || decoded.opcode == JR || decoded.opcode == HALT) {
-                log_this_instruction = 1;
+        } else {
+            run_functional_simulation(ctx);
+        }
+        host_perf_enter(HOST_PHASE_OTHER, ctx);
+        progress_finish(ctx);
+        live_stats_close(ctx);
+        if (checkpoint_at && !ctx->halted) {
+            status = checkpoint_save(ctx, checkpoint_out);
+            if (status == 0) {
+                printf("Checkpoint saved to '%s' after %llu instructions (PC=%u)\n", checkpoint_out,
+                       (unsigned long long)ctx->total_instructions, ctx->state.pc);
             }
+        } else {
+            print_final_state(ctx);
+            if (use_result_cache) result_cache_store(ctx, cache_dir, input_memory, mode);
+            if (checkpoint_out) status = checkpoint_save(ctx, checkpoint_out);
+        }
+        sim_context_destroy(ctx);
+        predecode_release(image);
+        return status == 0 ? 0 : 1;
+    }
 
-            if (log_this_instruction) {
-                DBG_PRINTF("[FS_COMMIT] PC=0x%03X; Op=%-4s(0x%02X); Rd=%2d,Rs=%2d,Rt=%2d,Imm=%-6d || R1=%-4d,R2=%-4d,R3=%-4d,R4=%-4d,R5=%-3d,R6=%-3d,R8=%-4d,R10=%-2d,R11=%-2d,R12=%-2d || NextPC=0x%03X\n",
-                       state.pc, 
-                       opcode_to_string(decoded.opcode), decoded.opcode,
-                       decoded.rd, decoded.rs, decoded.rt, decoded.immediate,
-                       state.registers[1], state.registers[2], state.registers[3], state.registers[4],
-                       state.registers[5], state.registers[6], state.registers[8], state.registers[10],
-                       state.registers[11], state.registers[12], 
-                       state.pc); // state.pc is the PC for the *next* instruction
-                fflush(stdout);
-            }
+    // A checkpoint of a finished run has nothing left to simulate
+    if (restored && ctx->halted && (strcmp(mode, "NF") == 0 || strcmp(mode, "WF") == 0)) {
+        print_final_state(ctx);
+        sim_context_destroy(ctx);
+        return 0;
+    }
 
-            if (decoded.opcode == HALT) {
-                break; // simulate_instruction() for HALT will call exit(0) and print_final_state()
-            }
+    // Split mode: the timing comes from trace-driven models fed by the functional run.
+    // Not stored in the result cache: on a cycle limit the functional state has run ahead.
+    if (use_split && (strcmp(mode, "NF") == 0 || strcmp(mode, "WF") == 0)) {
+        int status = run_split_mode(ctx, mode, split_modes);
+        live_stats_close(ctx); // Final values only: the split threads do not step the context
+        if (status == 0 && checkpoint_out) status = checkpoint_save(ctx, checkpoint_out);
+        sim_context_destroy(ctx);
+        predecode_release(image);
+        return status == 0 ? 0 : 1;
+    }
+
+    // Hybrid run: functional fast-forward, then the pipeline takes over from that state
+    static SimContext handoff; // Counters and state at the hand-off (large; one per process)
+    unsigned long long fast_forwarded = 0;
+    if (use_ff) {
+        host_perf_enter(HOST_PHASE_FS, ctx);
+        fast_forwarded = run_fast_forward(ctx, ff_count, ff_pc);
+        host_perf_enter(HOST_PHASE_OTHER, ctx);
+        handoff = *ctx;
+        if (ctx->halted) {
+            progress_finish(ctx);
+            live_stats_close(ctx);
+            print_final_state(ctx);
+            printf("Fast-forward: program finished after %llu instructions; no detailed region\n", fast_forwarded);
+            int status = checkpoint_out ? checkpoint_save(ctx, checkpoint_out) : 0;
+            sim_context_destroy(ctx);
+            predecode_release(image);
+            return status == 0 ? 0 : 1;
         }
-        // If HALT doesn't exit, ensure print_final_state is called
-        // print_final_state(); // Called by HALT instruction in simulate_instruction
-        DBG_PRINTF("[FS_FOCUS_TRACE_END]\n");
-        print_final_state();
-        return 0;
+    }
+    int resume = restored || use_ff; // Continue from the current architectural state
+
+    // Pipeline viewer export only applies to the timing simulators
+    if (kanata_file && (strcmp(mode, "NF") == 0 || strcmp(mode, "WF") == 0)) {
+        ctx->kanata = kanata_open(kanata_file);
+        if (!ctx->kanata) {
+            sim_context_destroy(ctx);
+            predecode_release(image);
+            return 1;
+        }
+        kanata_set_cycle_window(ctx->kanata, kanata_cycle_lo, kanata_cycle_hi);
+        kanata_set_pc_window(ctx->kanata, (uint32_t)kanata_pc_lo, (uint32_t)kanata_pc_hi);
+    }
 
-    } else if (strcmp(mode, "NF") == 0) {
+    // Per-PC profile of the pipeline run (of the detailed region after a fast-forward)
+    static PcProfile pc_profile;
+    if (pc_profile_rows >= 0) {
+        pc_profile_init(&pc_profile, pc_profile_rows);
+        ctx->pc_profile = &pc_profile;
+    }
+
+    if (strcmp(mode, "NF") == 0) {
         // Run no-forwarding pipeline simulator
-        simulate_pipeline_no_forwarding();
+        host_perf_enter(HOST_PHASE_NF, ctx);
+        if (resume) {
+            resume_pipeline(ctx); // Empty pipeline at the current PC, counters carried on
+            while (!step_pipeline_no_forwarding(ctx)) {
+                // One clock cycle per step
+            }
+            print_final_state(ctx);
+            if (use_ff) print_detailed_region(ctx, &handoff, fast_forwarded);
+        } else {
+            simulate_pipeline_no_forwarding(ctx);
+        }
+        host_perf_enter(HOST_PHASE_OTHER, ctx);
+        if (ctx->pc_profile) pc_profile_print(ctx->pc_profile);
+        kanata_close(ctx->kanata);
+        progress_finish(ctx);
+        live_stats_close(ctx);
+        if (use_result_cache) result_cache_store(ctx, cache_dir, input_memory, mode);
+        int status = checkpoint_out ? checkpoint_save(ctx, checkpoint_out) : 0;
+        sim_context_destroy(ctx);
+        predecode_release(image);
         // Final state will be printed by the pipeline simulator (no_fwd.c) itself when HALT hits WB.
         // It might also call print_final_state from functional_sim if the HALT instruction in WB calls simulate_instruction.
         // As per previous problem context, this is handled.
-        return 0;
+        return status == 0 ? 0 : 1;
 
     } else if (strcmp(mode, "WF") == 0) {
         // Run pipeline simulator with forwarding.
-        simulate_pipeline_with_forwarding();
-        return 0;
+        host_perf_enter(HOST_PHASE_WF, ctx);
+        if (resume) {
+            resume_pipeline_fwd(ctx);
+            while (!step_pipeline_with_forwarding(ctx)) {
+                // One clock cycle per step
+            }
+            print_final_state(ctx);
+            if (use_ff) print_detailed_region(ctx, &handoff, fast_forwarded);
+        } else {
+            simulate_pipeline_with_forwarding(ctx);
+        }
+        host_perf_enter(HOST_PHASE_OTHER, ctx);
+        if (ctx->pc_profile) pc_profile_print(ctx->pc_profile);
+        kanata_close(ctx->kanata);
+        progress_finish(ctx);
+        live_stats_close(ctx);
+        if (use_result_cache) result_cache_store(ctx, cache_dir, input_memory, mode);
+        int status = checkpoint_out ? checkpoint_save(ctx, checkpoint_out) : 0;
+        sim_context_destroy(ctx);
+        predecode_release(image);
+        return status == 0 ? 0 : 1;
 
     } else {
         fprintf(stderr, "Error: Invalid mode. Use 'FS' for Functional Simulator, 'NF' for No Forwarding Pipeline Simulator, or 'WF' for Forwarding Pipeline Simulator.\n");
+        sim_context_destroy(ctx);
+        predecode_release(image);
         return 1;
     }
 }
+
+#endif // MIPSLITE_LIBRARY
@@ -21,30 +21,19 @@ typedef struct {
     uint32_t memory[1024]; // Simulated memory (4KB)
 } MachineState;
 
-// Instruction type externs
-extern int total_instructions;
-extern int arithmetic_instructions;
-extern int logical_instructions;
-extern int memory_access_instructions;
-extern int control_transfer_instructions;
-
-// Declare clock_cycles as extern (defined in no_fwd.c)
-extern int clock_cycles;
-extern int total_stalls;
-
-// Register Written Array (for final output tracking)
-extern int register_written[32];
-extern int memory_changed[1024];
-
-// Extern declaration so other modules can access it
-extern MachineState state;
+// Simulator context (defined in sim_context.h). All simulation state lives in a context
+// so that several simulations can run in one process, e.g. on different threads.
+typedef struct SimContext SimContext;
 
 // Function prototypes
-void initialize_machine_state();
-void simulate_instruction(DecodedInstruction instr);
-void print_final_state();
-
-// Global flag, set to 1 when “–d” or “--debug” is passed on the command line:
+void initialize_machine_state(SimContext *ctx);
+void simulate_instruction(SimContext *ctx, DecodedInstruction instr);
+int step_functional(SimContext *ctx);
+void run_functional_simulation(SimContext *ctx);
+void print_final_state(const SimContext *ctx);
+
+// Global flag, set to 1 when “–d” or “--debug” is passed on the command line.
+// Set once at startup and only read afterwards, so it is safe to share between contexts.
 extern int debug_enabled;
 
 // Helper macro: calls printf only when debug_enabled is true.
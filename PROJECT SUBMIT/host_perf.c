@@ -0,0 +1,224 @@
+/*
+* Host Performance Counters
+* This file implements the --host-counters instrumentation. host_perf_start() opens one
+* perf_event_open counter per event for this thread (user space only, so it works at the
+* default perf_event_paranoid level); host_perf_enter() reads them, charges the deltas
+* and the wall-clock time to the phase being left, and, given the context, the simulated
+* instructions and cycles of the loop phases. The state is process-wide: counters belong
+* to the thread and are only used by the single-run driver.
+*
+* Supported Operations:
+* - Host cycles, instructions, branch misses and cache misses per phase
+* - Scaling when the kernel multiplexes the counters
+* - Per simulated instruction and per simulated cycle figures for the loops
+* - Wall-clock time only when perf counters are unavailable (no kernel support,
+*   permissions, containers)
+*
+* Functions:
+* - host_perf_start: Opens the counters and starts the first phase.
+* - host_perf_enter: Switches phases (no-op unless started).
+* - host_perf_report: Prints the table to stderr and closes the counters.
+*/
+
+#include "host_perf.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "sim_context.h"
+#include "sim_util.h" // For sim_util_now_ns
+
+static const char *host_phase_names[HOST_NUM_PHASES] = {
+    "Other (setup, output)", "Image load", "Decode", "FS loop", "NF cycle loop", "WF cycle loop"
+};
+static const char *host_event_names[HOST_NUM_EVENTS] = { "cycles", "instructions", "branch-misses", "cache-misses" };
+
+// Process-wide state (only touched by the thread that called host_perf_start)
+static struct {
+    int started;
+    int fd[HOST_NUM_EVENTS];          // -1 when the event is unavailable
+    int open_errno;                   // Why the first unavailable event failed
+    int multiplexed;                  // 1 if any reading had to be scaled
+    int phase;                        // Current phase
+    uint64_t last[HOST_NUM_EVENTS];   // Readings at the last switch
+    uint64_t last_ns;
+    uint64_t last_instructions, last_cycles; // Simulated counters at the last switch with a context
+    uint64_t events[HOST_NUM_PHASES][HOST_NUM_EVENTS];
+    uint64_t wall_ns[HOST_NUM_PHASES];
+    uint64_t sim_instructions[HOST_NUM_PHASES];
+    uint64_t sim_cycles[HOST_NUM_PHASES];
+    int visited[HOST_NUM_PHASES];
+} host_perf = { .fd = { -1, -1, -1, -1 } };
+
+/*
+* Opens a counter for a hardware event of the calling thread.
+* Returns the file descriptor, or -1 (errno set) if the host does not provide it.
+*/
+static int open_counter(int event) {
+#ifdef __linux__
+    static const uint64_t configs[HOST_NUM_EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES
+    };
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = configs[event];
+    attr.exclude_kernel = 1; // Allowed without privileges at perf_event_paranoid <= 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    (void)event;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+/*
+* Reads a counter, scaled up if the kernel only counted part of the time.
+*/
+static uint64_t read_counter(int fd) {
+    uint64_t values[3]; // Value, time enabled, time running
+    if (read(fd, values, sizeof(values)) != (ssize_t)sizeof(values)) return 0;
+    if (values[2] == 0) return 0;
+    if (values[2] < values[1]) {
+        host_perf.multiplexed = 1;
+        return (uint64_t)((double)values[0] * (double)values[1] / (double)values[2]);
+    }
+    return values[0];
+}
+
+/*
+* Opens the counters and starts timing in HOST_PHASE_OTHER. Events the host does not
+* provide are left out; the run continues in any case.
+*/
+void host_perf_start(void) {
+    host_perf.started = 1;
+    for (int e = 0; e < HOST_NUM_EVENTS; e++) {
+        host_perf.fd[e] = open_counter(e);
+        if (host_perf.fd[e] < 0 && !host_perf.open_errno) host_perf.open_errno = errno;
+        host_perf.last[e] = host_perf.fd[e] >= 0 ? read_counter(host_perf.fd[e]) : 0;
+    }
+    host_perf.phase = HOST_PHASE_OTHER;
+    host_perf.visited[HOST_PHASE_OTHER] = 1;
+    host_perf.last_ns = sim_util_now_ns();
+}
+
+/*
+* Switches to a new phase, charging everything since the last switch to the current one.
+* With a context, the simulated instructions and cycles since the last switch with a
+* context are charged too (only loop phases simulate). Returns the phase left, so a
+* nested phase can be undone with host_perf_enter(previous, ...).
+*/
+int host_perf_enter(int phase, const SimContext *ctx) {
+    int previous = host_perf.phase;
+    if (!host_perf.started) return previous;
+
+    for (int e = 0; e < HOST_NUM_EVENTS; e++) {
+        if (host_perf.fd[e] < 0) continue;
+        uint64_t now = read_counter(host_perf.fd[e]);
+        if (now > host_perf.last[e]) host_perf.events[previous][e] += now - host_perf.last[e];
+        host_perf.last[e] = now;
+    }
+    uint64_t now_ns = sim_util_now_ns();
+    host_perf.wall_ns[previous] += now_ns - host_perf.last_ns;
+    host_perf.last_ns = now_ns;
+
+    if (ctx) {
+        // Restores and fast-forward hand-offs move the counters outside the loops; only loops count
+        if (previous == HOST_PHASE_FS || previous == HOST_PHASE_NF || previous == HOST_PHASE_WF) {
+            host_perf.sim_instructions[previous] += ctx->total_instructions - host_perf.last_instructions;
+            host_perf.sim_cycles[previous] += ctx->clock_cycles - host_perf.last_cycles;
+        }
+        host_perf.last_instructions = ctx->total_instructions;
+        host_perf.last_cycles = ctx->clock_cycles;
+    }
+
+    host_perf.phase = phase;
+    host_perf.visited[phase] = 1;
+    return previous;
+}
+
+/*
+* Prints one figure per unit, or "-" when the event or the unit count is missing.
+*/
+static void print_ratio(int available, uint64_t value, uint64_t units) {
+    if (available && units) {
+        fprintf(stderr, " %12.2f", (double)value / (double)units);
+    } else {
+        fprintf(stderr, " %12s", "-");
+    }
+}
+
+/*
+* Charges the final phase, prints the table to stderr and closes the counters.
+*/
+void host_perf_report(void) {
+    if (!host_perf.started) return;
+    host_perf_enter(HOST_PHASE_OTHER, NULL);
+    fflush(stdout); // The table follows the simulator output
+
+    int available = 0;
+    for (int e = 0; e < HOST_NUM_EVENTS; e++) available += host_perf.fd[e] >= 0;
+
+    fprintf(stderr, "Host counters (user space, this thread):\n");
+    if (available < HOST_NUM_EVENTS) {
+        fprintf(stderr, "  Unavailable:");
+        for (int e = 0; e < HOST_NUM_EVENTS; e++) {
+            if (host_perf.fd[e] < 0) fprintf(stderr, " %s", host_event_names[e]);
+        }
+        fprintf(stderr, " (perf_event_open: %s; see /proc/sys/kernel/perf_event_paranoid)\n",
+                strerror(host_perf.open_errno));
+    }
+    fprintf(stderr, "  %-22s %10s %14s %14s %12s %12s\n", "Phase", "Wall ms", host_event_names[HOST_CYCLES],
+            host_event_names[HOST_INSTRUCTIONS], host_event_names[HOST_BRANCH_MISSES],
+            host_event_names[HOST_CACHE_MISSES]);
+    for (int p = 0; p < HOST_NUM_PHASES; p++) {
+        if (!host_perf.visited[p]) continue;
+        fprintf(stderr, "  %-22s %10.3f", host_phase_names[p], (double)host_perf.wall_ns[p] / 1e6);
+        for (int e = 0; e < HOST_NUM_EVENTS; e++) {
+            int width = e < HOST_BRANCH_MISSES ? 14 : 12;
+            if (host_perf.fd[e] >= 0) {
+                fprintf(stderr, " %*llu", width, (unsigned long long)host_perf.events[p][e]);
+            } else {
+                fprintf(stderr, " %*s", width, "-");
+            }
+        }
+        fprintf(stderr, "\n");
+    }
+
+    // The loops, per unit of simulated work
+    fprintf(stderr, "  %-22s %12s %12s %12s %12s %12s\n", "Per simulated unit", "ns", host_event_names[HOST_CYCLES],
+            host_event_names[HOST_INSTRUCTIONS], host_event_names[HOST_BRANCH_MISSES],
+            host_event_names[HOST_CACHE_MISSES]);
+    for (int p = HOST_PHASE_FS; p < HOST_NUM_PHASES; p++) {
+        if (!host_perf.visited[p]) continue;
+        for (int per_cycle = 0; per_cycle <= (p != HOST_PHASE_FS); per_cycle++) {
+            uint64_t units = per_cycle ? host_perf.sim_cycles[p] : host_perf.sim_instructions[p];
+            char label[48];
+            snprintf(label, sizeof(label), "%.2s per %s", host_phase_names[p], per_cycle ? "cycle" : "instruction");
+            fprintf(stderr, "  %-22s", label);
+            print_ratio(1, host_perf.wall_ns[p], units);
+            for (int e = 0; e < HOST_NUM_EVENTS; e++) print_ratio(host_perf.fd[e] >= 0, host_perf.events[p][e], units);
+            fprintf(stderr, "\n");
+        }
+    }
+    if (!host_perf.visited[HOST_PHASE_DECODE]) {
+        fprintf(stderr, "  (Instructions are decoded inside the loops; --predecode makes decoding a separate phase.)\n");
+    }
+    if (host_perf.multiplexed) fprintf(stderr, "  (Counters were multiplexed by the kernel; values are scaled.)\n");
+
+    for (int e = 0; e < HOST_NUM_EVENTS; e++) {
+        if (host_perf.fd[e] >= 0) close(host_perf.fd[e]);
+        host_perf.fd[e] = -1;
+    }
+    host_perf.started = 0;
+}
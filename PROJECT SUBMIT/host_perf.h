@@ -0,0 +1,43 @@
+/*
+* Host Performance Counters Header File
+* This header file declares the optional host counter instrumentation of a simulator run
+* (--host-counters): host cycles, instructions, branch misses and cache misses of this
+* process, read with perf_event_open at every phase change and charged to the phase being
+* left (image load, decode, the FS loop, the NF and WF cycle loops). Counters the host
+* does not provide are reported as unavailable; wall-clock time is always measured.
+*/
+
+#ifndef HOST_PERF_H
+#define HOST_PERF_H
+
+#include <stdint.h>
+
+// Phases of a run (a phase switch reads the counters, so phases are coarse)
+typedef enum {
+    HOST_PHASE_OTHER,  // Option parsing, setup and printing the results
+    HOST_PHASE_LOAD,   // Reading the memory image or checkpoint
+    HOST_PHASE_DECODE, // Predecoding the image (--predecode; otherwise decode is inline in the loops)
+    HOST_PHASE_FS,     // Functional loop (FS mode and --ff)
+    HOST_PHASE_NF,     // No-forwarding pipeline cycle loop
+    HOST_PHASE_WF,     // Forwarding pipeline cycle loop
+    HOST_NUM_PHASES
+} HostPhase;
+
+// Host events counted
+typedef enum {
+    HOST_CYCLES,
+    HOST_INSTRUCTIONS,
+    HOST_BRANCH_MISSES,
+    HOST_CACHE_MISSES,
+    HOST_NUM_EVENTS
+} HostEvent;
+
+// Simulator context (defined in sim_context.h)
+typedef struct SimContext SimContext;
+
+// Function prototypes
+void host_perf_start(void);
+int host_perf_enter(int phase, const SimContext *ctx);
+void host_perf_report(void);
+
+#endif // HOST_PERF_H
@@ -14,6 +14,7 @@
 * - get_instruction_type: Determines the type of instruction based on the opcode.
 * - decode_instruction: Decodes a binary instruction into a structured format.
 * - opcode_to_string: Converts an opcode to its string representation.
+* - format_instruction: Formats a decoded instruction as assembly-style text.
 *
 */
 
@@ -113,13 +114,49 @@ const char* opcode_to_string(Opcode op) {
     }
 }
 
+/*
+* Instruction Formatting
+* This function writes an assembly-style rendering of a decoded instruction
+* (e.g. "ADDI R1, R0, 1000", "LDW R3, 0(R1)", "BEQ R10, R11, 13") into buf.
+* It is used by the pipeline viewer export and the profiling listings.
+*/
+void format_instruction(DecodedInstruction instr, char *buf, size_t buf_len) {
+    const char *name = opcode_to_string(instr.opcode);
+
+    switch (instr.opcode) {
+        case ADD: case SUB: case MUL:
+        case OR: case AND: case XOR:
+            snprintf(buf, buf_len, "%s R%d, R%d, R%d", name, instr.rd, instr.rs, instr.rt);
+            break;
+        case ADDI: case SUBI: case MULI:
+        case ORI: case ANDI: case XORI:
+            snprintf(buf, buf_len, "%s R%d, R%d, %d", name, instr.rt, instr.rs, instr.immediate);
+            break;
+        case LDW: case STW:
+            snprintf(buf, buf_len, "%s R%d, %d(R%d)", name, instr.rt, instr.immediate, instr.rs);
+            break;
+        case BZ:
+            snprintf(buf, buf_len, "%s R%d, %d", name, instr.rs, instr.immediate);
+            break;
+        case BEQ:
+            snprintf(buf, buf_len, "%s R%d, R%d, %d", name, instr.rs, instr.rt, instr.immediate);
+            break;
+        case JR:
+            snprintf(buf, buf_len, "%s R%d", name, instr.rs);
+            break;
+        default: // HALT, NOP and unknown opcodes carry no operands
+            snprintf(buf, buf_len, "%s", name);
+            break;
+    }
+}
+
 /*
 * Process Binary Instruction
 * This function takes a binary instruction value, decodes it,
-* and simulates the instruction using the global state.
+* and simulates the instruction on the given simulation context.
 * It is the entry point for processing binary instructions in the functional simulator.
 */
-void process_binary(unsigned int value) {
+void process_binary(SimContext *ctx, unsigned int value) {
     DecodedInstruction decoded = decode_instruction(value);
-    simulate_instruction(decoded);
+    simulate_instruction(ctx, decoded);
 }
@@ -9,6 +9,7 @@
 #define INSTRUCTION_DECODER_H
 
 #include <stdint.h>
+#include <stddef.h> // For size_t
 
 // Enum for opcodes (added NOP)
 typedef enum {
@@ -42,6 +43,8 @@ typedef struct {
 InstrType get_instruction_type(uint8_t opcode);
 DecodedInstruction decode_instruction(uint32_t instr);
 const char* opcode_to_string(Opcode op);
-void process_binary(unsigned int value); // For functional sim
+void format_instruction(DecodedInstruction instr, char *buf, size_t buf_len); // Assembly-style text
+typedef struct SimContext SimContext;
+void process_binary(SimContext *ctx, unsigned int value); // For functional sim
 
 #endif // INSTRUCTION_DECODER_H
@@ -0,0 +1,229 @@
+/*
+* Kanata Pipeline Log Export
+* This file streams the per-cycle pipeline occupancy of the NF and WF simulators
+* into the Kanata log format (version 0004) used by the Konata pipeline viewer.
+* Only changes are written: a stage entry when an instruction moves, a retire when it
+* leaves WB, and a flush when it disappears from an earlier stage.
+* Stalls, flushes and forwarding events are attached to instructions as annotations.
+*
+* Supported Operations:
+* - Stage entry per instruction (IF, ID, EX, MEM, WB)
+* - Retire and flush records
+* - Stall/flush/forwarding annotations and dependency arrows
+* - Windowing by cycle range and by PC range (in-flight instructions are flushed with a
+*   "window end" annotation when the run passes the end of the cycle window)
+*
+* Functions:
+* - kanata_open: Opens the output file and writes the Kanata header lazily.
+* - kanata_set_cycle_window: Limits export to a range of cycles.
+* - kanata_set_pc_window: Limits export to instructions within a range of PCs.
+* - kanata_record_cycle: Records the pipeline contents for one cycle.
+* - kanata_annotate: Attaches a text annotation to an in-flight instruction.
+* - kanata_dependency: Draws a producer -> consumer arrow (used for forwarding).
+* - kanata_close: Retires whatever is left in the pipeline and closes the file.
+*/
+
+#include "kanata.h"
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "instruction_decoder.h"
+
+#define KANATA_OUTPUT_BUFFER (1 << 20) // Large stdio buffer, logs of long runs are big
+
+static const char *kanata_stage_names[KANATA_STAGES] = { "IF", "ID", "EX", "MEM", "WB" };
+
+/*
+* Opens a Kanata log file for writing.
+* Returns a new writer with no windowing, or NULL if the file cannot be opened.
+*/
+KanataWriter *kanata_open(const char *filename) {
+    FILE *out = fopen(filename, "w");
+    if (!out) {
+        perror("Error opening Kanata log file");
+        return NULL;
+    }
+    setvbuf(out, NULL, _IOFBF, KANATA_OUTPUT_BUFFER);
+
+    KanataWriter *kw = calloc(1, sizeof(KanataWriter));
+    if (!kw) {
+        fclose(out);
+        return NULL;
+    }
+    kw->out = out;
+    kw->cycle_lo = 0;
+    kw->cycle_hi = UINT64_MAX;
+    kw->pc_lo = 0;
+    kw->pc_hi = UINT32_MAX;
+    return kw;
+}
+
+/*
+* Restricts the export to cycles lo..hi (inclusive).
+*/
+void kanata_set_cycle_window(KanataWriter *kw, uint64_t lo, uint64_t hi) {
+    kw->cycle_lo = lo;
+    kw->cycle_hi = hi;
+}
+
+/*
+* Restricts the export to instructions whose PC is within lo..hi (inclusive).
+*/
+void kanata_set_pc_window(KanataWriter *kw, uint32_t lo, uint32_t hi) {
+    kw->pc_lo = lo;
+    kw->pc_hi = hi;
+}
+
+/*
+* Looks up the Kanata id of an in-flight instruction by fetch sequence number.
+* Returns 1 and sets *id if the instruction is currently being exported.
+*/
+static int kanata_lookup(const KanataWriter *kw, uint64_t seq, uint64_t *id) {
+    if (seq == 0) return 0;
+    for (int s = 0; s < KANATA_STAGES; s++) {
+        if (kw->prev_seq[s] == seq) {
+            *id = kw->prev_id[s];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+* Returns 1 if any exported instruction is still in the pipeline.
+*/
+static int kanata_in_flight(const KanataWriter *kw) {
+    for (int s = 0; s < KANATA_STAGES; s++) {
+        if (kw->prev_seq[s] != 0) return 1;
+    }
+    return 0;
+}
+
+/*
+* Ends the cycle window: the instructions still in flight after the last exported cycle
+* are flushed (Kanata "R" type 1) with a "window end" annotation, so the viewer does not
+* show them stuck in a stage.
+*/
+static void kanata_end_window(KanataWriter *kw) {
+    if (!kanata_in_flight(kw)) return;
+
+    fprintf(kw->out, "C\t1\n");
+    for (int s = KANATA_STAGES - 1; s >= 0; s--) {
+        if (kw->prev_seq[s] == 0) continue;
+        fprintf(kw->out, "L\t%" PRIu64 "\t1\tC%" PRIu64 ": window end\\n\n", kw->prev_id[s], kw->last_cycle);
+        fprintf(kw->out, "R\t%" PRIu64 "\t0\t1\n", kw->prev_id[s]);
+        kw->prev_seq[s] = 0;
+    }
+}
+
+/*
+* Records the pipeline contents for one cycle.
+* Called at the start of each simulated cycle, after clock_cycles has been incremented,
+* so that pipeline_arr[s] holds the instruction occupying stage s during this cycle.
+*/
+void kanata_record_cycle(KanataWriter *kw, uint64_t cycle, const PipelineRegister pipeline_arr[]) {
+    if (cycle > kw->cycle_hi && kw->started) kanata_end_window(kw);
+    if (cycle < kw->cycle_lo || cycle > kw->cycle_hi) return;
+
+    if (!kw->started) {
+        fprintf(kw->out, "Kanata\t0004\nC=\t%" PRIu64 "\n", cycle);
+        kw->started = 1;
+    } else {
+        fprintf(kw->out, "C\t%" PRIu64 "\n", cycle - kw->last_cycle);
+    }
+    kw->last_cycle = cycle;
+
+    // Work out which exported instruction sits in each stage this cycle
+    uint64_t cur_seq[KANATA_STAGES];
+    uint64_t cur_id[KANATA_STAGES];
+    for (int s = 0; s < KANATA_STAGES; s++) {
+        const PipelineRegister *reg = &pipeline_arr[s];
+        cur_seq[s] = 0;
+        cur_id[s] = 0;
+        if (reg->valid && !is_nop(reg->instr) && reg->pc >= kw->pc_lo && reg->pc <= kw->pc_hi) {
+            cur_seq[s] = reg->seq;
+        }
+    }
+
+    // Instructions that left the pipeline: WB means retired, anything else was flushed
+    for (int s = 0; s < KANATA_STAGES; s++) {
+        if (kw->prev_seq[s] == 0) continue;
+        int still_here = 0;
+        for (int t = 0; t < KANATA_STAGES; t++) {
+            if (cur_seq[t] == kw->prev_seq[s]) still_here = 1;
+        }
+        if (still_here) continue;
+        if (s == WB) {
+            fprintf(kw->out, "R\t%" PRIu64 "\t%" PRIu64 "\t0\n", kw->prev_id[s], kw->retired++);
+        } else {
+            fprintf(kw->out, "R\t%" PRIu64 "\t0\t1\n", kw->prev_id[s]);
+        }
+    }
+
+    // Stage entries for new and advancing instructions
+    for (int s = 0; s < KANATA_STAGES; s++) {
+        if (cur_seq[s] == 0) continue;
+        uint64_t id;
+        if (kanata_lookup(kw, cur_seq[s], &id)) {
+            cur_id[s] = id;
+            if (kw->prev_seq[s] == cur_seq[s]) continue; // Stalled in place, stage continues
+        } else {
+            char text[64];
+            id = kw->next_id++;
+            cur_id[s] = id;
+            format_instruction(pipeline_arr[s].instr, text, sizeof(text));
+            fprintf(kw->out, "I\t%" PRIu64 "\t%" PRIu64 "\t0\n", id, cur_seq[s]);
+            fprintf(kw->out, "L\t%" PRIu64 "\t0\t%03X: %s\n", id, pipeline_arr[s].pc, text);
+        }
+        fprintf(kw->out, "S\t%" PRIu64 "\t0\t%s\n", id, kanata_stage_names[s]);
+    }
+
+    memcpy(kw->prev_seq, cur_seq, sizeof(cur_seq));
+    memcpy(kw->prev_id, cur_id, sizeof(cur_id));
+}
+
+/*
+* Attaches a mouse-over annotation (stall reason, flush, forwarding source) to an in-flight
+* instruction. Instructions outside the export window are silently ignored.
+*/
+void kanata_annotate(KanataWriter *kw, uint64_t seq, const char *fmt, ...) {
+    uint64_t id;
+    if (!kanata_lookup(kw, seq, &id)) return;
+
+    char text[128];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    fprintf(kw->out, "L\t%" PRIu64 "\t1\tC%" PRIu64 ": %s\\n\n", id, kw->last_cycle, text);
+}
+
+/*
+* Draws a dependency arrow from producer to consumer (Kanata "W" record).
+*/
+void kanata_dependency(KanataWriter *kw, uint64_t consumer_seq, uint64_t producer_seq) {
+    uint64_t consumer_id, producer_id;
+    if (!kanata_lookup(kw, consumer_seq, &consumer_id) || !kanata_lookup(kw, producer_seq, &producer_id)) return;
+    fprintf(kw->out, "W\t%" PRIu64 "\t%" PRIu64 "\t0\n", consumer_id, producer_id);
+}
+
+/*
+* Retires whatever is still in flight (at the end of a run this is HALT and anything older),
+* oldest first, and closes the log. Once the run has passed the cycle window nothing is in
+* flight any more (kanata_end_window flushed it).
+*/
+void kanata_close(KanataWriter *kw) {
+    if (!kw) return;
+    if (kw->started && kanata_in_flight(kw)) {
+        fprintf(kw->out, "C\t1\n");
+        for (int s = KANATA_STAGES - 1; s >= 0; s--) {
+            if (kw->prev_seq[s] == 0) continue;
+            fprintf(kw->out, "R\t%" PRIu64 "\t%" PRIu64 "\t0\n", kw->prev_id[s], kw->retired++);
+        }
+    }
+    fclose(kw->out);
+    free(kw);
+}
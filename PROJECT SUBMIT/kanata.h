@@ -0,0 +1,43 @@
+/*
+* Kanata Pipeline Log Export Header File
+* This header file defines the writer used to stream pipeline activity from the NF and WF
+* simulators into the Kanata log format read by the Konata pipeline viewer.
+* It includes the writer structure, windowing limits, and function prototypes.
+*/
+
+#ifndef KANATA_H
+#define KANATA_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "no_fwd.h" // For PipelineRegister and enum pipeline_stages
+
+#define KANATA_STAGES 5 // IF, ID, EX, MEM, WB
+
+/*
+* KanataWriter structure:
+* Holds the output stream, the optional cycle/PC windows, and the stage
+* occupancy seen at the previous cycle so that only changes are written.
+*/
+typedef struct {
+    FILE *out;
+    uint64_t cycle_lo, cycle_hi; // Only cycles in [cycle_lo, cycle_hi] are exported
+    uint32_t pc_lo, pc_hi;       // Only instructions with PC in [pc_lo, pc_hi] are exported
+    int started;                 // 1 once the "C=" line has been written
+    uint64_t last_cycle;         // Last cycle written (for "C <delta>" lines)
+    uint64_t next_id;            // Next file-unique Kanata instruction id
+    uint64_t retired;            // Retire counter (Kanata "rid")
+    uint64_t prev_seq[KANATA_STAGES]; // Fetch sequence number in each stage last cycle (0 = empty)
+    uint64_t prev_id[KANATA_STAGES];  // Kanata id for prev_seq[]
+} KanataWriter;
+
+// Function prototypes
+KanataWriter *kanata_open(const char *filename);
+void kanata_set_cycle_window(KanataWriter *kw, uint64_t lo, uint64_t hi);
+void kanata_set_pc_window(KanataWriter *kw, uint32_t lo, uint32_t hi);
+void kanata_record_cycle(KanataWriter *kw, uint64_t cycle, const PipelineRegister pipeline_arr[]);
+void kanata_annotate(KanataWriter *kw, uint64_t seq, const char *fmt, ...);
+void kanata_dependency(KanataWriter *kw, uint64_t consumer_seq, uint64_t producer_seq);
+void kanata_close(KanataWriter *kw);
+
+#endif // KANATA_H
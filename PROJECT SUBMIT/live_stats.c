@@ -0,0 +1,274 @@
+/*
+* Live Statistics
+* This file implements the live statistics of long runs. The counters page is a file
+* (by default in /dev/shm) mapped shared into the simulator and updated as a seqlock, so
+* a reader never sees a torn set of counters. SIGUSR1 only sets a flag; the next update
+* writes the full statistics as JSON (to a temporary file renamed into place) while the
+* run continues.
+*
+* Supported Operations:
+* - Counters page: instructions, cycles, stalls, flushes, PC, finished flag
+* - JSON snapshot on SIGUSR1: all counters, CPI, registers, watchdog state, elapsed time
+* - Reading a page from another process ("--stats-read")
+*
+* Functions:
+* - live_stats_open: Creates the counters page and/or installs the SIGUSR1 handler.
+* - live_stats_update: Refreshes the page and writes a requested snapshot.
+* - live_stats_close: Publishes the final values and removes the page.
+* - live_stats_read_main: Entry point of "--stats-read <page>".
+*/
+
+#include "live_stats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim_context.h"
+#include "sim_util.h" // For sim_util_now_ns
+
+// Set by the SIGUSR1 handler, cleared when the snapshot is written (one run per process)
+static volatile sig_atomic_t snapshot_requested = 0;
+
+/*
+* SIGUSR1 handler: only records the request (writing files is not async-signal-safe).
+*/
+static void live_stats_signal(int signo) {
+    (void)signo;
+    snapshot_requested = 1;
+}
+
+/*
+* Writes the full statistics of ctx as JSON to the snapshot path.
+* Returns 0 on success, -1 on error.
+*/
+static int write_snapshot(SimContext *ctx) {
+    LiveStats *ls = ctx->live_stats;
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp-%ld", ls->snapshot_path, (long)getpid());
+    FILE *out = fopen(tmp_path, "w");
+    if (!out) {
+        fprintf(stderr, "Warning: Cannot write stats snapshot '%s': %s\n", tmp_path, strerror(errno));
+        return -1;
+    }
+
+    static const char *stop_names[] = { "running", "cycle_budget", "instruction_budget", "livelock" };
+    double elapsed = (double)(sim_util_now_ns() - ls->start_ns) / 1e9;
+    fprintf(out, "{\n");
+    fprintf(out, "  \"pid\": %ld,\n", (long)getpid());
+    fprintf(out, "  \"mode\": \"%s\",\n", ls->mode);
+    fprintf(out, "  \"elapsed_s\": %.3f,\n", elapsed);
+    fprintf(out, "  \"halted\": %d,\n", ctx->halted);
+    fprintf(out, "  \"watchdog\": \"%s\",\n", stop_names[ctx->watchdog.stop]);
+    fprintf(out, "  \"pc\": %u,\n", ctx->state.pc);
+    fprintf(out, "  \"instructions\": %llu,\n", (unsigned long long)ctx->total_instructions);
+    fprintf(out, "  \"arithmetic\": %llu,\n", (unsigned long long)ctx->arithmetic_instructions);
+    fprintf(out, "  \"logical\": %llu,\n", (unsigned long long)ctx->logical_instructions);
+    fprintf(out, "  \"memory_access\": %llu,\n", (unsigned long long)ctx->memory_access_instructions);
+    fprintf(out, "  \"control_transfer\": %llu,\n", (unsigned long long)ctx->control_transfer_instructions);
+    fprintf(out, "  \"clock_cycles\": %llu,\n", (unsigned long long)ctx->clock_cycles);
+    fprintf(out, "  \"stalls\": %llu,\n", (unsigned long long)ctx->total_stalls);
+    fprintf(out, "  \"flushes\": %llu,\n", (unsigned long long)ctx->total_flushes);
+    fprintf(out, "  \"cpi\": %.4f,\n",
+            ctx->total_instructions ? (double)ctx->clock_cycles / (double)ctx->total_instructions : 0.0);
+    fprintf(out, "  \"instructions_per_second\": %.0f,\n",
+            elapsed > 0 ? (double)ctx->total_instructions / elapsed : 0.0);
+    fprintf(out, "  \"registers\": [");
+    for (int r = 0; r < 32; r++) {
+        fprintf(out, "%s%d", r ? ", " : "", ctx->state.registers[r]);
+    }
+    fprintf(out, "]\n}\n");
+
+    int failed = ferror(out);
+    if (fclose(out) != 0) failed = 1;
+    if (failed || rename(tmp_path, ls->snapshot_path) < 0) {
+        fprintf(stderr, "Warning: Cannot write stats snapshot '%s'\n", ls->snapshot_path);
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+* Sets up live statistics for a run in the given mode: a counters page at page_path
+* (NULL for none) and a SIGUSR1 handler writing JSON to snapshot_path (NULL for none).
+* Attach it with ctx->live_stats = ls. Returns 0 on success, -1 on error.
+*/
+int live_stats_open(LiveStats *ls, const char *page_path, const char *snapshot_path, const char *mode) {
+    memset(ls, 0, sizeof(LiveStats));
+    snprintf(ls->mode, sizeof(ls->mode), "%s", mode);
+    ls->snapshot_path = snapshot_path;
+    ls->start_ns = sim_util_now_ns();
+    ls->countdown = 1; // Publish on the first step
+
+    if (page_path) {
+        snprintf(ls->page_path, sizeof(ls->page_path), "%s", page_path);
+        int fd = open(page_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ftruncate(fd, sizeof(LiveStatsPage)) < 0) {
+            fprintf(stderr, "Error: Cannot create stats page '%s': %s\n", page_path, strerror(errno));
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+        void *map = mmap(NULL, sizeof(LiveStatsPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            fprintf(stderr, "Error: Cannot map stats page '%s': %s\n", page_path, strerror(errno));
+            unlink(page_path);
+            return -1;
+        }
+        ls->page = map;
+        memcpy(ls->page->magic, LIVE_STATS_MAGIC, 8);
+        ls->page->version = LIVE_STATS_VERSION;
+        ls->page->pid = (uint32_t)getpid();
+        memcpy(ls->page->mode, ls->mode, sizeof(ls->mode));
+    }
+
+    if (snapshot_path) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = live_stats_signal;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(SIGUSR1, &sa, NULL) < 0) {
+            perror("Error installing SIGUSR1 handler");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+* Refreshes the counters page and writes a snapshot if SIGUSR1 has arrived since the last
+* update (called through LIVE_STATS_UPDATE every LIVE_STATS_INTERVAL steps).
+*/
+void live_stats_update(SimContext *ctx) {
+    LiveStats *ls = ctx->live_stats;
+    ls->countdown = LIVE_STATS_INTERVAL;
+
+    LiveStatsPage *page = ls->page;
+    if (page) {
+        uint64_t seq = atomic_load_explicit(&page->seq, memory_order_relaxed);
+        atomic_store_explicit(&page->seq, seq + 1, memory_order_relaxed); // Odd: update in progress
+        atomic_thread_fence(memory_order_release);
+        page->instructions = ctx->total_instructions;
+        page->clock_cycles = ctx->clock_cycles;
+        page->stalls = ctx->total_stalls;
+        page->flushes = ctx->total_flushes;
+        page->pc = ctx->state.pc;
+        page->halted = (uint32_t)ctx->halted;
+        page->updated_ns = sim_util_now_ns();
+        atomic_store_explicit(&page->seq, seq + 2, memory_order_release);
+    }
+
+    if (snapshot_requested && ls->snapshot_path) {
+        snapshot_requested = 0;
+        write_snapshot(ctx);
+    }
+}
+
+/*
+* Publishes the final values (with the finished flag set), writes a snapshot still pending,
+* then unmaps and removes the counters page.
+*/
+void live_stats_close(SimContext *ctx) {
+    LiveStats *ls = ctx->live_stats;
+    if (!ls) return;
+
+    int halted = ctx->halted;
+    ctx->halted = 1; // Final values, also when a watchdog or checkpoint stopped the run early
+    live_stats_update(ctx);
+    ctx->halted = halted;
+
+    if (ls->snapshot_path) signal(SIGUSR1, SIG_DFL);
+    if (ls->page) {
+        munmap(ls->page, sizeof(LiveStatsPage));
+        unlink(ls->page_path);
+        ls->page = NULL;
+    }
+    ctx->live_stats = NULL;
+}
+
+/*
+* Reads a consistent copy of a counters page.
+* Returns 0 on success, -1 if the page is not valid.
+*/
+static int read_page(LiveStatsPage *page, LiveStatsPage *copy) {
+    for (;;) {
+        uint64_t before = atomic_load_explicit(&page->seq, memory_order_acquire);
+        memcpy(copy, page, sizeof(LiveStatsPage));
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t after = atomic_load_explicit(&page->seq, memory_order_relaxed);
+        if (before == after && (before & 1) == 0) break;
+        sched_yield();
+    }
+    if (memcmp(copy->magic, LIVE_STATS_MAGIC, 8) != 0 || copy->version != LIVE_STATS_VERSION) return -1;
+    return 0;
+}
+
+/*
+* Entry point for "<prog> --stats-read <page> [--watch=<seconds>]": prints the counters of a
+* running simulator as one JSON line, or one line per interval until the run finishes.
+* Returns 0 on success, 2 on errors.
+*/
+int live_stats_read_main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s --stats-read <page> [--watch=<seconds>]\n", argv[0]);
+        return 2;
+    }
+    double watch = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strncmp(argv[i], "--watch=", 8) == 0) {
+            char *end;
+            watch = strtod(argv[i] + 8, &end);
+            if (end == argv[i] + 8 || *end != '\0' || watch <= 0) {
+                fprintf(stderr, "Error: Invalid watch interval '%s'\n", argv[i] + 8);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+
+    int fd = open(argv[1], O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot open stats page '%s': %s\n", argv[1], strerror(errno));
+        return 2;
+    }
+    void *map = mmap(NULL, sizeof(LiveStatsPage), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Error: Cannot map stats page '%s': %s\n", argv[1], strerror(errno));
+        return 2;
+    }
+
+    int status = 0;
+    for (;;) {
+        LiveStatsPage copy;
+        if (read_page(map, &copy) < 0) {
+            fprintf(stderr, "Error: '%s' is not a stats page\n", argv[1]);
+            status = 2;
+            break;
+        }
+        printf("{\"pid\": %u, \"mode\": \"%.3s\", \"halted\": %u, \"pc\": %u, \"instructions\": %llu, "
+               "\"clock_cycles\": %llu, \"stalls\": %llu, \"flushes\": %llu}\n",
+               copy.pid, copy.mode, copy.halted, copy.pc, (unsigned long long)copy.instructions,
+               (unsigned long long)copy.clock_cycles, (unsigned long long)copy.stalls,
+               (unsigned long long)copy.flushes);
+        fflush(stdout);
+        if (watch <= 0 || copy.halted) break;
+
+        struct timespec delay = { (time_t)watch, (long)((watch - (double)(time_t)watch) * 1e9) };
+        nanosleep(&delay, NULL);
+    }
+    munmap(map, sizeof(LiveStatsPage));
+    return status;
+}
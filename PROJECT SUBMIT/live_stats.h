@@ -0,0 +1,69 @@
+/*
+* Live Statistics Header File
+* This header file declares live statistics for long runs: a small memory-mapped counters
+* page that external tools can read while the simulator runs, and a full JSON snapshot
+* written when the process receives SIGUSR1. Both are serviced from the step functions
+* every LIVE_STATS_INTERVAL steps, so the hot loop only decrements a counter.
+*/
+
+#ifndef LIVE_STATS_H
+#define LIVE_STATS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define LIVE_STATS_MAGIC "MLSTATS1"
+#define LIVE_STATS_VERSION 1
+#define LIVE_STATS_INTERVAL 4096 // Steps (instructions for FS, cycles for NF/WF) between updates
+
+/*
+* LiveStatsPage structure:
+* Layout of the mapped file. The simulator writes it as a seqlock: seq is odd while an
+* update is in progress, so a reader copies the page and retries until it reads the same
+* even seq before and after the copy.
+*/
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t pid;
+    char mode[4];
+    uint32_t halted;        // 1 once the run has finished (final values)
+    _Atomic uint64_t seq;   // Plain 64-bit integer in the file
+    uint64_t instructions;
+    uint64_t clock_cycles;
+    uint64_t stalls;
+    uint64_t flushes;
+    uint32_t pc;
+    uint32_t reserved;
+    uint64_t updated_ns;    // CLOCK_MONOTONIC time of the last update
+} LiveStatsPage;
+
+/*
+* LiveStats structure:
+* Attached to a SimContext (owned by the caller).
+*/
+typedef struct {
+    LiveStatsPage *page;    // NULL when no counters page is published
+    char page_path[4096];
+    const char *snapshot_path; // JSON target for SIGUSR1, NULL when the signal is not handled
+    char mode[4];
+    uint64_t start_ns;
+    uint32_t countdown;     // Steps until the next update
+} LiveStats;
+
+// Simulator context (defined in sim_context.h)
+typedef struct SimContext SimContext;
+
+// Called by the step functions: cheap unless an update is due
+#define LIVE_STATS_UPDATE(ctx) \
+    do { \
+        if ((ctx)->live_stats && --(ctx)->live_stats->countdown == 0) live_stats_update(ctx); \
+    } while (0)
+
+// Function prototypes
+int live_stats_open(LiveStats *ls, const char *page_path, const char *snapshot_path, const char *mode);
+void live_stats_update(SimContext *ctx);
+void live_stats_close(SimContext *ctx);
+int live_stats_read_main(int argc, char *argv[]);
+
+#endif // LIVE_STATS_H
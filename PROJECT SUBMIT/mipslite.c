@@ -0,0 +1,285 @@
+/*
+* libmipslite
+* This file implements the embeddable simulator API declared in mipslite.h on top of
+* the per-run SimContext. Each handle keeps a copy of the loaded memory image so that
+* it can be reset and rerun without reloading, and drives the same step functions the
+* command line simulator uses, so results are identical to "sim <image> <mode>".
+*
+* Supported Operations:
+* - Create/destroy a FS, NF or WF simulator
+* - Load a memory image from a file or from a buffer
+* - Reset to the loaded image
+* - Step N instructions or N clock cycles, or run until HALT
+* - Read the PC, registers, memory and statistics
+*
+* Functions:
+* - mipslite_create: Allocates a simulator of the given mode.
+* - mipslite_destroy: Frees a simulator.
+* - mipslite_load_file: Loads a memory image file and resets.
+* - mipslite_load_buffer: Loads a memory image from an array of words and resets.
+* - mipslite_reset: Restores the loaded image and clears all state and statistics.
+* - mipslite_save_checkpoint, mipslite_load_checkpoint: Save/restore the architectural state.
+* - mipslite_step_instructions: Runs until N more instructions have committed.
+* - mipslite_step_cycles: Runs N clock cycles (NF/WF only).
+* - mipslite_run: Runs until HALT.
+* - mipslite_halted: Reports whether the run has finished.
+* - mipslite_set_budget: Sets the cycle/instruction budgets and livelock detection.
+* - mipslite_stop_reason: Reports whether the watchdog stopped the run, and why.
+* - mipslite_get_pc, mipslite_get_register, mipslite_read_memory, mipslite_get_stats: Accessors.
+*/
+
+#include "mipslite.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "functional_sim.h"
+#include "no_fwd.h"
+#include "with_fwd.h"
+#include "trace_reader.h"
+#include "sim_context.h"
+#include "checkpoint.h"
+
+/*
+* MipsLiteSim structure:
+* A simulator handle: the context being simulated and the image it was loaded from.
+*/
+struct MipsLiteSim {
+    MipsLiteMode mode;
+    SimContext *ctx;
+    uint32_t image[MIPSLITE_MEMORY_WORDS]; // Memory image restored by mipslite_reset
+};
+
+/*
+* Advances the simulator by one step of its model: one instruction for FS,
+* one clock cycle for NF and WF. Returns 1 once the run has finished.
+*/
+static int mipslite_step(MipsLiteSim *sim) {
+    switch (sim->mode) {
+        case MIPSLITE_NF:
+            return step_pipeline_no_forwarding(sim->ctx);
+        case MIPSLITE_WF:
+            return step_pipeline_with_forwarding(sim->ctx);
+        default:
+            return step_functional(sim->ctx);
+    }
+}
+
+/*
+* Allocates a simulator of the given mode with an empty (all zero) memory image.
+* Returns NULL if the mode is invalid or the allocation fails.
+*/
+MipsLiteSim *mipslite_create(MipsLiteMode mode) {
+    if (mode != MIPSLITE_FS && mode != MIPSLITE_NF && mode != MIPSLITE_WF) return NULL;
+
+    MipsLiteSim *sim = calloc(1, sizeof(MipsLiteSim));
+    if (!sim) return NULL;
+    sim->ctx = sim_context_create();
+    if (!sim->ctx) {
+        free(sim);
+        return NULL;
+    }
+    sim->mode = mode;
+    return sim;
+}
+
+/*
+* Frees a simulator.
+*/
+void mipslite_destroy(MipsLiteSim *sim) {
+    if (!sim) return;
+    sim_context_destroy(sim->ctx);
+    free(sim);
+}
+
+/*
+* Loads a memory image file (one hex word per line, as accepted by the command line
+* simulator) and resets the simulator. On error the previous image is kept.
+* Returns the number of words loaded, or -1 on error.
+*/
+int mipslite_load_file(MipsLiteSim *sim, const char *filename) {
+    uint32_t image[MIPSLITE_MEMORY_WORDS] = {0};
+    int words_loaded = read_memory_image(filename, image);
+    if (words_loaded < 0) return -1;
+
+    memcpy(sim->image, image, sizeof(sim->image));
+    mipslite_reset(sim);
+    return words_loaded;
+}
+
+/*
+* Loads a memory image from count words (at most MIPSLITE_MEMORY_WORDS) starting at
+* address 0 and resets the simulator. The rest of memory is zeroed.
+* Returns the number of words loaded, or -1 on error.
+*/
+int mipslite_load_buffer(MipsLiteSim *sim, const uint32_t *words, size_t count) {
+    if (count > MIPSLITE_MEMORY_WORDS || (!words && count > 0)) return -1;
+
+    memset(sim->image, 0, sizeof(sim->image));
+    if (count > 0) memcpy(sim->image, words, count * sizeof(uint32_t));
+    mipslite_reset(sim);
+    return (int)count;
+}
+
+/*
+* Restores the loaded memory image and clears registers, statistics and the pipeline.
+*/
+void mipslite_reset(MipsLiteSim *sim) {
+    sim_context_reset(sim->ctx);
+    memcpy(sim->ctx->state.memory, sim->image, sizeof(sim->image));
+}
+
+/*
+* Saves the simulator's architectural state and statistics to a checkpoint file.
+* Returns 0 on success, -1 on error.
+*/
+int mipslite_save_checkpoint(const MipsLiteSim *sim, const char *path) {
+    return checkpoint_save(sim->ctx, path);
+}
+
+/*
+* Restores a checkpoint file. The pipeline models resume with an empty pipeline fetching
+* from the checkpoint's PC. On error the simulator is left unchanged.
+* Returns 0 on success, -1 on error.
+*/
+int mipslite_load_checkpoint(MipsLiteSim *sim, const char *path) {
+    SimContext *loaded = sim_context_create();
+    if (!loaded) return -1;
+    if (checkpoint_load(loaded, path) < 0) {
+        sim_context_destroy(loaded);
+        return -1;
+    }
+
+    // Take over the restored state (a fresh context otherwise), keeping the attachments
+    loaded->kanata = sim->ctx->kanata;
+    loaded->predecode = sim->ctx->predecode;
+    loaded->progress = sim->ctx->progress;
+    loaded->live_stats = sim->ctx->live_stats;
+    loaded->watchdog.cfg = sim->ctx->watchdog.cfg;
+    *sim->ctx = *loaded;
+    sim_context_destroy(loaded);
+    if (sim->mode != MIPSLITE_FS) {
+        int halted = sim->ctx->halted;
+        if (sim->mode == MIPSLITE_WF) {
+            resume_pipeline_fwd(sim->ctx);
+        } else {
+            resume_pipeline(sim->ctx);
+        }
+        sim->ctx->halted = halted; // A finished run stays finished
+    }
+    return 0;
+}
+
+/*
+* Runs until count more instructions have committed or the run finishes.
+* Returns the number of instructions committed.
+*/
+int64_t mipslite_step_instructions(MipsLiteSim *sim, uint64_t count) {
+    SimContext *ctx = sim->ctx;
+    uint64_t start = ctx->total_instructions;
+    while (ctx->total_instructions - start < count) {
+        if (mipslite_step(sim)) break;
+    }
+    return (int64_t)(ctx->total_instructions - start);
+}
+
+/*
+* Runs count clock cycles, or fewer if the run finishes first.
+* Returns the number of cycles simulated, or -1 for FS, which has no notion of cycles.
+*/
+int64_t mipslite_step_cycles(MipsLiteSim *sim, uint64_t count) {
+    if (sim->mode == MIPSLITE_FS) return -1;
+
+    SimContext *ctx = sim->ctx;
+    uint64_t start = ctx->clock_cycles;
+    for (uint64_t i = 0; i < count; i++) {
+        if (mipslite_step(sim)) break;
+    }
+    return (int64_t)(ctx->clock_cycles - start);
+}
+
+/*
+* Runs until HALT (or the PC leaves memory, or the cycle limit is hit).
+* Returns 0 once the run has finished.
+*/
+int mipslite_run(MipsLiteSim *sim) {
+    while (!mipslite_step(sim)) {
+        // Nothing to do between steps
+    }
+    return 0;
+}
+
+/*
+* Returns 1 once the run has finished, 0 otherwise.
+*/
+int mipslite_halted(const MipsLiteSim *sim) {
+    return sim->ctx->halted;
+}
+
+/*
+* Sets the watchdog: max_cycles (NF/WF; 0 = the mode's default, UINT64_MAX = unlimited),
+* max_instructions (0 = unlimited) and whether an infinite loop stops the run. Kept across
+* resets and checkpoint restores.
+*/
+void mipslite_set_budget(MipsLiteSim *sim, uint64_t max_cycles, uint64_t max_instructions, int detect_livelock) {
+    sim->ctx->watchdog.cfg.max_cycles = max_cycles;
+    sim->ctx->watchdog.cfg.max_instructions = max_instructions;
+    sim->ctx->watchdog.cfg.detect_livelock = detect_livelock;
+}
+
+/*
+* Returns why the watchdog stopped the run: MIPSLITE_STOP_NONE while running or after a normal
+* finish; for MIPSLITE_STOP_LIVELOCK the looping PC range is stored in *loop_lo and *loop_hi
+* (either may be NULL).
+*/
+MipsLiteStop mipslite_stop_reason(const MipsLiteSim *sim, uint32_t *loop_lo, uint32_t *loop_hi) {
+    const Watchdog *wd = &sim->ctx->watchdog;
+    if (loop_lo) *loop_lo = wd->loop_lo;
+    if (loop_hi) *loop_hi = wd->loop_hi;
+    switch (wd->stop) {
+        case WATCHDOG_CYCLE_BUDGET: return MIPSLITE_STOP_CYCLE_BUDGET;
+        case WATCHDOG_INSTRUCTION_BUDGET: return MIPSLITE_STOP_INSTRUCTION_BUDGET;
+        case WATCHDOG_LIVELOCK: return MIPSLITE_STOP_LIVELOCK;
+        default: return MIPSLITE_STOP_NONE;
+    }
+}
+
+/*
+* Returns the architectural program counter.
+*/
+uint32_t mipslite_get_pc(const MipsLiteSim *sim) {
+    return sim->ctx->state.pc;
+}
+
+/*
+* Returns the value of register reg (0-31); out of range registers read as 0.
+*/
+int32_t mipslite_get_register(const MipsLiteSim *sim, int reg) {
+    if (reg < 0 || reg >= 32) return 0;
+    return sim->ctx->state.registers[reg];
+}
+
+/*
+* Reads the word at byte address (word aligned, below 4KB) into *value.
+* Returns 0 on success, -1 if the address is invalid.
+*/
+int mipslite_read_memory(const MipsLiteSim *sim, uint32_t address, uint32_t *value) {
+    if (address % 4 != 0 || address / 4 >= MIPSLITE_MEMORY_WORDS) return -1;
+    *value = sim->ctx->state.memory[address / 4];
+    return 0;
+}
+
+/*
+* Copies the instruction counts and timing statistics into *stats.
+*/
+void mipslite_get_stats(const MipsLiteSim *sim, MipsLiteStats *stats) {
+    const SimContext *ctx = sim->ctx;
+    stats->total_instructions = ctx->total_instructions;
+    stats->arithmetic_instructions = ctx->arithmetic_instructions;
+    stats->logical_instructions = ctx->logical_instructions;
+    stats->memory_access_instructions = ctx->memory_access_instructions;
+    stats->control_transfer_instructions = ctx->control_transfer_instructions;
+    stats->clock_cycles = ctx->clock_cycles;
+    stats->total_stalls = ctx->total_stalls;
+    stats->total_flushes = ctx->total_flushes;
+}
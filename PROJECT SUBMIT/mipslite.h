@@ -0,0 +1,88 @@
+/*
+* libmipslite Header File
+* This header file declares the embeddable C API of the MIPS-lite simulator, so that
+* test harnesses can load, step, run and inspect the FS, NF and WF simulators in process
+* instead of spawning the command line simulator and scraping its output.
+* Every simulator handle owns its own SimContext, so handles are independent and can be
+* used from different threads (one thread per handle).
+*
+* Building (all sources except the command line main, which MIPSLITE_LIBRARY leaves out):
+*   Static:  gcc -c -O2 -DMIPSLITE_LIBRARY *.c && ar rcs libmipslite.a *.o
+*   Shared:  gcc -O2 -fPIC -shared -DMIPSLITE_LIBRARY -o libmipslite.so *.c -lpthread -lm
+*   CLI:     gcc -O2 -o sim *.c -lpthread -lm
+* Programs linking the static library also need -lpthread -lm.
+*/
+
+#ifndef MIPSLITE_H
+#define MIPSLITE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MIPSLITE_MEMORY_WORDS 1024 // 4KB memory image
+
+// Simulator flavour of a handle
+typedef enum {
+    MIPSLITE_FS, // Functional simulator (no timing)
+    MIPSLITE_NF, // 5-stage pipeline without forwarding
+    MIPSLITE_WF  // 5-stage pipeline with forwarding
+} MipsLiteMode;
+
+/*
+* MipsLiteStats structure:
+* Instruction counts and timing statistics, the same numbers print_final_state() reports.
+* The timing fields stay 0 for FS.
+*/
+typedef struct {
+    uint64_t total_instructions;
+    uint64_t arithmetic_instructions;
+    uint64_t logical_instructions;
+    uint64_t memory_access_instructions;
+    uint64_t control_transfer_instructions;
+    uint64_t clock_cycles;
+    uint64_t total_stalls;
+    uint64_t total_flushes;
+} MipsLiteStats;
+
+// Why the watchdog stopped a run (see mipslite_stop_reason)
+typedef enum {
+    MIPSLITE_STOP_NONE,               // Still running, or finished normally
+    MIPSLITE_STOP_CYCLE_BUDGET,
+    MIPSLITE_STOP_INSTRUCTION_BUDGET,
+    MIPSLITE_STOP_LIVELOCK            // Architectural state repeated: the program loops forever
+} MipsLiteStop;
+
+// Opaque simulator handle
+typedef struct MipsLiteSim MipsLiteSim;
+
+// Lifetime
+MipsLiteSim *mipslite_create(MipsLiteMode mode);
+void mipslite_destroy(MipsLiteSim *sim);
+
+// Loading (both reset the simulator; return the number of words loaded, or -1 on error)
+int mipslite_load_file(MipsLiteSim *sim, const char *filename);
+int mipslite_load_buffer(MipsLiteSim *sim, const uint32_t *words, size_t count);
+void mipslite_reset(MipsLiteSim *sim);
+
+// Checkpoints (see checkpoint.h; return 0 on success, -1 on error). Restoring keeps the loaded
+// image for mipslite_reset; NF/WF continue with an empty pipeline at the checkpoint's PC.
+int mipslite_save_checkpoint(const MipsLiteSim *sim, const char *path);
+int mipslite_load_checkpoint(MipsLiteSim *sim, const char *path);
+
+// Execution (return the number of instructions/cycles actually simulated, or -1 on error)
+int64_t mipslite_step_instructions(MipsLiteSim *sim, uint64_t count);
+int64_t mipslite_step_cycles(MipsLiteSim *sim, uint64_t count);
+int mipslite_run(MipsLiteSim *sim);
+int mipslite_halted(const MipsLiteSim *sim);
+
+// Watchdog (defaults: NF 200000 / WF 100000 cycles, no instruction budget, livelock detection on)
+void mipslite_set_budget(MipsLiteSim *sim, uint64_t max_cycles, uint64_t max_instructions, int detect_livelock);
+MipsLiteStop mipslite_stop_reason(const MipsLiteSim *sim, uint32_t *loop_lo, uint32_t *loop_hi);
+
+// Accessors
+uint32_t mipslite_get_pc(const MipsLiteSim *sim);
+int32_t mipslite_get_register(const MipsLiteSim *sim, int reg);
+int mipslite_read_memory(const MipsLiteSim *sim, uint32_t address, uint32_t *value);
+void mipslite_get_stats(const MipsLiteSim *sim, MipsLiteStats *stats);
+
+#endif // MIPSLITE_H
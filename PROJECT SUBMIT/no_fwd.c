@@ -26,12 +26,15 @@
 * Functions:
 * - is_nop: Checks if an instruction is a NOP.
 * - insert_nop: Inserts a NOP instruction into a specified pipeline stage.
+* - insert_bubble: Inserts a NOP and records why (for the CPI stack).
 * - initialize_pipeline: Initializes the pipeline with NOPs.
+* - resume_pipeline: Empties the pipeline to continue from the current architectural state.
 * - get_dest_reg: Returns the destination register for an instruction.
 * - is_source_reg: Checks if a register is a source register for an instruction.
 * - detect_raw_hazard: Detects RAW hazards in the pipeline.
 * - simulate_one_cycle_no_forwarding_internal: Simulates one clock cycle of the pipeline.
 * - simulate_pipeline_no_forwarding: Main function to run the pipeline simulation.
+* - step_pipeline_no_forwarding: Advances the pipeline by one clock cycle.
 *
 */
 
@@ -42,24 +45,19 @@
 #include "functional_sim.h"
 #include "no_fwd.h"
 #include "trace_reader.h" // Needed for MAX_MEMORY_LINES and WORD_SIZE
-
-#define PIPELINE_DEPTH 5
-
-// Global clock cycle count (declared extern in functional_sim.h, defined in global_counters.c)
-extern int clock_cycles;
-extern int total_stalls;
-extern int total_flushes;
+#include "kanata.h" // Pipeline viewer export
+#include "predecode.h" // For fetch_instruction
+#include "sim_context.h" // Pipeline registers, pipeline PC and counters live in the context
+#include "watchdog.h" // Cycle/instruction budgets and livelock detection
+#include "progress.h" // Progress heartbeat
+#include "live_stats.h" // Counters page and SIGUSR1 snapshot
+#include "cpi_stack.h" // Cycle accounting by category
+#include "pc_profile.h" // Per-PC stall and flush profile
+#include "stage_probe.h" // Stage timing probes (-DSTAGE_PROBES)
 
 // Global NOP_INSTRUCTION instance (declared extern in no_fwd.h, defined in global_counters.c)
 extern DecodedInstruction NOP_INSTRUCTION;
 
-// Circular buffer for pipeline - MAKE STATIC
-static PipelineRegister pipeline[PIPELINE_DEPTH];
-
-// Internal PC for pipeline - MAKE STATIC
-static uint32_t pipeline_pc = 0; // This tracks the PC of the instruction to be fetched NEXT
-static int pipeline_halt_seen = 0; // Flag to indicate if HALT instruction has been fetched
-
 
 /*
 * Function to check if an instruction is a NOP (No Operation)
@@ -83,28 +81,58 @@ void insert_nop(int stage, PipelineRegister pipeline_arr[]) {
     pipeline_arr[stage].branch_taken = 0; // Clear branch flags
     pipeline_arr[stage].branch_target = 0;
     pipeline_arr[stage].result_val = 0; // Clear result
+    pipeline_arr[stage].seq = 0; // NOPs are not traced
+    pipeline_arr[stage].bubble = CPI_FILL; // Unless the caller says otherwise
+    pipeline_arr[stage].bubble_distance = 0;
+}
+
+/*
+* Inserts a NOP into a pipeline stage like insert_nop, recording the CpiCategory it
+* stands for (and the producer distance of a RAW stall) for the CPI stack.
+*/
+void insert_bubble(int stage, PipelineRegister pipeline_arr[], int cause, int distance) {
+    insert_nop(stage, pipeline_arr);
+    pipeline_arr[stage].bubble = (uint8_t)cause;
+    pipeline_arr[stage].bubble_distance = (uint8_t)distance;
 }
 
 /*
 * Function to initialize the pipeline with NOP instructions
-* This function fills the pipeline with NOP instructions for each stage.
+* This function fills the context's pipeline with NOP instructions for each stage.
 * It sets the pipeline PC to 0, resets the halt flag, and initializes
 * the clock cycle count and instruction counters.
 */
-void initialize_pipeline(PipelineRegister pipeline_arr[]) {
+void initialize_pipeline(SimContext *ctx) {
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        insert_nop(i, ctx->pipeline);
+    }
+    ctx->pipeline_pc = 0; // Start fetching from address 0
+    ctx->pipeline_halt_seen = 0;
+    ctx->pipeline_fetch_seq = 0;
+    ctx->halted = 0;
+    ctx->clock_cycles = 0;
+    ctx->total_stalls = 0;
+    ctx->total_flushes = 0;
+    ctx->total_instructions = 0; // Reset functional sim's instruction counters
+    ctx->arithmetic_instructions = 0;
+    ctx->logical_instructions = 0;
+    ctx->memory_access_instructions = 0;
+    ctx->control_transfer_instructions = 0;
+}
+
+/*
+* Empties the pipeline so a run can continue from the context's architectural state
+* (e.g. a restored checkpoint): fetching restarts at state.pc, and the instruction and
+* timing counters carry on from their current values.
+*/
+void resume_pipeline(SimContext *ctx) {
     for (int i = 0; i < PIPELINE_DEPTH; i++) {
-        insert_nop(i, pipeline_arr);
+        insert_nop(i, ctx->pipeline);
     }
-    pipeline_pc = 0; // Start fetching from address 0
-    pipeline_halt_seen = 0;
-    clock_cycles = 0;
-    total_stalls = 0;
-    total_flushes = 0;
-    total_instructions = 0; // Reset functional sim's instruction counters
-    arithmetic_instructions = 0;
-    logical_instructions = 0;
-    memory_access_instructions = 0;
-    control_transfer_instructions = 0;
+    ctx->pipeline_pc = ctx->state.pc;
+    ctx->pipeline_halt_seen = 0;
+    ctx->pipeline_fetch_seq = 0;
+    ctx->halted = 0;
 }
 
 /*
@@ -230,152 +258,182 @@ int detect_raw_hazard(PipelineRegister curr_id_reg, PipelineRegister ex_reg, Pip
 * The function is called by the main simulation loop in simulate_pipeline_no_forwarding.
 * It is responsible for managing the pipeline stages and ensuring correct execution of instructions.
 */
-void simulate_one_cycle_no_forwarding_internal() {
-    clock_cycles++;
+void simulate_one_cycle_no_forwarding_internal(SimContext *ctx) {
+    STAGE_PROBE_START(PROBE_NF);
+    ctx->clock_cycles++;
+    if (ctx->kanata) kanata_record_cycle(ctx->kanata, ctx->clock_cycles, ctx->pipeline);
 
     // Debugging Statements
     // --- Optional: Print header for the current cycle ---
-    DBG_PRINTF("Clock cycle: %d\n", clock_cycles);
+    DBG_PRINTF("Clock cycle: %llu\n", (unsigned long long)ctx->clock_cycles);
     DBG_PRINTF("  Reg State: R1=%d, R2=%d, R3=%d, R4=%d, R5=%d, R6=%d, R7=%d, R8=%d, R9=%d, R10=%d, R11=%d, R12=%d, R13=%d, R14=%d, R15=%d\n",
-           state.registers[1], state.registers[2], state.registers[3], state.registers[4], state.registers[5],
-           state.registers[6], state.registers[7], state.registers[8], state.registers[9], state.registers[10],
-           state.registers[11], state.registers[12], state.registers[13], state.registers[14], state.registers[15]);
+           ctx->state.registers[1], ctx->state.registers[2], ctx->state.registers[3], ctx->state.registers[4], ctx->state.registers[5],
+           ctx->state.registers[6], ctx->state.registers[7], ctx->state.registers[8], ctx->state.registers[9], ctx->state.registers[10],
+           ctx->state.registers[11], ctx->state.registers[12], ctx->state.registers[13], ctx->state.registers[14], ctx->state.registers[15]);
 
     DBG_PRINTF("Pipeline state: IF=%s, ID=%s, EX=%s, MEM=%s, WB=%s\n",
-           opcode_to_string(pipeline[IF].instr.opcode), opcode_to_string(pipeline[ID].instr.opcode),
-           opcode_to_string(pipeline[EX].instr.opcode), opcode_to_string(pipeline[MEM].instr.opcode),
-           opcode_to_string(pipeline[WB].instr.opcode));
-    DBG_PRINTF("Pipeline PC: %u\n", pipeline_pc);
+           opcode_to_string(ctx->pipeline[IF].instr.opcode), opcode_to_string(ctx->pipeline[ID].instr.opcode),
+           opcode_to_string(ctx->pipeline[EX].instr.opcode), opcode_to_string(ctx->pipeline[MEM].instr.opcode),
+           opcode_to_string(ctx->pipeline[WB].instr.opcode));
+    DBG_PRINTF("Pipeline PC: %u\n", ctx->pipeline_pc);
 
     // Debugging PC at 88
-    if (pipeline[WB].valid && pipeline[WB].pc == 88) {
-        DBG_PRINTF("DEBUG WB (Cycle %d): PC=%u, Opcode in pipeline[WB].instr = 0x%X, Expected STW (0x0D)\n",
-            clock_cycles, pipeline[WB].pc, pipeline[WB].instr.opcode);
+    if (ctx->pipeline[WB].valid && ctx->pipeline[WB].pc == 88) {
+        DBG_PRINTF("DEBUG WB (Cycle %llu): PC=%u, Opcode in pipeline[WB].instr = 0x%X, Expected STW (0x0D)\n",
+            (unsigned long long)ctx->clock_cycles, ctx->pipeline[WB].pc, ctx->pipeline[WB].instr.opcode);
 
     }
+    STAGE_PROBE(PROBE_PROLOGUE);
 
     // --- Stage Execution (in reverse order for pipeline integrity) ---
     // 1. WB stage execution: Instructions commit and update architectural state
-    if (pipeline[WB].valid && !is_nop(pipeline[WB].instr)) {
-        if (pipeline[WB].instr.opcode == HALT) {
+    if (ctx->pipeline[WB].valid && !is_nop(ctx->pipeline[WB].instr)) {
+        if (ctx->pipeline[WB].instr.opcode == HALT) {
             DBG_PRINTF("[PIPE_DEBUG] HALT in WB. pipeline[WB].pc = 0x%X. Current state.pc BEFORE assignment = 0x%X\n", 
-                   pipeline[WB].pc, state.pc);
+                   ctx->pipeline[WB].pc, ctx->state.pc);
         }
 
-        state.pc = pipeline[WB].pc;
+        ctx->state.pc = ctx->pipeline[WB].pc;
 
-        if (pipeline[WB].instr.opcode == HALT) {
+        if (ctx->pipeline[WB].instr.opcode == HALT) {
             DBG_PRINTF("[PIPE_DEBUG] HALT in WB. state.pc AFTER assignment (entry to simulate_instruction) = 0x%X\n", 
-                   state.pc);
+                   ctx->state.pc);
         }
 
-        simulate_instruction(pipeline[WB].instr);
+        simulate_instruction(ctx, ctx->pipeline[WB].instr);
+        watchdog_commit(ctx, &ctx->pipeline[WB].instr, ctx->pipeline[WB].pc);
+        if (ctx->pc_profile) pc_profile_commit(ctx->pc_profile, &ctx->pipeline[WB].instr, ctx->pipeline[WB].pc);
     } 
+    STAGE_PROBE(PROBE_WB);
 
     int raw_hazard_stall_this_cycle = 0;
     int branch_flush_this_cycle = 0;
+    int stall_cause = CPI_RAW, stall_distance = 1, stall_producer = -1;
 
     // 2. Branch Resolution in EX stage
-    if (pipeline[EX].valid && !is_nop(pipeline[EX].instr) &&
-        (pipeline[EX].instr.opcode == BEQ || pipeline[EX].instr.opcode == BZ || pipeline[EX].instr.opcode == JR)) {
+    if (ctx->pipeline[EX].valid && !is_nop(ctx->pipeline[EX].instr) &&
+        (ctx->pipeline[EX].instr.opcode == BEQ || ctx->pipeline[EX].instr.opcode == BZ || ctx->pipeline[EX].instr.opcode == JR)) {
 
         // DEBUG Statement
-        DBG_PRINTF("  Branch check in EX: PC=%u, Opcode=%d\n", pipeline[EX].pc, pipeline[EX].instr.opcode);
+        DBG_PRINTF("  Branch check in EX: PC=%u, Opcode=%d\n", ctx->pipeline[EX].pc, ctx->pipeline[EX].instr.opcode);
 
         int is_branch_taken = 0;
         uint32_t branch_resolved_target_pc = 0;
 
-        if (pipeline[EX].instr.opcode == BZ) {
-            if (state.registers[pipeline[EX].instr.rs] == 0) {
+        if (ctx->pipeline[EX].instr.opcode == BZ) {
+            if (ctx->state.registers[ctx->pipeline[EX].instr.rs] == 0) {
                 is_branch_taken = 1;
                 // Corrected target calculation: PC_of_branch + (immediate_word_offset * 4)
-                branch_resolved_target_pc = pipeline[EX].pc + ((int32_t)pipeline[EX].instr.immediate * 4); 
+                branch_resolved_target_pc = ctx->pipeline[EX].pc + ((int32_t)ctx->pipeline[EX].instr.immediate * 4); 
             }
-        } else if (pipeline[EX].instr.opcode == BEQ) {
-            if (state.registers[pipeline[EX].instr.rs] == state.registers[pipeline[EX].instr.rt]) {
+        } else if (ctx->pipeline[EX].instr.opcode == BEQ) {
+            if (ctx->state.registers[ctx->pipeline[EX].instr.rs] == ctx->state.registers[ctx->pipeline[EX].instr.rt]) {
                 is_branch_taken = 1;
                 // Corrected target calculation: PC_of_branch + (immediate_word_offset * 4)
-                branch_resolved_target_pc = pipeline[EX].pc + ((int32_t)pipeline[EX].instr.immediate * 4); 
+                branch_resolved_target_pc = ctx->pipeline[EX].pc + ((int32_t)ctx->pipeline[EX].instr.immediate * 4); 
             }
-        } else if (pipeline[EX].instr.opcode == JR) { // Ensure JR is handled correctly too
+        } else if (ctx->pipeline[EX].instr.opcode == JR) { // Ensure JR is handled correctly too
             is_branch_taken = 1;
-            branch_resolved_target_pc = (uint32_t)state.registers[pipeline[EX].instr.rs];
+            branch_resolved_target_pc = (uint32_t)ctx->state.registers[ctx->pipeline[EX].instr.rs];
         }
 
         if (is_branch_taken) {
-            pipeline_pc = branch_resolved_target_pc;
+            ctx->pipeline_pc = branch_resolved_target_pc;
             branch_flush_this_cycle = 1;
-            total_flushes += 2;
+            ctx->total_flushes += 2;
+            if (ctx->kanata) kanata_annotate(ctx->kanata, ctx->pipeline[EX].seq, "branch taken to 0x%X, flushing IF/ID", ctx->pipeline_pc);
             // DEBUG Statement
-            DBG_PRINTF("Branch taken in EX stage. Flushing IF and ID. New PC: %u\n", pipeline_pc);
+            DBG_PRINTF("Branch taken in EX stage. Flushing IF and ID. New PC: %u\n", ctx->pipeline_pc);
         }
     }
+    STAGE_PROBE(PROBE_EX);
 
     // 3. Detect RAW hazard in ID stage
-    if (pipeline[ID].valid && !is_nop(pipeline[ID].instr) && pipeline[ID].instr.opcode != HALT) {
+    if (ctx->pipeline[ID].valid && !is_nop(ctx->pipeline[ID].instr) && ctx->pipeline[ID].instr.opcode != HALT) {
         raw_hazard_stall_this_cycle = detect_raw_hazard(
-            pipeline[ID], // Pass the full PipelineRegister struct
-            pipeline[EX],
-            pipeline[MEM]
+            ctx->pipeline[ID], // Pass the full PipelineRegister struct
+            ctx->pipeline[EX],
+            ctx->pipeline[MEM]
         );
 
         if (raw_hazard_stall_this_cycle) {
             // DEBUG Statement
             DBG_PRINTF("RAW hazard detected. Stalling pipeline.\n");
-            total_stalls++;
+            ctx->total_stalls++;
+            stall_cause = cpi_stack_stall_cause(ctx, &stall_distance, &stall_producer);
+            if (ctx->pc_profile) pc_profile_stall(ctx, stall_producer);
+            if (ctx->kanata) {
+                // Name the producer(s) the instruction in ID is waiting on
+                for (int s = EX; s <= MEM; s++) {
+                    int dest = get_dest_reg(ctx->pipeline[s].instr);
+                    if (ctx->pipeline[s].valid && dest > 0 && is_source_reg(ctx->pipeline[ID].instr, dest)) {
+                        kanata_annotate(ctx->kanata, ctx->pipeline[ID].seq, "RAW stall on R%d (producer in %s)",
+                                        dest, s == EX ? "EX" : "MEM");
+                        kanata_dependency(ctx->kanata, ctx->pipeline[ID].seq, ctx->pipeline[s].seq);
+                    }
+                }
+            }
         }
     }
+    STAGE_PROBE(PROBE_HAZARD);
 
     // 4. Advance/Stall pipeline stages
-    pipeline[WB] = pipeline[MEM];
+    ctx->pipeline[WB] = ctx->pipeline[MEM];
 
     if (raw_hazard_stall_this_cycle) {
-        pipeline[MEM] = pipeline[EX];
-        insert_nop(EX, pipeline);
+        ctx->pipeline[MEM] = ctx->pipeline[EX];
+        insert_bubble(EX, ctx->pipeline, stall_cause, stall_distance);
         // DEBUG Statement
         DBG_PRINTF("Pipeline stalled. Inserting NOP into EX stage.\n");
     } else if (branch_flush_this_cycle) {
-        pipeline[MEM] = pipeline[EX];
-        insert_nop(EX, pipeline);
-        insert_nop(ID, pipeline);
-        insert_nop(IF, pipeline);
+        if (ctx->pc_profile) pc_profile_flush(ctx->pc_profile, ctx->pipeline[EX].pc, 2); // ID and IF squashed
+        ctx->pipeline[MEM] = ctx->pipeline[EX];
+        insert_bubble(EX, ctx->pipeline, CPI_BRANCH_FLUSH, 0);
+        insert_bubble(ID, ctx->pipeline, CPI_BRANCH_FLUSH, 0);
+        insert_nop(IF, ctx->pipeline);
     }
     else {
-        pipeline[MEM] = pipeline[EX];
-        pipeline[EX] = pipeline[ID];
-        pipeline[ID] = pipeline[IF];
-        insert_nop(IF, pipeline);
+        ctx->pipeline[MEM] = ctx->pipeline[EX];
+        ctx->pipeline[EX] = ctx->pipeline[ID];
+        ctx->pipeline[ID] = ctx->pipeline[IF];
+        insert_nop(IF, ctx->pipeline);
     }
+    STAGE_PROBE(PROBE_ADVANCE);
 
     // 5. Fetch new instruction into IF stage
-    if (!raw_hazard_stall_this_cycle && !pipeline_halt_seen && pipeline_pc < (MAX_MEMORY_LINES * WORD_SIZE)) {
-        uint32_t instr_word = state.memory[pipeline_pc / WORD_SIZE];
-        DecodedInstruction fetched = decode_instruction(instr_word);
+    if (!raw_hazard_stall_this_cycle && !ctx->pipeline_halt_seen && ctx->pipeline_pc < (MAX_MEMORY_LINES * WORD_SIZE)) {
+        DecodedInstruction fetched = fetch_instruction(ctx, ctx->pipeline_pc); // Predecoded when available
 
-        pipeline[IF].instr = fetched;
-        pipeline[IF].valid = 1;
-        pipeline[IF].pc = pipeline_pc;
+        ctx->pipeline[IF].instr = fetched;
+        ctx->pipeline[IF].valid = 1;
+        ctx->pipeline[IF].pc = ctx->pipeline_pc;
+        ctx->pipeline[IF].seq = ++ctx->pipeline_fetch_seq;
 
         if (fetched.opcode == HALT) {
             // DEBUG Statement
             DBG_PRINTF("HALT instruction fetched. Stopping further fetches.\n");
-            pipeline_halt_seen = 1;
+            ctx->pipeline_halt_seen = 1;
         }
 
-        pipeline_pc += WORD_SIZE;
+        ctx->pipeline_pc += WORD_SIZE;
 
         // DEBUG Statement
-        DBG_PRINTF("Fetched instruction at PC: %u. Opcode: %d\n", pipeline[IF].pc, fetched.opcode);
-    } else if (!raw_hazard_stall_this_cycle && pipeline_halt_seen) {
-        insert_nop(IF, pipeline);
+        DBG_PRINTF("Fetched instruction at PC: %u. Opcode: %d\n", ctx->pipeline[IF].pc, fetched.opcode);
+    } else if (!raw_hazard_stall_this_cycle && ctx->pipeline_halt_seen) {
+        insert_bubble(IF, ctx->pipeline, CPI_DRAIN, 0);
         // DEBUG Statement
         DBG_PRINTF("Inserting NOP into IF stage because HALT was previously fetched and no stall/flush.\n");
-    } else if (!raw_hazard_stall_this_cycle && !pipeline_halt_seen && pipeline_pc >= (MAX_MEMORY_LINES * WORD_SIZE)) {
-        insert_nop(IF, pipeline);
+    } else if (!raw_hazard_stall_this_cycle && !ctx->pipeline_halt_seen && ctx->pipeline_pc >= (MAX_MEMORY_LINES * WORD_SIZE)) {
+        insert_bubble(IF, ctx->pipeline, CPI_DRAIN, 0);
         // DEBUG Statement
-        DBG_PRINTF("Inserting NOP into IF stage because PC (%u) is out of memory bounds, effectively halting.\n", pipeline_pc);
-        pipeline_halt_seen = 1;
+        DBG_PRINTF("Inserting NOP into IF stage because PC (%u) is out of memory bounds, effectively halting.\n", ctx->pipeline_pc);
+        ctx->pipeline_halt_seen = 1;
     }
+    STAGE_PROBE(PROBE_FETCH);
+
+    // 6. Charge this cycle to what has reached WB
+    cpi_stack_account(ctx);
+    STAGE_PROBE(PROBE_ACCOUNT);
 }
 
 /*
@@ -397,47 +455,57 @@ void simulate_one_cycle_no_forwarding_internal() {
 * The function is called by the main simulation loop in functional_sim.c.
 * It is the main entry point for running the pipeline simulation without forwarding.
 */
-void simulate_pipeline_no_forwarding() {
-    initialize_pipeline(pipeline);
-    int final_halt_processed_in_wb = 0; // Flag
+void simulate_pipeline_no_forwarding(SimContext *ctx) {
+    initialize_pipeline(ctx);
 
-    while (1) {
-        simulate_one_cycle_no_forwarding_internal(); 
-
-        if (pipeline[WB].valid && pipeline[WB].instr.opcode == HALT) {
+    while (!step_pipeline_no_forwarding(ctx)) {
+        // One clock cycle per step
+    }
 
-            final_halt_processed_in_wb = 1; // Signal that HALT has been architecturally processed
-            state.pc += 4;
-            total_instructions++;
-            control_transfer_instructions++;
-            break;
-        }
+    print_final_state(ctx);
+    // Note: Not iterating PC by 4 again, or instruction counts by 1 again.
+}
 
-        int active_instructions_remaining = 0;
-        for (int i = 0; i < PIPELINE_DEPTH; i++) {
-            // Count active if not HALT in WB, or if HALT is not the *only* thing
-            if (pipeline[i].valid && pipeline[i].instr.opcode != NOP) {
-                 if (!(i == WB && pipeline[i].instr.opcode == HALT && final_halt_processed_in_wb)) {
-                    active_instructions_remaining = 1;
-                    break;
-                 }
-            }
-        }
-        
-        if (final_halt_processed_in_wb && !active_instructions_remaining) {
-            break; // HALT has committed, pipeline is now empty past it.
-        }
-        
-        if (!active_instructions_remaining && pipeline_halt_seen) { // General drain condition
-             break;
-        }
+/*
+* Advances the no-forwarding pipeline by one clock cycle.
+* When HALT reaches WB it is architecturally processed here (PC and counters),
+* and the run is marked finished. Also finishes when the pipeline drains after
+* a HALT fetch or the watchdog stops the run (budget or infinite loop).
+* Returns 1 once the run has finished (ctx->halted), 0 otherwise.
+*/
+int step_pipeline_no_forwarding(SimContext *ctx) {
+    if (ctx->halted) return 1;
+
+    simulate_one_cycle_no_forwarding_internal(ctx);
+
+    if (ctx->pipeline[WB].valid && ctx->pipeline[WB].instr.opcode == HALT) {
+        // HALT has been architecturally processed
+        ctx->state.pc += 4;
+        ctx->total_instructions++;
+        ctx->control_transfer_instructions++;
+        if (ctx->pc_profile) pc_profile_commit(ctx->pc_profile, &ctx->pipeline[WB].instr, ctx->pipeline[WB].pc);
+        ctx->halted = 1;
+        return 1;
+    }
 
-        if (clock_cycles > 200000) {
-            fprintf(stderr, "Simulator possibly in infinite loop, breaking.\n");
+    int active_instructions_remaining = 0;
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        if (ctx->pipeline[i].valid && ctx->pipeline[i].instr.opcode != NOP) {
+            active_instructions_remaining = 1;
             break;
         }
     }
 
-    print_final_state(); 
-    // Note: Not iterating PC by 4 again, or instruction counts by 1 again.
+    if (!active_instructions_remaining && ctx->pipeline_halt_seen) { // General drain condition
+        ctx->halted = 1;
+        return 1;
+    }
+
+    if (watchdog_expired(ctx, WATCHDOG_NF_DEFAULT_CYCLES)) { // Cycle or instruction budget, or infinite loop
+        ctx->halted = 1;
+        return 1;
+    }
+    PROGRESS_UPDATE(ctx);
+    LIVE_STATS_UPDATE(ctx);
+    return 0;
 }
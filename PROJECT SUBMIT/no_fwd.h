@@ -9,6 +9,11 @@
 #include "instruction_decoder.h" // Include this for DecodedInstruction
 #include <stdint.h>              // For uint32_t
 
+#define PIPELINE_DEPTH 5
+
+// Simulator context (defined in sim_context.h)
+typedef struct SimContext SimContext;
+
 // Pipeline stage names for readability
 enum pipeline_stages { IF = 0, ID, EX, MEM, WB };
 
@@ -20,6 +25,9 @@ typedef struct {
     int branch_taken; // Flag for taken branches (set in EX)
     uint32_t branch_target; // Target address for taken branches (set in EX)
     int32_t result_val; // Value to be written to register (from EX/MEM) or loaded value
+    uint8_t bubble; // For NOPs: the CpiCategory the cycle is charged to when the NOP reaches WB
+    uint8_t bubble_distance; // For CPI_RAW bubbles: producer distance of the stall
+    uint64_t seq; // Fetch sequence number (0 for NOPs), identifies the instruction in pipeline traces
 } PipelineRegister;
 
 // Global NOP_INSTRUCTION instance declaration (defined in global_counters.c)
@@ -29,10 +37,15 @@ extern DecodedInstruction NOP_INSTRUCTION;
 int is_nop(DecodedInstruction instr); // Declare is_nop here
 // Helper functions for pipeline management
 void insert_nop(int stage, PipelineRegister pipeline_arr[]);
-void initialize_pipeline(PipelineRegister pipeline_arr[]);
+void insert_bubble(int stage, PipelineRegister pipeline_arr[], int cause, int distance);
+void initialize_pipeline(SimContext *ctx);
+void resume_pipeline(SimContext *ctx);
+int get_dest_reg(DecodedInstruction instr);
+int is_source_reg(DecodedInstruction instr, int reg_num);
 
 // Function declarations for no_fwd.c specific functions
-void simulate_pipeline_no_forwarding();
+void simulate_pipeline_no_forwarding(SimContext *ctx);
+int step_pipeline_no_forwarding(SimContext *ctx);
 
 
 #endif // NO_FWD_H
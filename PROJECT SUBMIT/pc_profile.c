@@ -0,0 +1,158 @@
+/*
+* Per-PC Profile
+* This file implements the per-PC stall and flush profile attached to a SimContext. The
+* pipeline code reports commits, RAW/load-use stalls (with the stage of the producer) and
+* taken-branch flushes; stall cycles are charged to both ends of the dependence.
+*
+* Supported Operations:
+* - Executions, consumer and producer stall cycles, flushes and squashed cycles per PC
+* - The producers each consumer waited on most
+* - An annotated disassembly sorted by cycles lost
+*
+* Functions:
+* - pc_profile_init: Clears a profile (attach it with ctx->pc_profile = &profile).
+* - pc_profile_commit: Counts an instruction committed in WB.
+* - pc_profile_stall: Charges a stall cycle to the instruction in ID and its producer.
+* - pc_profile_flush: Charges the cycles squashed by a taken branch.
+* - pc_profile_print: Prints the annotated disassembly.
+*/
+
+#include "pc_profile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_context.h"
+
+/*
+* Clears a profile; max_rows limits the report to the top rows (0 = all).
+*/
+void pc_profile_init(PcProfile *pp, int max_rows) {
+    memset(pp, 0, sizeof(PcProfile));
+    pp->max_rows = max_rows;
+}
+
+/*
+* Counts an execution of the instruction at pc (called when it commits in WB).
+*/
+void pc_profile_commit(PcProfile *pp, const DecodedInstruction *instr, uint32_t pc) {
+    PcProfileEntry *e = &pp->entries[(pc / WORD_SIZE) % MAX_MEMORY_LINES];
+    if (e->executions++ == 0) e->instr = *instr;
+}
+
+/*
+* Charges one stall cycle of the instruction in ID (the consumer) to it, and to the
+* instruction in producer_stage it waits on (-1 if none was identified).
+*/
+void pc_profile_stall(SimContext *ctx, int producer_stage) {
+    PcProfileEntry *consumer = &ctx->pc_profile->entries[(ctx->pipeline[ID].pc / WORD_SIZE) % MAX_MEMORY_LINES];
+    consumer->consumer_stalls++;
+    if (producer_stage < 0) {
+        consumer->other_producer_cycles++;
+        return;
+    }
+
+    uint32_t producer_pc = ctx->pipeline[producer_stage].pc;
+    ctx->pc_profile->entries[(producer_pc / WORD_SIZE) % MAX_MEMORY_LINES].producer_stalls++;
+
+    // Remember the pair in a free slot or the slot already holding this producer
+    for (int i = 0; i < PC_PROFILE_PRODUCERS; i++) {
+        if (consumer->producer_cycles[i] == 0 || consumer->producer_pc[i] == producer_pc) {
+            consumer->producer_pc[i] = producer_pc;
+            consumer->producer_cycles[i]++;
+            return;
+        }
+    }
+    consumer->other_producer_cycles++;
+}
+
+/*
+* Charges a taken branch at pc that squashed "squashed" wrong-path pipeline slots.
+*/
+void pc_profile_flush(PcProfile *pp, uint32_t pc, int squashed) {
+    PcProfileEntry *e = &pp->entries[(pc / WORD_SIZE) % MAX_MEMORY_LINES];
+    e->flushes++;
+    e->flush_cycles += (uint64_t)squashed;
+}
+
+/*
+* Cycles an instruction costs beyond its own issue slot: stalls waiting on its operands and
+* the wrong-path cycles it squashed.
+*/
+static uint64_t cycles_lost(const PcProfileEntry *e) {
+    return e->consumer_stalls + e->flush_cycles;
+}
+
+/*
+* Orders report rows: most cycles lost first, then most stalls caused, then by PC.
+*/
+static const PcProfile *sort_profile; // qsort has no context argument; printing is single-threaded
+static int compare_rows(const void *a, const void *b) {
+    const PcProfileEntry *ea = &sort_profile->entries[*(const int *)a];
+    const PcProfileEntry *eb = &sort_profile->entries[*(const int *)b];
+    uint64_t la = cycles_lost(ea), lb = cycles_lost(eb);
+    if (la != lb) return la > lb ? -1 : 1;
+    if (ea->producer_stalls != eb->producer_stalls) return ea->producer_stalls > eb->producer_stalls ? -1 : 1;
+    return *(const int *)a - *(const int *)b;
+}
+
+/*
+* Prints the profile as a disassembly listing sorted by cycles lost, each consumer
+* annotated with the producers it waited on.
+*/
+void pc_profile_print(const PcProfile *pp) {
+    static int rows[MAX_MEMORY_LINES];
+    int count = 0;
+    uint64_t executions = 0, stalls = 0, flush_cycles = 0;
+    for (int i = 0; i < MAX_MEMORY_LINES; i++) {
+        const PcProfileEntry *e = &pp->entries[i];
+        if (!e->executions && !e->consumer_stalls && !e->producer_stalls && !e->flushes) continue;
+        rows[count++] = i;
+        executions += e->executions;
+        stalls += e->consumer_stalls;
+        flush_cycles += e->flush_cycles;
+    }
+    sort_profile = pp;
+    qsort(rows, (size_t)count, sizeof(int), compare_rows);
+
+    int shown = pp->max_rows > 0 && pp->max_rows < count ? pp->max_rows : count;
+    printf("Per-PC profile (sorted by cycles lost = stall cycles waited + branch flush cycles;\n");
+    printf("  Waited/Caused = stall cycles as the consumer/as the producer of a dependence):\n");
+    printf("  %-6s %-22s %10s %8s %10s %10s %10s %8s %10s\n", "PC", "Instruction", "Executions", "Cyc/exec",
+           "Lost", "Waited", "Caused", "Flushes", "Flush cyc");
+    for (int r = 0; r < shown; r++) {
+        const PcProfileEntry *e = &pp->entries[rows[r]];
+        char text[64];
+        if (e->executions) {
+            format_instruction(e->instr, text, sizeof(text));
+        } else {
+            snprintf(text, sizeof(text), "(not committed)");
+        }
+        // Its own issue cycle plus the cycles lost, per execution
+        double per_exec = e->executions ? (double)(e->executions + cycles_lost(e)) / (double)e->executions : 0.0;
+        printf("  0x%04X %-22s %10llu %8.3f %10llu %10llu %10llu %8llu %10llu\n", rows[r] * WORD_SIZE, text,
+               (unsigned long long)e->executions, per_exec, (unsigned long long)cycles_lost(e),
+               (unsigned long long)e->consumer_stalls, (unsigned long long)e->producer_stalls,
+               (unsigned long long)e->flushes, (unsigned long long)e->flush_cycles);
+
+        for (int i = 0; i < PC_PROFILE_PRODUCERS && e->producer_cycles[i]; i++) {
+            const PcProfileEntry *p = &pp->entries[(e->producer_pc[i] / WORD_SIZE) % MAX_MEMORY_LINES];
+            char producer[64];
+            if (p->executions) {
+                format_instruction(p->instr, producer, sizeof(producer));
+            } else {
+                snprintf(producer, sizeof(producer), "(not committed)");
+            }
+            printf("         waits on 0x%04X %-22s %10llu cycles\n", e->producer_pc[i], producer,
+                   (unsigned long long)e->producer_cycles[i]);
+        }
+        if (e->other_producer_cycles) {
+            printf("         waits on other instructions        %10llu cycles\n",
+                   (unsigned long long)e->other_producer_cycles);
+        }
+    }
+    if (shown < count) printf("  ... %d more instructions (--pc-profile=<n> sets the number of rows)\n", count - shown);
+    printf("  Total: %llu executions, %llu stall cycles, %llu branch flush cycles\n",
+           (unsigned long long)executions, (unsigned long long)stalls, (unsigned long long)flush_cycles);
+}
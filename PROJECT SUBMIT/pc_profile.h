@@ -0,0 +1,54 @@
+/*
+* Per-PC Profile Header File
+* This header file declares the per-PC stall and flush profile of the NF and WF models.
+* For every static instruction it counts executions, the stall cycles it spent waiting on
+* an older instruction (as consumer), the stall cycles younger instructions spent waiting
+* on it (as producer), and the wrong-path cycles it squashed as a taken branch. The
+* report is an annotated disassembly sorted by cycles lost.
+*/
+
+#ifndef PC_PROFILE_H
+#define PC_PROFILE_H
+
+#include <stdint.h>
+#include "instruction_decoder.h" // For DecodedInstruction
+#include "trace_reader.h"        // For MAX_MEMORY_LINES
+
+#define PC_PROFILE_PRODUCERS 2 // Producers remembered per consumer (the rest are summed)
+
+/*
+* PcProfileEntry structure:
+* Counters of one static instruction (one memory word).
+*/
+typedef struct {
+    DecodedInstruction instr;  // As executed (recorded on the first commit)
+    uint64_t executions;       // Commits in WB
+    uint64_t consumer_stalls;  // Stall cycles spent in ID waiting on an older instruction
+    uint64_t producer_stalls;  // Stall cycles younger instructions spent waiting on this one
+    uint64_t flushes;          // Times this branch was taken and squashed the younger instructions
+    uint64_t flush_cycles;     // Wrong-path cycles squashed by those flushes
+    uint32_t producer_pc[PC_PROFILE_PRODUCERS];     // Instructions this one waited on most...
+    uint64_t producer_cycles[PC_PROFILE_PRODUCERS]; // ...and the stall cycles for each
+    uint64_t other_producer_cycles;                 // Stall cycles on any other producer
+} PcProfileEntry;
+
+/*
+* PcProfile structure:
+* Attached to a SimContext (owned by the caller, static: about 100 KB).
+*/
+typedef struct {
+    PcProfileEntry entries[MAX_MEMORY_LINES];
+    int max_rows; // Rows printed (0 = every executed instruction)
+} PcProfile;
+
+// Simulator context (defined in sim_context.h)
+typedef struct SimContext SimContext;
+
+// Function prototypes
+void pc_profile_init(PcProfile *pp, int max_rows);
+void pc_profile_commit(PcProfile *pp, const DecodedInstruction *instr, uint32_t pc);
+void pc_profile_stall(SimContext *ctx, int producer_stage);
+void pc_profile_flush(PcProfile *pp, uint32_t pc, int squashed);
+void pc_profile_print(const PcProfile *pp);
+
+#endif // PC_PROFILE_H
@@ -0,0 +1,337 @@
+/*
+* Predecode Cache
+* This file implements the warm-start cache for memory images. The first run with --predecode
+* parses the image, decodes every word and finds the basic blocks and static branch targets
+* reachable from PC 0, then writes the result next to the image as <image>.pdc.
+* Later runs hash the raw image file, and if it matches the cache header they mmap the cache
+* and copy the parsed words from it instead of parsing and decoding again.
+* Editing the image changes its hash, which invalidates the cache automatically.
+*
+* Fetches go through fetch_instruction(), which uses the predecoded table unless the word has
+* been overwritten by a store (tracked by memory_changed[]), so self-modifying code stays exact.
+*
+* Supported Operations:
+* - Content-hash keyed cache file next to the image, written atomically
+* - Predecoded instruction table and per-word flags (code, block leader, control, invalid)
+* - Static basic-block and branch-target analysis
+*
+* Functions:
+* - predecode_load_image: Loads an image through the cache (building it on a miss).
+* - predecode_build_image: Predecodes an image held in memory (no cache file).
+* - fetch_instruction: Returns the decoded instruction at a PC.
+* - predecode_release: Unmaps or frees a loaded image.
+*/
+
+#include "predecode.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "functional_sim.h" // For DBG_PRINTF
+#include "sim_context.h"    // For fetch_instruction
+#include "sim_hash.h"
+#include "host_perf.h"      // Decode phase of --host-counters
+
+/*
+* Reads a whole file into a NUL-terminated heap buffer.
+* Returns the buffer (caller frees) or NULL on failure.
+*/
+static char *read_whole_file(const char *filename, size_t *size) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        perror("Error opening file");
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (len < 0) {
+        fclose(file);
+        return NULL;
+    }
+    char *buf = malloc((size_t)len + 1);
+    if (buf && fread(buf, 1, (size_t)len, file) != (size_t)len) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(file);
+    if (buf) {
+        buf[len] = '\0';
+        *size = (size_t)len;
+    }
+    return buf;
+}
+
+/*
+* Maps an existing cache file and checks that it belongs to this image.
+* Returns the mapping, or NULL if the cache is missing or stale.
+*/
+static const PredecodeFile *map_cache(const char *path, uint64_t hash, uint64_t size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size != sizeof(PredecodeFile)) {
+        close(fd);
+        return NULL;
+    }
+    void *p = mmap(NULL, sizeof(PredecodeFile), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+
+    const PredecodeFile *pf = p;
+    if (memcmp(pf->magic, PREDECODE_MAGIC, 8) != 0 || pf->version != PREDECODE_VERSION ||
+        pf->source_hash != hash || pf->source_size != size || pf->word_count > MAX_MEMORY_LINES) {
+        munmap(p, sizeof(PredecodeFile));
+        return NULL;
+    }
+    return pf;
+}
+
+/*
+* Decodes every word and finds the code reachable from PC 0, the basic-block leaders and
+* the static targets of BZ/BEQ. JR targets are register values and are not followed.
+* The worklist is on the stack, so images can be analyzed on several threads at once.
+*/
+static void analyze_image(PredecodeFile *pf) {
+    uint32_t worklist[MAX_MEMORY_LINES * 2];
+    int top = 0;
+
+    for (int i = 0; i < MAX_MEMORY_LINES; i++) {
+        uint32_t word = pf->words[i];
+        PredecodedWord *pw = &pf->decoded[i];
+        pf->branch_target[i] = PREDECODE_NO_TARGET;
+        memset(pw, 0, sizeof(*pw));
+        if (get_instruction_type((word >> 26) & 0x3F) == INVALID_TYPE) {
+            pw->opcode = (word >> 26) & 0x3F;
+            pw->type = INVALID_TYPE;
+            pw->flags = PDC_INVALID;
+            continue;
+        }
+        DecodedInstruction d = decode_instruction(word);
+        pw->opcode = (uint8_t)d.opcode;
+        pw->type = (uint8_t)d.type;
+        pw->rs = (uint8_t)d.rs;
+        pw->rt = (uint8_t)d.rt;
+        pw->rd = (uint8_t)d.rd;
+        pw->immediate = (int16_t)d.immediate;
+        if (d.opcode == BZ || d.opcode == BEQ || d.opcode == JR || d.opcode == HALT) {
+            pw->flags |= PDC_CONTROL;
+        }
+        if (d.opcode == BZ || d.opcode == BEQ) {
+            pf->branch_target[i] = (uint32_t)(i * 4 + d.immediate * 4);
+        }
+    }
+
+    // Walk static control flow from PC 0
+    pf->decoded[0].flags |= PDC_LEADER;
+    worklist[top++] = 0;
+    while (top > 0) {
+        uint32_t index = worklist[--top];
+        while (index < MAX_MEMORY_LINES) {
+            PredecodedWord *pw = &pf->decoded[index];
+            if ((pw->flags & PDC_CODE) || (pw->flags & PDC_INVALID)) break;
+            pw->flags |= PDC_CODE;
+            if (!(pw->flags & PDC_CONTROL)) {
+                index++;
+                continue;
+            }
+            // Instruction after any control transfer starts a new block
+            if (index + 1 < MAX_MEMORY_LINES) pf->decoded[index + 1].flags |= PDC_LEADER;
+            if (pw->opcode == BZ || pw->opcode == BEQ) {
+                uint32_t target = pf->branch_target[index];
+                if (target / 4 < MAX_MEMORY_LINES && target % 4 == 0) {
+                    pf->decoded[target / 4].flags |= PDC_LEADER;
+                    if (top < MAX_MEMORY_LINES * 2) worklist[top++] = target / 4;
+                }
+                index++; // Not-taken path falls through
+                continue;
+            }
+            break; // JR and HALT do not fall through
+        }
+    }
+
+    pf->num_blocks = 0;
+    pf->num_code_words = 0;
+    for (int i = 0; i < MAX_MEMORY_LINES; i++) {
+        if (!(pf->decoded[i].flags & PDC_CODE)) {
+            pf->decoded[i].flags &= (uint8_t)~PDC_LEADER;
+            continue;
+        }
+        pf->num_code_words++;
+        if (pf->decoded[i].flags & PDC_LEADER) pf->num_blocks++;
+    }
+}
+
+/*
+* Writes the cache file atomically (temporary file + rename).
+* Failure only costs the warm start on the next run, so it is reported and ignored.
+*/
+static void write_cache(const char *path, const PredecodeFile *pf) {
+    char tmp_path[4096 + 32];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp-%ld", path, (long)getpid());
+
+    FILE *file = fopen(tmp_path, "wb");
+    if (!file) {
+        fprintf(stderr, "Warning: Cannot write predecode cache '%s'\n", tmp_path);
+        return;
+    }
+    int ok = fwrite(pf, sizeof(PredecodeFile), 1, file) == 1;
+    if (fclose(file) != 0) ok = 0;
+    if (!ok || rename(tmp_path, path) < 0) {
+        fprintf(stderr, "Warning: Failed to write predecode cache '%s'\n", path);
+        unlink(tmp_path);
+    }
+}
+
+/*
+* Wraps a cache file in a PredecodeImage.
+*/
+static PredecodeImage *make_image(const PredecodeFile *pf, int mapped) {
+    PredecodeImage *image = malloc(sizeof(PredecodeImage));
+    if (!image) {
+        if (mapped) munmap((void *)pf, sizeof(PredecodeFile));
+        else free((void *)pf);
+        return NULL;
+    }
+    image->file = pf;
+    image->mapped = mapped;
+    return image;
+}
+
+/*
+* Parses a memory image held in buf (NUL-terminated, size bytes of hex words, exactly like
+* fscanf("%x") in read_memory_image) and analyzes it.
+* Returns the new cache contents (caller frees), or NULL on failure.
+*/
+static PredecodeFile *build_file(const char *buf, size_t size, uint64_t hash) {
+    PredecodeFile *pf = calloc(1, sizeof(PredecodeFile));
+    if (!pf) return NULL;
+    const char *p = buf;
+    int word_count = 0;
+    while (1) {
+        char *end;
+        unsigned long value = strtoul(p, &end, 16);
+        if (end == p) break;
+        if (word_count >= MAX_MEMORY_LINES) {
+            fprintf(stderr, "Error: Memory image exceeds 4KB limit\n");
+            free(pf);
+            return NULL;
+        }
+        pf->words[word_count++] = (uint32_t)value;
+        p = end;
+    }
+
+    memcpy(pf->magic, PREDECODE_MAGIC, 8);
+    pf->version = PREDECODE_VERSION;
+    pf->word_count = (uint32_t)word_count;
+    pf->source_hash = hash;
+    pf->source_size = size;
+    analyze_image(pf);
+    return pf;
+}
+
+/*
+* Loads a memory image through the predecode cache.
+* On a hit the words come straight from the mmap'ed cache; on a miss the image is parsed
+* (same format as read_memory_image), analyzed and the cache is written for next time.
+* The loaded cache is returned in *image (release with predecode_release).
+* Returns the number of words read, or -1 on failure.
+*/
+int predecode_load_image(const char *filename, uint32_t *memory, PredecodeImage **image) {
+    *image = NULL;
+    DBG_PRINTF("Attempting to open file: %s\n", filename); // Debugging output
+
+    size_t size;
+    char *buf = read_whole_file(filename, &size);
+    if (!buf) return -1;
+    uint64_t hash = sim_hash_bytes(buf, size, SIM_HASH_SEED);
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s%s", filename, PREDECODE_SUFFIX);
+
+    int previous_phase = host_perf_enter(HOST_PHASE_DECODE, NULL); // --host-counters
+    const PredecodeFile *cached = map_cache(path, hash, size);
+    if (cached) {
+        host_perf_enter(previous_phase, NULL);
+        free(buf);
+        memcpy(memory, cached->words, sizeof(cached->words));
+        *image = make_image(cached, 1);
+        if (!*image) return -1;
+        DBG_PRINTF("Predecode cache hit: %s (%u words, %u code words, %u basic blocks)\n",
+                   path, cached->word_count, cached->num_code_words, cached->num_blocks);
+        return (int)cached->word_count;
+    }
+
+    // Miss: parse and analyze the image, and store the result for next time
+    PredecodeFile *pf = build_file(buf, size, hash);
+    free(buf);
+    if (!pf) {
+        host_perf_enter(previous_phase, NULL);
+        return -1;
+    }
+    int word_count = (int)pf->word_count;
+    write_cache(path, pf);
+    host_perf_enter(previous_phase, NULL);
+
+    memcpy(memory, pf->words, sizeof(pf->words));
+    *image = make_image(pf, 0);
+    if (!*image) return -1;
+    DBG_PRINTF("Predecode cache built: %s (%d words, %u code words, %u basic blocks)\n",
+               path, word_count, pf->num_code_words, pf->num_blocks);
+    return word_count;
+}
+
+/*
+* Predecodes a memory image held in memory (the text of an image file, size bytes,
+* NUL-terminated) without touching the cache files. The image is returned in *image
+* (release with predecode_release); its source_hash is the hash of the text.
+* Returns the number of words read, or -1 on failure.
+*/
+int predecode_build_image(const char *text, size_t size, PredecodeImage **image) {
+    *image = NULL;
+    PredecodeFile *pf = build_file(text, size, sim_hash_bytes(text, size, SIM_HASH_SEED));
+    if (!pf) return -1;
+    *image = make_image(pf, 0);
+    if (!*image) return -1;
+    return (int)pf->word_count;
+}
+
+/*
+* Returns the decoded instruction at pc.
+* Uses the predecoded table when available, unless the word was written by a store or
+* does not decode (decode_instruction reports invalid words).
+*/
+DecodedInstruction fetch_instruction(const SimContext *ctx, uint32_t pc) {
+    uint32_t index = pc / WORD_SIZE;
+    if (ctx->predecode && !ctx->memory_changed[index] && !(ctx->predecode->decoded[index].flags & PDC_INVALID)) {
+        const PredecodedWord *pw = &ctx->predecode->decoded[index];
+        DecodedInstruction decoded;
+        decoded.opcode = (Opcode)pw->opcode;
+        decoded.type = (InstrType)pw->type;
+        decoded.rs = pw->rs;
+        decoded.rt = pw->rt;
+        decoded.rd = pw->rd;
+        decoded.immediate = pw->immediate;
+        return decoded;
+    }
+    return decode_instruction(ctx->state.memory[index]);
+}
+
+/*
+* Releases a loaded image. Contexts using it must be detached or destroyed first.
+*/
+void predecode_release(PredecodeImage *image) {
+    if (!image) return;
+    if (image->mapped) {
+        munmap((void *)image->file, sizeof(PredecodeFile));
+    } else {
+        free((void *)image->file);
+    }
+    free(image);
+}
@@ -0,0 +1,75 @@
+/*
+* Predecode Cache Header File
+* This header file defines the warm-start cache stored next to a memory image (<image>.pdc).
+* It holds the parsed memory words, every word predecoded, and the basic-block/branch-target
+* analysis, in a fixed layout that is mmap'ed directly on later runs.
+*/
+
+#ifndef PREDECODE_H
+#define PREDECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "instruction_decoder.h"
+#include "trace_reader.h" // For MAX_MEMORY_LINES
+
+#define PREDECODE_MAGIC "MLPDC\0\0\0"
+#define PREDECODE_VERSION 1
+#define PREDECODE_SUFFIX ".pdc"
+#define PREDECODE_NO_TARGET 0xFFFFFFFFu // No static branch target (non-branch, JR)
+
+// Per-word flags
+#define PDC_CODE    0x01 // Reachable from PC 0 along static control flow
+#define PDC_LEADER  0x02 // First instruction of a basic block
+#define PDC_CONTROL 0x04 // Control transfer instruction (BZ, BEQ, JR, HALT)
+#define PDC_INVALID 0x08 // Word does not decode to a valid instruction
+
+// Compact predecoded instruction (8 bytes)
+typedef struct {
+    uint8_t opcode;
+    uint8_t type;
+    uint8_t rs;
+    uint8_t rt;
+    uint8_t rd;
+    uint8_t flags;
+    int16_t immediate;
+} PredecodedWord;
+
+/*
+* PredecodeFile structure:
+* On-disk layout of the cache file. The source hash and size identify the image file
+* contents, so any edit to the image invalidates the cache automatically.
+*/
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t word_count;      // Words parsed from the image
+    uint64_t source_hash;     // FNV-1a of the raw image file bytes
+    uint64_t source_size;     // Size of the raw image file in bytes
+    uint32_t num_blocks;      // Basic blocks found in reachable code
+    uint32_t num_code_words;  // Words reachable as code
+    uint32_t words[MAX_MEMORY_LINES];
+    PredecodedWord decoded[MAX_MEMORY_LINES];
+    uint32_t branch_target[MAX_MEMORY_LINES]; // Static target byte address, or PREDECODE_NO_TARGET
+} PredecodeFile;
+
+/*
+* PredecodeImage structure:
+* A loaded cache, either mmap'ed from <image>.pdc or built in memory on a miss.
+* Read-only once loaded, so one image can be attached to many simulator contexts.
+*/
+typedef struct {
+    const PredecodeFile *file;
+    int mapped; // 1 if file is an mmap of the cache file, 0 if heap allocated
+} PredecodeImage;
+
+// Simulator context (defined in sim_context.h)
+typedef struct SimContext SimContext;
+
+// Function prototypes
+int predecode_load_image(const char *filename, uint32_t *memory, PredecodeImage **image);
+int predecode_build_image(const char *text, size_t size, PredecodeImage **image);
+DecodedInstruction fetch_instruction(const SimContext *ctx, uint32_t pc);
+void predecode_release(PredecodeImage *image);
+
+#endif // PREDECODE_H
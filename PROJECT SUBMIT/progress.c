@@ -0,0 +1,124 @@
+/*
+* Progress Heartbeat
+* This file implements the progress heartbeat attached to a SimContext for long runs.
+* PROGRESS_UPDATE() in the step functions calls progress_check() once every "stride"
+* instructions plus cycles; progress_check() reads the monotonic clock, retunes the stride
+* and prints a line once the reporting interval has passed.
+*
+* Supported Operations:
+* - Current rate (since the previous line), and the average rate in the summary
+* - ETA against the instruction or cycle budget, whichever ends the run first
+* - A final summary line
+*
+* Functions:
+* - progress_init: Sets up a meter (attach it with ctx->progress = &meter).
+* - progress_check: Reads the clock and reports when due (via PROGRESS_UPDATE).
+* - progress_finish: Prints the summary line of the run.
+*/
+
+#include "progress.h"
+
+#include <string.h>
+
+#include "sim_context.h"
+#include "sim_util.h" // For sim_util_now_ns
+
+/*
+* Formats a duration in seconds as H:MM:SS.
+*/
+static void format_duration(double seconds, char *buf, size_t size) {
+    unsigned long long s = seconds > 0 ? (unsigned long long)(seconds + 0.5) : 0;
+    snprintf(buf, size, "%llu:%02llu:%02llu", s / 3600, s / 60 % 60, s % 60);
+}
+
+/*
+* Sets up a meter reporting to out every interval_sec seconds. max_instructions and
+* max_cycles are the budgets the ETA is estimated against (0 = unknown).
+*/
+void progress_init(ProgressMeter *pm, FILE *out, double interval_sec, uint64_t max_instructions,
+                   uint64_t max_cycles) {
+    memset(pm, 0, sizeof(ProgressMeter));
+    pm->out = out;
+    pm->interval_ns = interval_sec > 0 ? (uint64_t)(interval_sec * 1e9) : (uint64_t)(PROGRESS_DEFAULT_INTERVAL * 1e9);
+    pm->max_instructions = max_instructions;
+    pm->max_cycles = max_cycles;
+    pm->stride = 1024;
+}
+
+/*
+* Reads the clock for the context's meter: the first call starts the clock, later calls
+* adapt the stride and print a heartbeat line once per interval.
+*/
+void progress_check(SimContext *ctx) {
+    ProgressMeter *pm = ctx->progress;
+    uint64_t instructions = ctx->total_instructions;
+    uint64_t cycles = ctx->clock_cycles;
+    uint64_t now = sim_util_now_ns();
+
+    if (!pm->started) {
+        pm->started = 1;
+        pm->start_ns = pm->check_ns = pm->report_ns = now;
+        pm->start_instructions = pm->report_instructions = instructions;
+        pm->report_cycles = cycles;
+        pm->next_check = instructions + cycles + pm->stride;
+        return;
+    }
+
+    // Aim for PROGRESS_CHECKS_PER_INTERVAL clock reads per interval
+    uint64_t target = pm->interval_ns / PROGRESS_CHECKS_PER_INTERVAL;
+    uint64_t since_check = now - pm->check_ns;
+    if (since_check < target / 2 && pm->stride < (1ULL << 40)) {
+        pm->stride *= 2;
+    } else if (since_check > target * 2 && pm->stride > 1) {
+        pm->stride /= 2;
+    }
+    pm->check_ns = now;
+    pm->next_check = instructions + cycles + pm->stride;
+    if (now - pm->report_ns < pm->interval_ns) return;
+
+    double seconds = (double)(now - pm->report_ns) / 1e9;
+    double instruction_rate = (double)(instructions - pm->report_instructions) / seconds;
+    double cycle_rate = (double)(cycles - pm->report_cycles) / seconds;
+
+    // Remaining time to whichever budget ends the run first
+    double eta = -1;
+    if (pm->max_instructions && instruction_rate > 0 && instructions < pm->max_instructions) {
+        eta = (double)(pm->max_instructions - instructions) / instruction_rate;
+    }
+    if (pm->max_cycles && cycle_rate > 0 && cycles < pm->max_cycles) {
+        double cycle_eta = (double)(pm->max_cycles - cycles) / cycle_rate;
+        if (eta < 0 || cycle_eta < eta) eta = cycle_eta;
+    }
+
+    char elapsed[32], remaining[32];
+    format_duration((double)(now - pm->start_ns) / 1e9, elapsed, sizeof(elapsed));
+    if (eta >= 0) {
+        format_duration(eta, remaining, sizeof(remaining));
+    } else {
+        snprintf(remaining, sizeof(remaining), "unknown");
+    }
+    fprintf(pm->out, "Progress: %llu instructions, %llu cycles, %.2f M instructions/s, elapsed %s, ETA %s\n",
+            (unsigned long long)instructions, (unsigned long long)cycles, instruction_rate / 1e6, elapsed, remaining);
+    fflush(pm->out);
+
+    pm->report_ns = now;
+    pm->report_instructions = instructions;
+    pm->report_cycles = cycles;
+}
+
+/*
+* Prints the run's total time and average rate (nothing if the meter never started).
+*/
+void progress_finish(SimContext *ctx) {
+    ProgressMeter *pm = ctx->progress;
+    if (!pm || !pm->started) return;
+
+    uint64_t now = sim_util_now_ns();
+    double seconds = (double)(now - pm->start_ns) / 1e9;
+    uint64_t timed = ctx->total_instructions - pm->start_instructions;
+    char elapsed[32];
+    format_duration(seconds, elapsed, sizeof(elapsed));
+    fprintf(pm->out, "Progress: finished, %llu instructions in %s (%.2f M instructions/s)\n",
+            (unsigned long long)ctx->total_instructions, elapsed, seconds > 0 ? (double)timed / seconds / 1e6 : 0.0);
+    fflush(pm->out);
+}
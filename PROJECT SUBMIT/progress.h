@@ -0,0 +1,54 @@
+/*
+* Progress Heartbeat Header File
+* This header file declares the progress heartbeat of long runs: every few seconds a line
+* with the instructions and cycles so far, the current rate and an estimated remaining
+* time goes to stderr. The step functions only compare a counter against a threshold;
+* the clock is read every "stride" steps, and the stride adapts so that it is read a few
+* times per reporting interval whatever the simulation speed.
+*/
+
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define PROGRESS_DEFAULT_INTERVAL 10.0 // Seconds between heartbeat lines
+#define PROGRESS_CHECKS_PER_INTERVAL 8  // Clock reads aimed for per interval
+
+/*
+* ProgressMeter structure:
+* Attached to a SimContext (owned by the caller). The ETA is estimated against the budget
+* that ends the run first (instructions or cycles, 0 = unknown).
+*/
+typedef struct {
+    FILE *out;
+    uint64_t interval_ns;
+    uint64_t max_instructions;  // Expected end of the run, 0 = unknown
+    uint64_t max_cycles;        // Expected end of the run (NF/WF), 0 = unknown
+
+    uint64_t next_check;        // Work count (instructions + cycles) at which the clock is read
+    uint64_t stride;            // Work between clock reads
+    int started;
+    uint64_t start_ns, start_instructions;
+    uint64_t check_ns;          // Time of the last clock read
+    uint64_t report_ns, report_instructions, report_cycles; // At the last line
+} ProgressMeter;
+
+// Simulator context (defined in sim_context.h)
+typedef struct SimContext SimContext;
+
+// Called by the step functions: cheap unless the next clock read is due
+#define PROGRESS_UPDATE(ctx) \
+    do { \
+        if ((ctx)->progress && (ctx)->total_instructions + (ctx)->clock_cycles >= (ctx)->progress->next_check) \
+            progress_check(ctx); \
+    } while (0)
+
+// Function prototypes
+void progress_init(ProgressMeter *pm, FILE *out, double interval_sec, uint64_t max_instructions,
+                   uint64_t max_cycles);
+void progress_check(SimContext *ctx);
+void progress_finish(SimContext *ctx);
+
+#endif // PROGRESS_H
@@ -0,0 +1,162 @@
+/*
+* Result Cache
+* This file implements a content-addressed on-disk cache of simulation results.
+* The key is a hash of the memory image as loaded, the mode (FS, NF, WF) and the model
+* version. On a hit the final machine state and statistics are restored into the simulator
+* context without simulating, so print_final_state() produces the same report as a full run.
+*
+* Entries are written to a temporary file in the cache directory and renamed into place,
+* so concurrent runs sharing one directory never see a partially written entry.
+*
+* Functions:
+* - result_cache_key: Computes the cache key for an image and mode.
+* - result_cache_lookup: Restores a cached result into a context, if present.
+* - result_cache_store: Saves a context's final state as a cache entry.
+*/
+
+#include "result_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "sim_context.h"
+#include "sim_hash.h"
+
+/*
+* Computes the cache key from the loaded memory image, the mode and the model version.
+*/
+uint64_t result_cache_key(const uint32_t *input_memory, const char *mode) {
+    uint32_t versions[2] = { RESULT_CACHE_FORMAT_VERSION, RESULT_CACHE_MODEL_VERSION };
+    uint64_t hash = sim_hash_bytes(input_memory, sizeof(uint32_t) * 1024, SIM_HASH_SEED);
+    hash = sim_hash_string(mode, hash);
+    return sim_hash_bytes(versions, sizeof(versions), hash);
+}
+
+/*
+* Builds the entry file name for a key and mode.
+*/
+static void entry_path(char *buf, size_t len, const char *cache_dir, uint64_t key, const char *mode) {
+    snprintf(buf, len, "%s/%016llx-%s.res", cache_dir, (unsigned long long)key, mode);
+}
+
+/*
+* Looks up the result for this image and mode.
+* On a hit, restores the final state and statistics into ctx and returns 1.
+* Returns 0 on a miss (including unreadable, stale or mismatching entries).
+*/
+int result_cache_lookup(SimContext *ctx, const char *cache_dir, const uint32_t *input_memory, const char *mode) {
+    uint64_t key = result_cache_key(input_memory, mode);
+    char path[4096];
+    entry_path(path, sizeof(path), cache_dir, key, mode);
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return 0;
+
+    ResultCacheEntry *entry = malloc(sizeof(ResultCacheEntry));
+    if (!entry) {
+        fclose(file);
+        return 0;
+    }
+    size_t got = fread(entry, 1, sizeof(ResultCacheEntry), file);
+    fclose(file);
+
+    int hit = got == sizeof(ResultCacheEntry) &&
+              memcmp(entry->magic, RESULT_CACHE_MAGIC, 8) == 0 &&
+              entry->format_version == RESULT_CACHE_FORMAT_VERSION &&
+              entry->model_version == RESULT_CACHE_MODEL_VERSION &&
+              entry->key == key &&
+              strncmp(entry->mode, mode, sizeof(entry->mode)) == 0 &&
+              memcmp(entry->input_memory, input_memory, sizeof(entry->input_memory)) == 0;
+
+    if (hit) {
+        ctx->state = entry->final_state;
+        memcpy(ctx->register_written, entry->register_written, sizeof(entry->register_written));
+        memcpy(ctx->memory_changed, entry->memory_changed, sizeof(entry->memory_changed));
+        ctx->total_instructions = entry->total_instructions;
+        ctx->arithmetic_instructions = entry->arithmetic_instructions;
+        ctx->logical_instructions = entry->logical_instructions;
+        ctx->memory_access_instructions = entry->memory_access_instructions;
+        ctx->control_transfer_instructions = entry->control_transfer_instructions;
+        ctx->clock_cycles = entry->clock_cycles;
+        ctx->total_stalls = entry->total_stalls;
+        ctx->total_flushes = entry->total_flushes;
+        ctx->cpi = entry->cpi;
+        DBG_PRINTF("Result cache hit: %s\n", path);
+    }
+    free(entry);
+    return hit;
+}
+
+/*
+* Stores the context's final state as the result for this image and mode.
+* The entry is written to a unique temporary file and atomically renamed into place.
+* Returns 0 on success, -1 on failure (the run itself is unaffected).
+*/
+int result_cache_store(const SimContext *ctx, const char *cache_dir, const uint32_t *input_memory, const char *mode) {
+    ResultCacheEntry *entry = calloc(1, sizeof(ResultCacheEntry));
+    if (!entry) return -1;
+
+    memcpy(entry->magic, RESULT_CACHE_MAGIC, 8);
+    entry->format_version = RESULT_CACHE_FORMAT_VERSION;
+    entry->model_version = RESULT_CACHE_MODEL_VERSION;
+    entry->key = result_cache_key(input_memory, mode);
+    strncpy(entry->mode, mode, sizeof(entry->mode) - 1);
+    memcpy(entry->input_memory, input_memory, sizeof(entry->input_memory));
+    entry->final_state = ctx->state;
+    memcpy(entry->register_written, ctx->register_written, sizeof(entry->register_written));
+    memcpy(entry->memory_changed, ctx->memory_changed, sizeof(entry->memory_changed));
+    entry->total_instructions = ctx->total_instructions;
+    entry->arithmetic_instructions = ctx->arithmetic_instructions;
+    entry->logical_instructions = ctx->logical_instructions;
+    entry->memory_access_instructions = ctx->memory_access_instructions;
+    entry->control_transfer_instructions = ctx->control_transfer_instructions;
+    entry->clock_cycles = ctx->clock_cycles;
+    entry->total_stalls = ctx->total_stalls;
+    entry->total_flushes = ctx->total_flushes;
+    entry->cpi = ctx->cpi;
+
+    char path[4096], tmp_path[4096];
+    entry_path(path, sizeof(path), cache_dir, entry->key, mode);
+    snprintf(tmp_path, sizeof(tmp_path), "%s/.tmp-%ld-XXXXXX", cache_dir, (long)getpid());
+
+    int fd = mkstemp(tmp_path);
+    if (fd < 0) {
+        fprintf(stderr, "Warning: Cannot write result cache entry in '%s': %s\n", cache_dir, strerror(errno));
+        free(entry);
+        return -1;
+    }
+    fchmod(fd, 0644); // mkstemp creates 0600; cache directories may be shared between users
+
+    const char *p = (const char *)entry;
+    size_t left = sizeof(ResultCacheEntry);
+    while (left > 0) {
+        ssize_t n = write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        p += n;
+        left -= (size_t)n;
+    }
+    free(entry);
+
+    int failed = left > 0 || fsync(fd) < 0;
+    if (close(fd) < 0) failed = 1;
+    if (failed) {
+        fprintf(stderr, "Warning: Failed to write result cache entry '%s'\n", tmp_path);
+        unlink(tmp_path);
+        return -1;
+    }
+    // rename() is atomic: readers see either the old entry, no entry, or the complete new one
+    if (rename(tmp_path, path) < 0) {
+        fprintf(stderr, "Warning: Failed to publish result cache entry '%s': %s\n", path, strerror(errno));
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
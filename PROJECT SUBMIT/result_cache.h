@@ -0,0 +1,50 @@
+/*
+* Result Cache Header File
+* This header file declares the on-disk cache of simulation results. Entries are keyed by
+* a hash of the loaded memory image, the simulation mode and the model parameters, and
+* hold the final machine state and all statistics counters.
+*/
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <stdint.h>
+#include "functional_sim.h" // For MachineState and SimContext
+#include "cpi_stack.h"      // For CpiStack
+
+#define RESULT_CACHE_MAGIC "MLRCACHE"
+#define RESULT_CACHE_FORMAT_VERSION 3 // 2: 64-bit counters, 3: CPI stack
+#define RESULT_CACHE_MODEL_VERSION 1 // Bump whenever simulator semantics or timing change
+
+/*
+* ResultCacheEntry structure:
+* Fixed-size record stored in one file per (image, mode, configuration).
+* The input image is stored as well so that a hash collision can never return a wrong result.
+*/
+typedef struct {
+    char magic[8];
+    uint32_t format_version;
+    uint32_t model_version;
+    uint64_t key;
+    char mode[4];
+    uint32_t input_memory[1024]; // Memory image before simulation
+    MachineState final_state;
+    int register_written[32];
+    int memory_changed[1024];
+    uint64_t total_instructions;
+    uint64_t arithmetic_instructions;
+    uint64_t logical_instructions;
+    uint64_t memory_access_instructions;
+    uint64_t control_transfer_instructions;
+    uint64_t clock_cycles;
+    uint64_t total_stalls;
+    uint64_t total_flushes;
+    CpiStack cpi;
+} ResultCacheEntry;
+
+// Function prototypes
+uint64_t result_cache_key(const uint32_t *input_memory, const char *mode);
+int result_cache_lookup(SimContext *ctx, const char *cache_dir, const uint32_t *input_memory, const char *mode);
+int result_cache_store(const SimContext *ctx, const char *cache_dir, const uint32_t *input_memory, const char *mode);
+
+#endif // RESULT_CACHE_H
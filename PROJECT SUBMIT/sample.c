@@ -0,0 +1,241 @@
+/*
+* Sampled Simulation
+* This file implements "--sample <image>", systematic sampling in the style of SMARTS.
+* The run is divided into periods of --interval instructions. In each period the program
+* is fast-forwarded functionally, then --warmup instructions are replayed through a fresh
+* NF/WF timing model to rebuild pipeline, register availability and cache state, and the
+* following --unit instructions are measured. The per-sample CPIs give a mean CPI, its
+* confidence interval (normal approximation), and the estimated total cycles. Only
+* (warmup + unit) / interval of the instructions are timed in detail.
+*
+* Supported Operations:
+* - Configurable sample interval, measured unit size, warmup and confidence level
+* - NF or WF timing, optionally with a direct-mapped data cache
+* - Samples needed for a target error, and a full-run comparison (--check)
+*
+* Functions:
+* - sample_main: Parses options, runs the sampled simulation and prints the estimate.
+*/
+
+#include "sample.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "commit_trace.h"
+#include "sim_context.h"
+#include "sim_util.h"     // For the clock and the common driver options
+#include "timing_model.h"
+#include "trace_reader.h"
+
+/*
+* Adds one sample CPI to the running statistics.
+*/
+static void sample_stats_add(SampleStats *stats, double cpi) {
+    stats->count++;
+    double delta = cpi - stats->mean;
+    stats->mean += delta / (double)stats->count;
+    stats->m2 += delta * (cpi - stats->mean);
+}
+
+/*
+* Returns the two-sided standard normal quantile of a confidence level, 0 if unsupported.
+*/
+static double sample_z(int confidence) {
+    switch (confidence) {
+        case 90: return 1.6449;
+        case 95: return 1.9600;
+        case 99: return 2.5758;
+        default: return 0.0;
+    }
+}
+
+/*
+* Runs a sampled simulation of the image in ctx.
+* Returns the number of instructions executed; fills stats, and the detailed instruction count.
+*/
+static uint64_t sample_run(SimContext *ctx, const PipelineConfig *cfg, uint64_t interval, uint64_t unit,
+                           uint64_t warmup, uint64_t max_instructions, SampleStats *stats, uint64_t *detailed) {
+    CommitRecord rec;
+    uint64_t count = 0;
+    int running = 1;
+
+    while (running) {
+        // Fast-forward to the warmup of this period's sample (placed at the end of the period)
+        uint64_t skip = interval - unit - warmup;
+        for (uint64_t i = 0; i < skip && running; i++) {
+            running = count < max_instructions && commit_trace_step(ctx, &rec, NULL);
+            count += running;
+        }
+
+        TimingModel tm;
+        if (!running || timing_model_init(&tm, cfg) < 0) break;
+        uint64_t base_cycles = 0, measured = 0;
+        for (uint64_t i = 0; i < warmup + unit && running; i++) {
+            running = count < max_instructions && commit_trace_step(ctx, &rec, NULL);
+            if (!running) break;
+            count++;
+            (*detailed)++;
+            timing_model_commit(&tm, &rec);
+            if (i + 1 == warmup) base_cycles = tm.cycles;
+            if (i >= warmup) measured++;
+        }
+        if (measured == unit) {
+            sample_stats_add(stats, (double)(tm.cycles - base_cycles) / (double)unit);
+        }
+        timing_model_free(&tm);
+    }
+    return count;
+}
+
+/*
+* Prints the sampling usage.
+*/
+static void print_sample_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --sample <memory_image_file> [options]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --interval=<n>            Instructions per sampling period (default %llu)\n",
+            (unsigned long long)SAMPLE_DEFAULT_INTERVAL);
+    fprintf(stderr, "  --unit=<n>                Instructions measured per sample (default %llu)\n",
+            (unsigned long long)SAMPLE_DEFAULT_UNIT);
+    fprintf(stderr, "  --warmup=<n>              Detailed warmup before each sample (default %llu)\n",
+            (unsigned long long)SAMPLE_DEFAULT_WARMUP);
+    fprintf(stderr, "  --confidence=<90|95|99>   Confidence level (default %d)\n", SAMPLE_DEFAULT_CONFIDENCE);
+    fprintf(stderr, "  --check                   Also time the full run and report the actual error\n");
+    sim_util_driver_usage(SAMPLE_DEFAULT_MAX_INSTRUCTIONS, 0);
+}
+
+/*
+* Entry point for the sampling driver.
+* argv[0] is "--sample" and argv[1] the memory image.
+* Returns 0 on success, 2 on usage, I/O or allocation errors.
+*/
+int sample_main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_sample_usage("simulator");
+        return 2;
+    }
+
+    const char *image_file = argv[1];
+    uint64_t interval = SAMPLE_DEFAULT_INTERVAL;
+    uint64_t unit = SAMPLE_DEFAULT_UNIT;
+    uint64_t warmup = SAMPLE_DEFAULT_WARMUP;
+    int confidence = SAMPLE_DEFAULT_CONFIDENCE;
+    DriverOptions opts;
+    sim_util_driver_init(&opts, SAMPLE_DEFAULT_MAX_INSTRUCTIONS);
+
+    for (int i = 2; i < argc; i++) {
+        int common = sim_util_driver_option(&opts, argv[i], 0); // Samples are timed serially
+        if (common < 0) return 2;
+        if (common) continue;
+        if (strncmp(argv[i], "--interval=", 11) == 0) {
+            if (sim_util_parse_count("--interval", argv[i] + 11, &interval, 0) < 0) return 2;
+        } else if (strncmp(argv[i], "--unit=", 7) == 0) {
+            if (sim_util_parse_count("--unit", argv[i] + 7, &unit, 0) < 0) return 2;
+        } else if (strncmp(argv[i], "--warmup=", 9) == 0) {
+            if (sim_util_parse_count("--warmup", argv[i] + 9, &warmup, 1) < 0) return 2;
+        } else if (strncmp(argv[i], "--confidence=", 13) == 0) {
+            confidence = atoi(argv[i] + 13);
+            if (sample_z(confidence) == 0.0) {
+                fprintf(stderr, "Error: Unsupported confidence level '%s' (90, 95 or 99)\n", argv[i] + 13);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            print_sample_usage("simulator");
+            return 2;
+        }
+    }
+    if (unit + warmup > interval) {
+        fprintf(stderr, "Error: --unit plus --warmup must not exceed --interval\n");
+        return 2;
+    }
+    const char *mode = opts.mode;
+    uint64_t max_instructions = opts.max_instructions;
+    int dcache_lines = opts.dcache_lines;
+    int check = opts.check;
+
+    PipelineConfig cfg;
+    pipeline_config_preset(&cfg, strcmp(mode, "WF") == 0);
+    cfg.dcache_lines = dcache_lines;
+
+    static uint32_t memory[MAX_MEMORY_LINES];
+    if (read_memory_image(image_file, memory) < 0) {
+        fprintf(stderr, "Error: Failed to load memory image from file '%s'\n", image_file);
+        return 2;
+    }
+    SimContext *ctx = sim_context_create();
+    if (!ctx) {
+        perror("Error allocating simulator context");
+        return 2;
+    }
+    memcpy(ctx->state.memory, memory, sizeof(memory));
+
+    SampleStats stats;
+    memset(&stats, 0, sizeof(stats));
+    uint64_t detailed = 0;
+    uint64_t start_ns = sim_util_now_ns();
+    uint64_t count = sample_run(ctx, &cfg, interval, unit, warmup, max_instructions, &stats, &detailed);
+    uint64_t sample_ns = sim_util_now_ns() - start_ns;
+    int complete = ctx->halted;
+    sim_context_destroy(ctx);
+
+    if (!complete) {
+        fprintf(stderr, "Warning: '%s' did not halt within %" PRIu64 " instructions; the estimate covers that prefix\n",
+                image_file, count);
+    }
+    printf("Sampled %s timing: %" PRIu64 " instructions, interval %" PRIu64 ", unit %" PRIu64 ", warmup %" PRIu64 "\n",
+           mode, count, interval, unit, warmup);
+    if (stats.count == 0) {
+        fprintf(stderr, "Error: No complete sample in %" PRIu64 " instructions; reduce --interval\n", count);
+        return 2;
+    }
+
+    // Normal approximation of the mean CPI (no interval from a single sample)
+    double z = sample_z(confidence);
+    double stddev = stats.count > 1 ? sqrt(stats.m2 / (double)(stats.count - 1)) : 0.0;
+    double half_width = stats.count > 1 ? z * stddev / sqrt((double)stats.count) : 0.0;
+    double cycles = stats.mean * (double)count;
+    printf("Samples: %" PRIu64 " (%" PRIu64 " instructions timed in detail, %.2f%% of the run)\n",
+           stats.count, detailed, count ? 100.0 * (double)detailed / (double)count : 0.0);
+    printf("CPI: %.4f +/- %.4f (%d%% confidence, relative %.2f%%), sample stddev %.4f\n",
+           stats.mean, half_width, confidence, stats.mean > 0 ? 100.0 * half_width / stats.mean : 0.0, stddev);
+    printf("Estimated clock cycles: %.0f [%.0f, %.0f]\n", cycles,
+           (stats.mean - half_width) * (double)count, (stats.mean + half_width) * (double)count);
+    if (stats.mean > 0 && stats.count > 1) {
+        // Samples needed for +/-3% at this confidence level, given the observed variation
+        double ratio = z * (stddev / stats.mean) / 0.03;
+        printf("Samples needed for +/-3%%: %.0f\n", ceil(ratio * ratio));
+    }
+    printf("Time: sampled %.3f ms\n", sample_ns / 1e6);
+
+    if (check) {
+        // Reference: the same prefix timed in full
+        ctx = sim_context_create();
+        TimingModel tm;
+        if (!ctx || timing_model_init(&tm, &cfg) < 0) {
+            fprintf(stderr, "Error: Cannot allocate the full-run check\n");
+            sim_context_destroy(ctx);
+            return 2;
+        }
+        memcpy(ctx->state.memory, memory, sizeof(memory));
+        start_ns = sim_util_now_ns();
+        CommitRecord rec;
+        for (uint64_t i = 0; i < count && commit_trace_step(ctx, &rec, NULL); i++) {
+            timing_model_commit(&tm, &rec);
+        }
+        uint64_t full_ns = sim_util_now_ns() - start_ns;
+        double error = tm.cycles ? (cycles - (double)tm.cycles) / (double)tm.cycles : 0.0;
+        double cpi = count ? (double)tm.cycles / (double)count : 0.0;
+        printf("Full run: %" PRIu64 " clock cycles, CPI %.4f (%s the interval); estimate error %+.3f%%\n",
+               tm.cycles, cpi, fabs(cpi - stats.mean) <= half_width ? "inside" : "outside", 100.0 * error);
+        printf("Time: full %.3f ms (sampling speedup %.1fx)\n", full_ns / 1e6,
+               sample_ns ? (double)full_ns / (double)sample_ns : 0.0);
+        timing_model_free(&tm);
+        sim_context_destroy(ctx);
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+/*
+* Sampled Simulation Header File
+* This header file declares the SMARTS-style sampling driver: the program is fast-forwarded
+* functionally between samples, and short windows at a fixed interval are timed in detail
+* (after a warmup) to estimate CPI with a confidence interval.
+*/
+
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include <stdint.h>
+
+#define SAMPLE_DEFAULT_INTERVAL 100000ULL         // Instructions from one sample start to the next
+#define SAMPLE_DEFAULT_UNIT 1000ULL               // Instructions measured per sample
+#define SAMPLE_DEFAULT_WARMUP 2000ULL             // Detailed warmup instructions before each sample
+#define SAMPLE_DEFAULT_CONFIDENCE 95              // Confidence level of the reported interval (90, 95 or 99)
+#define SAMPLE_DEFAULT_MAX_INSTRUCTIONS 1000000000ULL // Functional run limit
+
+/*
+* SampleStats structure:
+* Running moments of the per-sample CPI (Welford's method).
+*/
+typedef struct {
+    uint64_t count;
+    double mean;
+    double m2;   // Sum of squared deviations from the mean
+} SampleStats;
+
+// Entry point for "<prog> --sample <image> [options]"; returns 0 on success, 2 on errors
+int sample_main(int argc, char *argv[]);
+
+#endif // SAMPLE_H
@@ -0,0 +1,275 @@
+/*
+* Segmented Timing
+* This file implements "--segmented <image>": one long run is timed on many cores. The
+* program is executed functionally once, storing an architectural checkpoint at the start
+* of every segment's warmup. Each segment then re-executes from its checkpoint on a thread
+* pool worker and feeds a fresh timing model: the warmup instructions rebuild pipeline,
+* register availability and data cache state, and only the segment's own instructions are
+* counted. Segment cycles are stitched together in order. With --check the functional pass
+* also times the whole run serially, so the stitching error is reported per segment and
+* in total.
+*
+* Supported Operations:
+* - Configurable segment length and warmup overlap (warmup 0 = cold segments)
+* - NF or WF timing, optionally with a direct-mapped data cache
+* - Stitched cycles/stalls/CPI, per-segment and total error against a serial run
+*
+* Functions:
+* - segment_main: Parses options, runs the segmented simulation and prints the results.
+*/
+
+#include "segment.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "commit_trace.h"
+#include "sim_context.h"
+#include "sim_util.h"     // For the clock and the common driver options
+#include "thread_pool.h"
+#include "trace_reader.h"
+
+#define SEGMENT_INITIAL_CHECKPOINTS 64 // Initial checkpoint capacity (grows as needed)
+
+// One pool task: time one segment
+typedef struct {
+    const PipelineConfig *cfg;
+    SegmentResult *result;
+    int ok;
+} SegmentTask;
+
+/*
+* Returns the instruction index at which the warmup of segment k starts.
+*/
+static uint64_t segment_checkpoint_index(uint64_t k, uint64_t length, uint64_t warmup) {
+    uint64_t start = k * length;
+    return start > warmup ? start - warmup : 0;
+}
+
+/*
+* Pool task: restores the segment's checkpoint, replays the warmup and times the segment.
+*/
+static void segment_run(void *arg, int worker) {
+    (void)worker;
+    SegmentTask *task = arg;
+    SegmentResult *result = task->result;
+    uint64_t start_ns = sim_util_now_ns();
+
+    SimContext *ctx = sim_context_create();
+    TimingModel tm;
+    if (!ctx) return; // task->ok stays 0
+    if (timing_model_init(&tm, task->cfg) < 0) {
+        sim_context_destroy(ctx);
+        return;
+    }
+    ctx->state = result->checkpoint->state;
+
+    CommitRecord rec;
+    for (uint64_t i = 0; i < result->warmup && commit_trace_step(ctx, &rec, NULL); i++) {
+        timing_model_commit(&tm, &rec);
+    }
+    uint64_t base_cycles = tm.cycles;
+    uint64_t base_stalls = tm.stalls;
+    for (uint64_t i = 0; i < result->length && commit_trace_step(ctx, &rec, NULL); i++) {
+        timing_model_commit(&tm, &rec);
+    }
+    result->cycles = tm.cycles - base_cycles;
+    result->stalls = tm.stalls - base_stalls;
+    result->time_ns = sim_util_now_ns() - start_ns;
+    task->ok = 1;
+
+    timing_model_free(&tm);
+    sim_context_destroy(ctx);
+}
+
+/*
+* Prints the segmented timing usage.
+*/
+static void print_segment_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --segmented <memory_image_file> [options]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --segment=<n>             Instructions per segment (default %llu)\n",
+            (unsigned long long)SEGMENT_DEFAULT_LENGTH);
+    fprintf(stderr, "  --warmup=<n>              Warmup instructions before each segment (default %llu)\n",
+            (unsigned long long)SEGMENT_DEFAULT_WARMUP);
+    fprintf(stderr, "  --check                   Also time the full run serially and report the stitching error\n");
+    sim_util_driver_usage(SEGMENT_DEFAULT_MAX_INSTRUCTIONS, 1);
+}
+
+/*
+* Entry point for the segmented timing driver.
+* argv[0] is "--segmented" and argv[1] the memory image.
+* Returns 0 on success, 2 on usage, I/O or allocation errors.
+*/
+int segment_main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_segment_usage("simulator");
+        return 2;
+    }
+
+    const char *image_file = argv[1];
+    uint64_t length = SEGMENT_DEFAULT_LENGTH;
+    uint64_t warmup = SEGMENT_DEFAULT_WARMUP;
+    DriverOptions opts;
+    sim_util_driver_init(&opts, SEGMENT_DEFAULT_MAX_INSTRUCTIONS);
+
+    for (int i = 2; i < argc; i++) {
+        int common = sim_util_driver_option(&opts, argv[i], 1);
+        if (common < 0) return 2;
+        if (common) continue;
+        if (strncmp(argv[i], "--segment=", 10) == 0) {
+            if (sim_util_parse_count("--segment", argv[i] + 10, &length, 0) < 0) return 2;
+        } else if (strncmp(argv[i], "--warmup=", 9) == 0) {
+            if (sim_util_parse_count("--warmup", argv[i] + 9, &warmup, 1) < 0) return 2;
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            print_segment_usage("simulator");
+            return 2;
+        }
+    }
+    const char *mode = opts.mode;
+    uint64_t max_instructions = opts.max_instructions;
+    int dcache_lines = opts.dcache_lines;
+    int threads = opts.threads;
+    int check = opts.check;
+
+    PipelineConfig cfg;
+    pipeline_config_preset(&cfg, strcmp(mode, "WF") == 0);
+    cfg.dcache_lines = dcache_lines;
+
+    SimContext *ctx = sim_context_create();
+    if (!ctx) {
+        perror("Error allocating simulator context");
+        return 2;
+    }
+    if (read_memory_image(image_file, ctx->state.memory) < 0) {
+        fprintf(stderr, "Error: Failed to load memory image from file '%s'\n", image_file);
+        sim_context_destroy(ctx);
+        return 2;
+    }
+
+    // Functional pass: checkpoints at every warmup start, serial boundaries with --check
+    uint64_t fs_start_ns = sim_util_now_ns();
+    SegmentCheckpoint *checkpoints = NULL;
+    uint64_t *boundaries = NULL; // Serial cycles before each segment
+    size_t num_checkpoints = 0, capacity = 0;
+    size_t num_boundaries = 0;
+    TimingModel serial;
+    int failed = check && timing_model_init(&serial, &cfg) < 0;
+
+    uint64_t count = 0;
+    CommitRecord rec;
+    while (!failed) {
+        while (!failed && segment_checkpoint_index(num_checkpoints, length, warmup) == count) {
+            if (num_checkpoints == capacity) {
+                capacity = capacity ? capacity * 2 : SEGMENT_INITIAL_CHECKPOINTS;
+                SegmentCheckpoint *grown = realloc(checkpoints, capacity * sizeof(SegmentCheckpoint));
+                uint64_t *grown_boundaries = grown ? realloc(boundaries, capacity * sizeof(uint64_t)) : NULL;
+                if (grown) checkpoints = grown;
+                if (grown_boundaries) boundaries = grown_boundaries;
+                failed = !grown || !grown_boundaries;
+                if (failed) break;
+            }
+            checkpoints[num_checkpoints].index = count;
+            checkpoints[num_checkpoints].state = ctx->state;
+            num_checkpoints++;
+        }
+        if (check && count % length == 0) boundaries[num_boundaries++] = serial.cycles;
+        if (failed || count == max_instructions || !commit_trace_step(ctx, &rec, NULL)) break;
+        if (check) timing_model_commit(&serial, &rec);
+        count++;
+    }
+    int complete = ctx->halted;
+    sim_context_destroy(ctx);
+    uint64_t fs_ns = sim_util_now_ns() - fs_start_ns;
+
+    size_t num_segments = (size_t)((count + length - 1) / length);
+    SegmentResult *results = calloc(num_segments ? num_segments : 1, sizeof(SegmentResult));
+    SegmentTask *tasks = calloc(num_segments ? num_segments : 1, sizeof(SegmentTask));
+    if (threads <= 0) threads = thread_pool_default_size();
+    ThreadPool *pool = (!failed && results && tasks) ? thread_pool_create(threads) : NULL;
+    if (!pool) {
+        fprintf(stderr, "Error: Cannot allocate the segmented simulation\n");
+        free(results);
+        free(tasks);
+        free(checkpoints);
+        free(boundaries);
+        if (check) timing_model_free(&serial);
+        return 2;
+    }
+    if (!complete) {
+        fprintf(stderr, "Warning: '%s' did not halt within %" PRIu64 " instructions; timing covers that prefix\n",
+                image_file, count);
+    }
+
+    // Timing pass: every segment in parallel
+    uint64_t timing_start_ns = sim_util_now_ns();
+    for (size_t k = 0; k < num_segments; k++) {
+        SegmentResult *r = &results[k];
+        r->start = k * length;
+        r->length = (r->start + length <= count) ? length : count - r->start;
+        r->checkpoint = &checkpoints[k];
+        r->warmup = r->start - checkpoints[k].index;
+        if (check) {
+            uint64_t end = (k + 1 < num_boundaries) ? boundaries[k + 1] : serial.cycles;
+            r->serial_cycles = end - boundaries[k];
+        }
+        tasks[k].cfg = &cfg;
+        tasks[k].result = r;
+        if (thread_pool_submit(pool, segment_run, &tasks[k]) < 0) {
+            segment_run(&tasks[k], -1);
+        }
+    }
+    thread_pool_wait(pool);
+    thread_pool_destroy(pool);
+    uint64_t timing_ns = sim_util_now_ns() - timing_start_ns;
+
+    // Stitch the segments together and report
+    int result = 0;
+    uint64_t cycles = 0, stalls = 0, segment_ns = 0;
+    double max_error = 0.0;
+    printf("Segmented %s timing: %" PRIu64 " instructions in %zu segments of %" PRIu64 " (warmup %" PRIu64 ") on %d threads\n",
+           mode, count, num_segments, length, warmup, threads);
+    printf("%8s %12s %10s %8s %12s %10s %7s", "segment", "start", "instrs", "warmup", "cycles", "stalls", "CPI");
+    if (check) printf(" %12s %9s", "serial", "error");
+    printf("\n");
+    for (size_t k = 0; k < num_segments; k++) {
+        const SegmentResult *r = &results[k];
+        if (!tasks[k].ok) {
+            fprintf(stderr, "Error: Segment %zu could not be simulated\n", k);
+            result = 2;
+            continue;
+        }
+        cycles += r->cycles;
+        stalls += r->stalls;
+        segment_ns += r->time_ns;
+        printf("%8zu %12" PRIu64 " %10" PRIu64 " %8" PRIu64 " %12" PRIu64 " %10" PRIu64 " %7.3f", k, r->start,
+               r->length, r->warmup, r->cycles, r->stalls, r->length ? (double)r->cycles / (double)r->length : 0.0);
+        if (check) {
+            double error = r->serial_cycles ? ((double)r->cycles - (double)r->serial_cycles) / (double)r->serial_cycles : 0.0;
+            if (error < 0 ? -error > max_error : error > max_error) max_error = error < 0 ? -error : error;
+            printf(" %12" PRIu64 " %+8.3f%%", r->serial_cycles, 100.0 * error);
+        }
+        printf("\n");
+    }
+
+    printf("Stitched: %" PRIu64 " clock cycles, %" PRIu64 " stalls, CPI %.4f\n",
+           cycles, stalls, count ? (double)cycles / (double)count : 0.0);
+    if (check) {
+        double error = serial.cycles ? ((double)cycles - (double)serial.cycles) / (double)serial.cycles : 0.0;
+        printf("Serial:   %" PRIu64 " clock cycles, %" PRIu64 " stalls; stitching error %+" PRId64 " cycles (%+.4f%%), "
+               "worst segment %.3f%%\n", serial.cycles, serial.stalls, (int64_t)(cycles - serial.cycles),
+               100.0 * error, 100.0 * max_error);
+        timing_model_free(&serial);
+    }
+    printf("Time: functional %.3f ms, timing %.3f ms wall (%.3f ms summed over segments)\n",
+           fs_ns / 1e6, timing_ns / 1e6, segment_ns / 1e6);
+
+    free(results);
+    free(tasks);
+    free(checkpoints);
+    free(boundaries);
+    return result;
+}
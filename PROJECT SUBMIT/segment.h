@@ -0,0 +1,47 @@
+/*
+* Segmented Timing Header File
+* This header file declares the segmented timing driver, which runs a program functionally
+* once while storing architectural checkpoints, then times fixed-size segments of the run
+* in parallel (each after a warmup overlap) and stitches their cycle counts together.
+*/
+
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <stdint.h>
+#include "functional_sim.h" // For MachineState
+#include "timing_model.h"   // For PipelineConfig
+
+#define SEGMENT_DEFAULT_LENGTH 100000ULL          // Instructions per segment
+#define SEGMENT_DEFAULT_WARMUP 1000ULL            // Instructions replayed before a segment is measured
+#define SEGMENT_DEFAULT_MAX_INSTRUCTIONS 100000000ULL // Functional run limit
+
+/*
+* SegmentCheckpoint structure:
+* Architectural state after a given number of committed instructions.
+*/
+typedef struct {
+    uint64_t index;     // Instructions committed before this state
+    MachineState state;
+} SegmentCheckpoint;
+
+/*
+* SegmentResult structure:
+* One segment: the instructions [start, start + length) timed after warming up from
+* checkpoint->index (warmup = start - checkpoint->index instructions).
+*/
+typedef struct {
+    uint64_t start;
+    uint64_t length;
+    uint64_t warmup;
+    const SegmentCheckpoint *checkpoint;
+    uint64_t cycles;        // Cycles attributed to the segment (WB of its last minus WB before it)
+    uint64_t stalls;
+    uint64_t serial_cycles; // Same span in the full serial run (with --check)
+    uint64_t time_ns;       // Wall time of the segment's simulation (warmup included)
+} SegmentResult;
+
+// Entry point for "<prog> --segmented <image> [options]"; returns 0 on success, 2 on errors
+int segment_main(int argc, char *argv[]);
+
+#endif // SEGMENT_H
@@ -0,0 +1,62 @@
+/*
+* Simulator Context
+* This file implements creation, reset and destruction of simulator contexts.
+*
+* Functions:
+* - sim_context_create: Allocates a context with an initialized machine state.
+* - sim_context_reset: Clears machine state, statistics and pipeline, keeping attachments
+*   and the watchdog configuration.
+* - sim_context_destroy: Frees a context (attachments are owned by the caller).
+*/
+
+#include "sim_context.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+* Allocates a new context with zeroed machine state and counters, an empty pipeline and
+* the default watchdog configuration.
+* Returns NULL if the allocation fails.
+*/
+SimContext *sim_context_create(void) {
+    SimContext *ctx = calloc(1, sizeof(SimContext));
+    if (!ctx) return NULL;
+    watchdog_config_default(&ctx->watchdog.cfg);
+    sim_context_reset(ctx);
+    return ctx;
+}
+
+/*
+* Resets everything except the attachments (pipeline viewer export, predecoded image,
+* progress heartbeat, live statistics, per-PC profile)
+* and the watchdog configuration.
+*/
+void sim_context_reset(SimContext *ctx) {
+    KanataWriter *kanata = ctx->kanata;
+    const PredecodeFile *predecode = ctx->predecode;
+    ProgressMeter *progress = ctx->progress;
+    LiveStats *live_stats = ctx->live_stats;
+    PcProfile *pc_profile = ctx->pc_profile;
+    WatchdogConfig watchdog = ctx->watchdog.cfg;
+
+    memset(ctx, 0, sizeof(SimContext));
+    initialize_machine_state(ctx);
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        insert_nop(i, ctx->pipeline);
+    }
+
+    ctx->kanata = kanata;
+    ctx->predecode = predecode;
+    ctx->progress = progress;
+    ctx->live_stats = live_stats;
+    ctx->pc_profile = pc_profile;
+    ctx->watchdog.cfg = watchdog;
+}
+
+/*
+* Frees a context.
+*/
+void sim_context_destroy(SimContext *ctx) {
+    free(ctx);
+}
@@ -0,0 +1,72 @@
+/*
+* Simulator Context Header File
+* This header file defines the simulator context: the complete state of one simulation
+* (machine state, change tracking, statistics counters and pipeline registers).
+* Every simulator function takes a context, so independent simulations can run in one
+* process, including concurrently on different threads, with no shared mutable state.
+*/
+
+#ifndef SIM_CONTEXT_H
+#define SIM_CONTEXT_H
+
+#include <stdint.h>
+#include "functional_sim.h" // For MachineState
+#include "no_fwd.h"         // For PipelineRegister and PIPELINE_DEPTH
+#include "kanata.h"         // For KanataWriter
+#include "predecode.h"      // For PredecodeFile
+#include "watchdog.h"       // For Watchdog
+#include "progress.h"       // For ProgressMeter
+#include "live_stats.h"     // For LiveStats
+#include "cpi_stack.h"      // For CpiStack
+#include "pc_profile.h"     // For PcProfile
+
+/*
+* SimContext structure:
+* Heap-allocated by sim_context_create(). The optional attachments (pipeline viewer export,
+* predecoded image, progress heartbeat, live statistics, per-PC profile) are owned by the
+* caller; a predecoded image is read-only and may be shared by many contexts.
+*/
+struct SimContext {
+    // Architectural state
+    MachineState state;
+    int register_written[32];   // Registers written (for final output tracking)
+    int memory_changed[1024];   // Memory words written by stores
+
+    // Instruction counters (64-bit: long runs pass 2^31 instructions and cycles)
+    uint64_t total_instructions;
+    uint64_t arithmetic_instructions;
+    uint64_t logical_instructions;
+    uint64_t memory_access_instructions;
+    uint64_t control_transfer_instructions;
+
+    // Timing counters (NF and WF)
+    uint64_t clock_cycles;
+    uint64_t total_stalls;
+    uint64_t total_flushes; // Not printed for WF, but tracked internally
+    CpiStack cpi;           // Every clock cycle by category (sums to clock_cycles)
+
+    // Pipeline model state (NF and WF)
+    PipelineRegister pipeline[PIPELINE_DEPTH];
+    uint32_t pipeline_pc;        // PC of the instruction to be fetched next
+    int pipeline_halt_seen;      // Set once HALT has been fetched
+    uint64_t pipeline_fetch_seq; // Numbers fetched instructions for pipeline traces
+
+    int halted; // Set once the run has finished (HALT, PC out of bounds or the watchdog)
+
+    // Budgets and livelock detection (the configuration survives sim_context_reset)
+    Watchdog watchdog;
+
+    // Optional attachments (NULL when unused)
+    KanataWriter *kanata;             // Pipeline viewer export
+    const PredecodeFile *predecode;   // Predecoded image used by fetch_instruction
+    ProgressMeter *progress;          // Heartbeat of long runs
+    LiveStats *live_stats;            // Counters page and SIGUSR1 snapshot
+    PcProfile *pc_profile;            // Per-PC stall and flush profile (NF/WF)
+};
+
+// Function prototypes
+SimContext *sim_context_create(void);
+void sim_context_reset(SimContext *ctx);
+void sim_context_destroy(SimContext *ctx);
+
+#endif // SIM_CONTEXT_H
@@ -0,0 +1,38 @@
+/*
+* Content Hash
+* This file implements the 64-bit FNV-1a hash used to key on-disk caches.
+* Hashes can be chained by passing the previous result as the starting value,
+* so an image and its configuration can be combined into one key.
+*
+* Functions:
+* - sim_hash_bytes: Hashes a block of memory.
+* - sim_hash_string: Hashes a NUL-terminated string (including the terminator).
+*/
+
+#include "sim_hash.h"
+
+#define SIM_HASH_PRIME 0x100000001b3ULL // FNV-1a 64-bit prime
+
+/*
+* Hashes len bytes starting at data, continuing from hash.
+*/
+uint64_t sim_hash_bytes(const void *data, size_t len, uint64_t hash) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= SIM_HASH_PRIME;
+    }
+    return hash;
+}
+
+/*
+* Hashes a string including its terminator, so "ab"+"c" and "a"+"bc" differ.
+*/
+uint64_t sim_hash_string(const char *str, uint64_t hash) {
+    const unsigned char *p = (const unsigned char *)str;
+    do {
+        hash ^= *p;
+        hash *= SIM_HASH_PRIME;
+    } while (*p++);
+    return hash;
+}
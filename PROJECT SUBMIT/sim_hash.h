@@ -0,0 +1,19 @@
+/*
+* Content Hash Header File
+* This header file declares the 64-bit FNV-1a hash used to key on-disk caches
+* by memory image contents and simulator configuration.
+*/
+
+#ifndef SIM_HASH_H
+#define SIM_HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SIM_HASH_SEED 0xcbf29ce484222325ULL // FNV-1a 64-bit offset basis
+
+// Function prototypes
+uint64_t sim_hash_bytes(const void *data, size_t len, uint64_t hash);
+uint64_t sim_hash_string(const char *str, uint64_t hash);
+
+#endif // SIM_HASH_H
@@ -0,0 +1,101 @@
+/*
+* Simulator Utilities
+* This file implements the helpers shared across the simulator, so the drivers and the
+* run instrumentation (batch, daemon, progress, live statistics, host counters) measure
+* time and parse option values the same way.
+*
+* Functions:
+* - sim_util_now_ns: Returns a monotonic timestamp in nanoseconds.
+* - sim_util_parse_count: Parses an unsigned option value.
+* - sim_util_driver_init: Sets the common driver options to their defaults.
+* - sim_util_driver_option: Parses one common driver option.
+* - sim_util_driver_usage: Prints the usage lines of the common driver options.
+*/
+
+#include "sim_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+* Returns a monotonic timestamp in nanoseconds.
+*/
+uint64_t sim_util_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+* Parses the unsigned value text of an option (decimal, or hex with 0x).
+* Returns 0 on success, -1 (with a message naming the option) if malformed or zero
+* where zero is not allowed.
+*/
+int sim_util_parse_count(const char *option, const char *text, uint64_t *value, int allow_zero) {
+    char *end;
+    *value = strtoull(text, &end, 0);
+    if (end == text || *end != '\0' || (!allow_zero && *value == 0)) {
+        fprintf(stderr, "Error: Invalid value '%s' for %s\n", text, option);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+* Sets the common driver options to their defaults: WF, no data cache, one thread per
+* online core, not checked.
+*/
+void sim_util_driver_init(DriverOptions *opts, uint64_t default_max_instructions) {
+    opts->mode = "WF";
+    opts->dcache_lines = 0;
+    opts->threads = 0;
+    opts->max_instructions = default_max_instructions;
+    opts->check = 0;
+}
+
+/*
+* Parses arg if it is one of the common driver options (--jobs only if allow_jobs).
+* Returns 1 if the option was consumed, 0 if it is not a common option, -1 (with a
+* message) if its value is invalid.
+*/
+int sim_util_driver_option(DriverOptions *opts, const char *arg, int allow_jobs) {
+    if (strncmp(arg, "--mode=", 7) == 0) {
+        opts->mode = arg + 7;
+        if (strcmp(opts->mode, "NF") != 0 && strcmp(opts->mode, "WF") != 0) {
+            fprintf(stderr, "Error: Invalid mode '%s' (expected NF or WF)\n", opts->mode);
+            return -1;
+        }
+    } else if (strncmp(arg, "--max-instructions=", 19) == 0) {
+        if (sim_util_parse_count("--max-instructions", arg + 19, &opts->max_instructions, 0) < 0) return -1;
+    } else if (strncmp(arg, "--dcache=", 9) == 0) {
+        opts->dcache_lines = atoi(arg + 9);
+        if (opts->dcache_lines <= 0) {
+            fprintf(stderr, "Error: Invalid cache size '%s'\n", arg + 9);
+            return -1;
+        }
+    } else if (allow_jobs && strncmp(arg, "--jobs=", 7) == 0) {
+        opts->threads = atoi(arg + 7);
+        if (opts->threads <= 0) {
+            fprintf(stderr, "Error: Invalid thread count '%s'\n", arg + 7);
+            return -1;
+        }
+    } else if (strcmp(arg, "--check") == 0) {
+        opts->check = 1;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+/*
+* Prints the usage lines of the common driver options (the driver describes --check).
+*/
+void sim_util_driver_usage(uint64_t default_max_instructions, int allow_jobs) {
+    fprintf(stderr, "  --mode=<NF|WF>            Pipeline timed (default WF)\n");
+    fprintf(stderr, "  --dcache=<lines>          Time with a direct-mapped data cache of that many lines\n");
+    if (allow_jobs) fprintf(stderr, "  --jobs=<n>                Worker threads (default: online cores)\n");
+    fprintf(stderr, "  --max-instructions=<n>    Functional run limit (default %llu)\n",
+            (unsigned long long)default_max_instructions);
+}
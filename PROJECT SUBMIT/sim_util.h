@@ -0,0 +1,32 @@
+/*
+* Simulator Utilities Header File
+* This header file declares small helpers shared across the simulator: the monotonic
+* clock used for wall times and rates, option value parsing, and the options common to
+* the trace-driven timing drivers (--segmented, --sample, --simpoint).
+*/
+
+#ifndef SIM_UTIL_H
+#define SIM_UTIL_H
+
+#include <stdint.h>
+
+/*
+* DriverOptions structure:
+* The options every trace-driven timing driver accepts.
+*/
+typedef struct {
+    const char *mode;          // Pipeline timed: "NF" or "WF"
+    int dcache_lines;          // Direct-mapped data cache lines (0 = no cache)
+    int threads;               // Worker threads (0 = online cores)
+    uint64_t max_instructions; // Functional run limit
+    int check;                 // 1 = also time the full run serially
+} DriverOptions;
+
+// Function prototypes
+uint64_t sim_util_now_ns(void);
+int sim_util_parse_count(const char *option, const char *text, uint64_t *value, int allow_zero);
+void sim_util_driver_init(DriverOptions *opts, uint64_t default_max_instructions);
+int sim_util_driver_option(DriverOptions *opts, const char *arg, int allow_jobs);
+void sim_util_driver_usage(uint64_t default_max_instructions, int allow_jobs);
+
+#endif // SIM_UTIL_H
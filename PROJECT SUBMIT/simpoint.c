@@ -0,0 +1,526 @@
+/*
+* SimPoint Phase Analysis
+* This file implements "--simpoint <image>". A functional run is divided into intervals of
+* --interval instructions, and each interval's basic block vector counts the instructions
+* executed in every basic block (a block starts at the first instruction and after every
+* control transfer). The normalized BBVs are randomly projected to --dims dimensions and
+* clustered with k-means for k = 1..--max-k; the smallest k whose BIC score is within 90%
+* of the best is used. The interval closest to each centroid becomes a simulation point,
+* weighted by its cluster's share of the instructions. Only the simulation points are
+* timed in detail (in parallel, each after a warmup), and the total cycles are
+* extrapolated from their CPIs.
+*
+* Supported Operations:
+* - BBV collection with optional SimPoint-format output (--bbv=<file>)
+* - Random projection and BIC-selected k-means with restarts (deterministic for a --seed)
+* - Detailed NF/WF timing of the simulation points and total cycle extrapolation
+* - Error against a full serial run (--check)
+*
+* Functions:
+* - simpoint_main: Parses options, runs the analysis and prints the simulation points.
+*/
+
+#include "simpoint.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "commit_trace.h"
+#include "instruction_decoder.h" // For opcodes
+#include "sim_context.h"
+#include "sim_util.h"            // For the common driver options and sim_util_parse_count
+#include "thread_pool.h"
+#include "timing_model.h"
+#include "trace_reader.h"
+
+#define SIMPOINT_INITIAL_INTERVALS 64 // Initial interval capacity (grows as needed)
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846 // Not defined by strict ISO C
+#endif
+
+// One pool task: time one simulation point
+typedef struct {
+    const PipelineConfig *cfg;
+    const SimPointInterval *intervals;
+    SimPoint *point;
+} SimPointTask;
+
+/*
+* Returns the next value of a xorshift64* generator.
+*/
+static uint64_t simpoint_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/*
+* Returns a uniform double in [-1, 1).
+*/
+static double simpoint_random_unit(uint64_t *state) {
+    return (double)(simpoint_random(state) >> 11) / (double)(1ULL << 52) - 1.0;
+}
+
+/*
+* Returns the squared distance between two projected vectors.
+*/
+static double simpoint_distance(const double *a, const double *b, int dims) {
+    double sum = 0.0;
+    for (int d = 0; d < dims; d++) {
+        double diff = a[d] - b[d];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+/*
+* Runs k-means on the projected intervals from one random initialization (k distinct
+* intervals). Writes the assignment to assign[] and the centroids to centroids[].
+* Returns the sum of squared distances to the assigned centroids.
+*/
+static double simpoint_kmeans_once(const SimPointInterval *intervals, size_t count, int dims, int k,
+                                   uint64_t *rng, int *assign, double *centroids) {
+    // Initial centroids: k distinct random intervals (partial Fisher-Yates over indices)
+    size_t *order = malloc(count * sizeof(size_t));
+    if (!order) return INFINITY;
+    for (size_t i = 0; i < count; i++) order[i] = i;
+    for (int c = 0; c < k; c++) {
+        size_t j = (size_t)c + (size_t)(simpoint_random(rng) % (count - (size_t)c));
+        size_t tmp = order[c];
+        order[c] = order[j];
+        order[j] = tmp;
+        memcpy(&centroids[c * dims], intervals[order[c]].projected, (size_t)dims * sizeof(double));
+    }
+    free(order);
+
+    double sse = 0.0;
+    for (int iter = 0; iter < SIMPOINT_KMEANS_ITERATIONS; iter++) {
+        int changed = 0;
+        sse = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            int best = 0;
+            double best_distance = INFINITY;
+            for (int c = 0; c < k; c++) {
+                double distance = simpoint_distance(intervals[i].projected, &centroids[c * dims], dims);
+                if (distance < best_distance) {
+                    best_distance = distance;
+                    best = c;
+                }
+            }
+            if (iter == 0 || assign[i] != best) changed = 1;
+            assign[i] = best;
+            sse += best_distance;
+        }
+        if (!changed) break;
+
+        // Move each centroid to the mean of its members (empty clusters keep their centroid)
+        for (int c = 0; c < k; c++) {
+            double sum[SIMPOINT_MAX_DIMS] = { 0 };
+            size_t members = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (assign[i] != c) continue;
+                members++;
+                for (int d = 0; d < dims; d++) sum[d] += intervals[i].projected[d];
+            }
+            if (members == 0) continue;
+            for (int d = 0; d < dims; d++) centroids[c * dims + d] = sum[d] / (double)members;
+        }
+    }
+    return sse;
+}
+
+/*
+* Returns the BIC score of a clustering (X-means formulation of Pelleg and Moore):
+* the log-likelihood under identical spherical Gaussians minus the parameter penalty.
+*/
+static double simpoint_bic(const int *assign, size_t count, int dims, int k, double sse) {
+    double r = (double)count;
+    double variance = count > (size_t)k ? sse / (r - k) : 0.0;
+    if (variance < 1e-12) variance = 1e-12;
+
+    double log_likelihood = 0.0;
+    for (int c = 0; c < k; c++) {
+        size_t members = 0;
+        for (size_t i = 0; i < count; i++) members += assign[i] == c;
+        if (members == 0) continue;
+        double rc = (double)members;
+        log_likelihood += rc * log(rc) - rc * log(r) - rc / 2.0 * log(2.0 * M_PI) -
+                          rc * dims / 2.0 * log(variance) - (rc - k) / 2.0;
+    }
+    double parameters = (k - 1) + (double)dims * k + 1;
+    return log_likelihood - parameters / 2.0 * log(r);
+}
+
+/*
+* Clusters the intervals for k = 1..max_k and stores the chosen clustering in
+* intervals[].cluster. Returns the chosen k, or -1 if memory cannot be allocated.
+*/
+static int simpoint_cluster(SimPointInterval *intervals, size_t count, int dims, int max_k, uint64_t seed) {
+    if ((size_t)max_k > count) max_k = (int)count;
+
+    int *assign = malloc(count * sizeof(int));
+    int *best_assign = malloc((size_t)max_k * count * sizeof(int)); // Best clustering per k
+    double *centroids = malloc((size_t)max_k * dims * sizeof(double));
+    double *bic = malloc((size_t)max_k * sizeof(double));
+    if (!assign || !best_assign || !centroids || !bic) {
+        free(assign);
+        free(best_assign);
+        free(centroids);
+        free(bic);
+        return -1;
+    }
+
+    uint64_t rng = seed ? seed : 1;
+    double best_bic = -INFINITY, worst_bic = INFINITY;
+    for (int k = 1; k <= max_k; k++) {
+        double best_sse = INFINITY;
+        for (int restart = 0; restart < SIMPOINT_KMEANS_RESTARTS; restart++) {
+            double sse = simpoint_kmeans_once(intervals, count, dims, k, &rng, assign, centroids);
+            if (sse < best_sse) {
+                best_sse = sse;
+                memcpy(&best_assign[(size_t)(k - 1) * count], assign, count * sizeof(int));
+            }
+        }
+        bic[k - 1] = simpoint_bic(&best_assign[(size_t)(k - 1) * count], count, dims, k, best_sse);
+        if (bic[k - 1] > best_bic) best_bic = bic[k - 1];
+        if (bic[k - 1] < worst_bic) worst_bic = bic[k - 1];
+    }
+
+    int chosen = max_k;
+    for (int k = 1; k <= max_k; k++) {
+        if (bic[k - 1] >= worst_bic + SIMPOINT_BIC_THRESHOLD * (best_bic - worst_bic)) {
+            chosen = k;
+            break;
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        intervals[i].cluster = best_assign[(size_t)(chosen - 1) * count + i];
+    }
+
+    free(assign);
+    free(best_assign);
+    free(centroids);
+    free(bic);
+    return chosen;
+}
+
+/*
+* Pool task: warms up on the end of the previous interval and times the simulation point.
+*/
+static void simpoint_run_point(void *arg, int worker) {
+    (void)worker;
+    SimPointTask *task = arg;
+    SimPoint *point = task->point;
+    const SimPointInterval *target = &task->intervals[point->interval];
+
+    SimContext *ctx = sim_context_create();
+    TimingModel tm;
+    if (!ctx) return; // point->ok stays 0
+    if (timing_model_init(&tm, task->cfg) < 0) {
+        sim_context_destroy(ctx);
+        return;
+    }
+
+    CommitRecord rec;
+    if (point->warmup > 0) {
+        // Start at the previous interval, fast-forward to the warmup and replay it
+        const SimPointInterval *previous = &task->intervals[point->interval - 1];
+        ctx->state = previous->state;
+        for (uint64_t i = 0; i < previous->length - point->warmup && commit_trace_step(ctx, &rec, NULL); i++) {
+            // Functional fast-forward
+        }
+        for (uint64_t i = 0; i < point->warmup && commit_trace_step(ctx, &rec, NULL); i++) {
+            timing_model_commit(&tm, &rec);
+        }
+    } else {
+        ctx->state = target->state;
+    }
+
+    uint64_t base_cycles = tm.cycles;
+    for (uint64_t i = 0; i < target->length && commit_trace_step(ctx, &rec, NULL); i++) {
+        timing_model_commit(&tm, &rec);
+    }
+    point->cycles = tm.cycles - base_cycles;
+    point->cpi = (double)point->cycles / (double)target->length;
+    point->ok = 1;
+
+    timing_model_free(&tm);
+    sim_context_destroy(ctx);
+}
+
+/*
+* Writes one interval's BBV in SimPoint's frequency vector format ("T:<block>:<count> ...",
+* block ids are leader word index + 1).
+*/
+static void simpoint_write_bbv(FILE *out, const uint32_t *bbv) {
+    fputc('T', out);
+    for (int i = 0; i < MAX_MEMORY_LINES; i++) {
+        if (bbv[i]) fprintf(out, ":%d:%u ", i + 1, bbv[i]);
+    }
+    fputc('\n', out);
+}
+
+/*
+* Prints the SimPoint usage.
+*/
+static void print_simpoint_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --simpoint <memory_image_file> [options]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --interval=<n>            Instructions per BBV interval (default %llu)\n",
+            (unsigned long long)SIMPOINT_DEFAULT_INTERVAL);
+    fprintf(stderr, "  --max-k=<n>               Largest number of clusters tried (default %d)\n", SIMPOINT_DEFAULT_MAX_K);
+    fprintf(stderr, "  --dims=<n>                Random projection dimensions (default %d, max %d)\n",
+            SIMPOINT_DEFAULT_DIMS, SIMPOINT_MAX_DIMS);
+    fprintf(stderr, "  --seed=<n>                Projection and k-means seed (default 1)\n");
+    fprintf(stderr, "  --warmup=<n>              Detailed warmup before each point (default %llu)\n",
+            (unsigned long long)SIMPOINT_DEFAULT_WARMUP);
+    fprintf(stderr, "  --bbv=<file>              Also write the BBVs in SimPoint format\n");
+    fprintf(stderr, "  --check                   Also time the full run and report the extrapolation error\n");
+    sim_util_driver_usage(SIMPOINT_DEFAULT_MAX_INSTRUCTIONS, 1);
+}
+
+/*
+* Entry point for the SimPoint driver.
+* argv[0] is "--simpoint" and argv[1] the memory image.
+* Returns 0 on success, 2 on usage, I/O or allocation errors.
+*/
+int simpoint_main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_simpoint_usage("simulator");
+        return 2;
+    }
+
+    const char *image_file = argv[1];
+    const char *bbv_file = NULL;
+    uint64_t interval_length = SIMPOINT_DEFAULT_INTERVAL;
+    uint64_t warmup = SIMPOINT_DEFAULT_WARMUP;
+    uint64_t max_k = SIMPOINT_DEFAULT_MAX_K, dims = SIMPOINT_DEFAULT_DIMS, seed = 1;
+    DriverOptions opts;
+    sim_util_driver_init(&opts, SIMPOINT_DEFAULT_MAX_INSTRUCTIONS);
+
+    for (int i = 2; i < argc; i++) {
+        int common = sim_util_driver_option(&opts, argv[i], 1);
+        if (common < 0) return 2;
+        if (common) continue;
+        if (strncmp(argv[i], "--interval=", 11) == 0) {
+            if (sim_util_parse_count("--interval", argv[i] + 11, &interval_length, 0) < 0) return 2;
+        } else if (strncmp(argv[i], "--max-k=", 8) == 0) {
+            if (sim_util_parse_count("--max-k", argv[i] + 8, &max_k, 0) < 0) return 2;
+        } else if (strncmp(argv[i], "--dims=", 7) == 0) {
+            if (sim_util_parse_count("--dims", argv[i] + 7, &dims, 0) < 0) return 2;
+            if (dims > SIMPOINT_MAX_DIMS) {
+                fprintf(stderr, "Error: At most %d projection dimensions\n", SIMPOINT_MAX_DIMS);
+                return 2;
+            }
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            if (sim_util_parse_count("--seed", argv[i] + 7, &seed, 1) < 0) return 2;
+        } else if (strncmp(argv[i], "--warmup=", 9) == 0) {
+            if (sim_util_parse_count("--warmup", argv[i] + 9, &warmup, 1) < 0) return 2;
+        } else if (strncmp(argv[i], "--bbv=", 6) == 0) {
+            bbv_file = argv[i] + 6;
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            print_simpoint_usage("simulator");
+            return 2;
+        }
+    }
+    if (warmup > interval_length) warmup = interval_length;
+    const char *mode = opts.mode;
+    uint64_t max_instructions = opts.max_instructions;
+    int dcache_lines = opts.dcache_lines;
+    int threads = opts.threads;
+    int check = opts.check;
+
+    PipelineConfig cfg;
+    pipeline_config_preset(&cfg, strcmp(mode, "WF") == 0);
+    cfg.dcache_lines = dcache_lines;
+
+    SimContext *ctx = sim_context_create();
+    if (!ctx) {
+        perror("Error allocating simulator context");
+        return 2;
+    }
+    if (read_memory_image(image_file, ctx->state.memory) < 0) {
+        fprintf(stderr, "Error: Failed to load memory image from file '%s'\n", image_file);
+        sim_context_destroy(ctx);
+        return 2;
+    }
+    FILE *bbv_out = NULL;
+    if (bbv_file && !(bbv_out = fopen(bbv_file, "w"))) {
+        perror("Error opening BBV file");
+        sim_context_destroy(ctx);
+        return 2;
+    }
+
+    // Random projection matrix: one row of uniform [-1, 1) weights per basic block leader
+    static double projection[MAX_MEMORY_LINES][SIMPOINT_MAX_DIMS];
+    uint64_t rng = seed ^ 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < MAX_MEMORY_LINES; i++) {
+        for (int d = 0; d < (int)dims; d++) projection[i][d] = simpoint_random_unit(&rng);
+    }
+
+    // Functional pass: one BBV per interval, projected when the interval closes
+    SimPointInterval *intervals = NULL;
+    size_t count = 0, capacity = 0;
+    static uint32_t bbv[MAX_MEMORY_LINES];
+    TimingModel serial;
+    int failed = check && timing_model_init(&serial, &cfg) < 0;
+    uint64_t total = 0, serial_base = 0;
+    uint32_t leader = 0;      // Word index of the current basic block's first instruction
+    int new_block = 1;
+    CommitRecord rec;
+
+    while (!failed) {
+        int more = total < max_instructions && !ctx->halted;
+        if (more && total % interval_length == 0) {
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : SIMPOINT_INITIAL_INTERVALS;
+                SimPointInterval *grown = realloc(intervals, capacity * sizeof(SimPointInterval));
+                if (!grown) {
+                    failed = 1;
+                    break;
+                }
+                intervals = grown;
+            }
+            memset(&intervals[count], 0, sizeof(SimPointInterval));
+            intervals[count].start = total;
+            intervals[count].state = ctx->state;
+            count++;
+        }
+        if (more && !commit_trace_step(ctx, &rec, NULL)) more = 0;
+
+        if (more) {
+            if (new_block) leader = rec.pc / WORD_SIZE;
+            new_block = rec.opcode == BZ || rec.opcode == BEQ || rec.opcode == JR;
+            bbv[leader]++;
+            if (check) timing_model_commit(&serial, &rec);
+            total++;
+            intervals[count - 1].length++;
+        }
+
+        // Close the current interval: normalize, project and (optionally) write its BBV
+        if (count > 0 && intervals[count - 1].length > 0 && (!more || total % interval_length == 0)) {
+            SimPointInterval *iv = &intervals[count - 1];
+            for (int i = 0; i < MAX_MEMORY_LINES; i++) {
+                if (!bbv[i]) continue;
+                double share = (double)bbv[i] / (double)iv->length;
+                for (int d = 0; d < (int)dims; d++) iv->projected[d] += share * projection[i][d];
+            }
+            if (bbv_out) simpoint_write_bbv(bbv_out, bbv);
+            memset(bbv, 0, sizeof(bbv));
+            if (check) {
+                iv->serial_cycles = serial.cycles - serial_base;
+                serial_base = serial.cycles;
+            }
+        }
+        if (!more) break;
+    }
+    int complete = ctx->halted;
+    sim_context_destroy(ctx);
+    if (bbv_out && fclose(bbv_out) != 0) {
+        perror("Error writing BBV file");
+        failed = 1;
+    }
+
+    int k = (!failed && count > 0) ? simpoint_cluster(intervals, count, (int)dims, (int)max_k, seed) : -1;
+    SimPoint *points = k > 0 ? calloc((size_t)k, sizeof(SimPoint)) : NULL;
+    SimPointTask *tasks = k > 0 ? calloc((size_t)k, sizeof(SimPointTask)) : NULL;
+    if (threads <= 0) threads = thread_pool_default_size();
+    ThreadPool *pool = (points && tasks) ? thread_pool_create(threads) : NULL;
+    if (!pool) {
+        fprintf(stderr, count == 0 ? "Error: The program executed no instructions\n"
+                                   : "Error: Cannot allocate the SimPoint analysis\n");
+        free(points);
+        free(tasks);
+        free(intervals);
+        if (check) timing_model_free(&serial);
+        return 2;
+    }
+    if (!complete) {
+        fprintf(stderr, "Warning: '%s' did not halt within %" PRIu64 " instructions; the estimate covers that prefix\n",
+                image_file, total);
+    }
+
+    // Simulation points: per cluster, the member interval closest to the centroid
+    for (int c = 0; c < k; c++) {
+        double centroid[SIMPOINT_MAX_DIMS] = { 0 };
+        size_t members = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (intervals[i].cluster != c) continue;
+            members++;
+            points[c].instructions += intervals[i].length;
+            for (int d = 0; d < (int)dims; d++) centroid[d] += intervals[i].projected[d];
+        }
+        points[c].cluster = c;
+        if (members == 0) continue; // Empty cluster: no point, no weight
+        for (int d = 0; d < (int)dims; d++) centroid[d] /= (double)members;
+
+        double best_distance = INFINITY;
+        for (size_t i = 0; i < count; i++) {
+            if (intervals[i].cluster != c) continue;
+            double distance = simpoint_distance(intervals[i].projected, centroid, (int)dims);
+            // Prefer full-length intervals: a short final interval is a poor representative
+            if (intervals[i].length < interval_length && count > 1) distance += 1e9;
+            if (distance < best_distance) {
+                best_distance = distance;
+                points[c].interval = i;
+            }
+        }
+        points[c].weight = (double)points[c].instructions / (double)total;
+        points[c].warmup = points[c].interval > 0 ? warmup : 0;
+        tasks[c].cfg = &cfg;
+        tasks[c].intervals = intervals;
+        tasks[c].point = &points[c];
+        if (thread_pool_submit(pool, simpoint_run_point, &tasks[c]) < 0) {
+            simpoint_run_point(&tasks[c], -1);
+        }
+    }
+    thread_pool_wait(pool);
+    thread_pool_destroy(pool);
+
+    // Extrapolate: each cluster's instructions at its simulation point's CPI
+    int result = 0;
+    double cycles = 0.0;
+    uint64_t detailed = 0;
+    printf("SimPoint %s timing: %" PRIu64 " instructions in %zu intervals of %" PRIu64 ", %d clusters (max %" PRIu64
+           ", %" PRIu64 " dims)\n", mode, total, count, interval_length, k, max_k, dims);
+    printf("%8s %9s %12s %10s %8s %12s %8s", "cluster", "interval", "start", "members", "weight", "cycles", "CPI");
+    if (check) printf(" %10s", "serialCPI");
+    printf("\n");
+    for (int c = 0; c < k; c++) {
+        const SimPoint *p = &points[c];
+        if (p->instructions == 0) continue;
+        if (!p->ok) {
+            fprintf(stderr, "Error: Simulation point of cluster %d could not be simulated\n", c);
+            result = 2;
+            continue;
+        }
+        const SimPointInterval *iv = &intervals[p->interval];
+        size_t members = 0;
+        for (size_t i = 0; i < count; i++) members += intervals[i].cluster == c;
+        cycles += p->cpi * (double)p->instructions;
+        detailed += iv->length + p->warmup;
+        printf("%8d %9zu %12" PRIu64 " %10zu %8.4f %12" PRIu64 " %8.4f", c, p->interval, iv->start, members,
+               p->weight, p->cycles, p->cpi);
+        if (check) printf(" %10.4f", (double)iv->serial_cycles / (double)iv->length);
+        printf("\n");
+    }
+    printf("Estimated clock cycles: %.0f (CPI %.4f), %" PRIu64 " instructions timed in detail (%.2f%% of the run)\n",
+           cycles, total ? cycles / (double)total : 0.0, detailed, total ? 100.0 * (double)detailed / (double)total : 0.0);
+    if (check) {
+        double error = serial.cycles ? (cycles - (double)serial.cycles) / (double)serial.cycles : 0.0;
+        printf("Full run: %" PRIu64 " clock cycles (CPI %.4f); extrapolation error %+.3f%%\n", serial.cycles,
+               total ? (double)serial.cycles / (double)total : 0.0, 100.0 * error);
+        timing_model_free(&serial);
+    }
+
+    free(points);
+    free(tasks);
+    free(intervals);
+    return result;
+}
@@ -0,0 +1,56 @@
+/*
+* SimPoint Header File
+* This header file declares the SimPoint-style phase analysis driver: basic block vectors
+* (BBVs) are collected per fixed-size interval of a functional run, reduced by random
+* projection, clustered with k-means, and one representative interval per cluster is timed
+* in detail to extrapolate the cycles of the whole run.
+*/
+
+#ifndef SIMPOINT_H
+#define SIMPOINT_H
+
+#include <stdint.h>
+#include "functional_sim.h" // For MachineState
+
+#define SIMPOINT_DEFAULT_INTERVAL 100000ULL          // Instructions per BBV interval
+#define SIMPOINT_DEFAULT_MAX_K 10                    // Largest cluster count tried
+#define SIMPOINT_DEFAULT_DIMS 15                     // Dimensions after random projection
+#define SIMPOINT_DEFAULT_WARMUP 2000ULL              // Detailed warmup before a simulation point
+#define SIMPOINT_DEFAULT_MAX_INSTRUCTIONS 100000000ULL // Functional run limit
+#define SIMPOINT_MAX_DIMS 64
+#define SIMPOINT_KMEANS_RESTARTS 5                   // Random initializations per k
+#define SIMPOINT_KMEANS_ITERATIONS 100
+#define SIMPOINT_BIC_THRESHOLD 0.9                   // Pick the smallest k within 90% of the best BIC
+
+/*
+* SimPointInterval structure:
+* One interval of the run: where it starts, its projected BBV and its cluster.
+*/
+typedef struct {
+    uint64_t start;                  // Index of the interval's first instruction
+    uint64_t length;                 // Instructions (only the last interval may be short)
+    MachineState state;              // Architectural state at start
+    double projected[SIMPOINT_MAX_DIMS];
+    int cluster;
+    uint64_t serial_cycles;          // Cycles of the interval in a full serial run (with --check)
+} SimPointInterval;
+
+/*
+* SimPoint structure:
+* The representative interval of one cluster, its weight and its detailed timing.
+*/
+typedef struct {
+    int cluster;
+    size_t interval;       // Index into the interval array
+    uint64_t instructions; // Instructions in all intervals of the cluster
+    double weight;         // Share of the run's instructions
+    uint64_t warmup;
+    uint64_t cycles;       // Detailed cycles of the representative interval
+    double cpi;
+    int ok;
+} SimPoint;
+
+// Entry point for "<prog> --simpoint <image> [options]"; returns 0 on success, 2 on errors
+int simpoint_main(int argc, char *argv[]);
+
+#endif // SIMPOINT_H
@@ -0,0 +1,147 @@
+/*
+* Split Simulation
+* This file runs one simulation on several cores. The calling thread executes the program
+* functionally (commit_trace_step) and pushes every committed instruction into one SPSC
+* ring per timing model; each timing model runs timing_model_commit on its own thread.
+* Functional execution therefore runs ahead of, and overlaps with, the timing work, and
+* any number of pipeline configurations can be timed from the same functional run.
+*
+* Supported Operations:
+* - 1..SPLIT_MAX_CONSUMERS timing models per functional run
+* - Per-model cycle limits (the NF/WF infinite loop guard); the functional thread stops
+*   once every model has stopped
+* - The context's watchdog (instruction budget, livelock detection) on the functional
+*   thread, which stops the run like it stops the NF/WF step functions
+* - Loop-iteration memoization in each consumer (timing_memo.c)
+*
+* Functions:
+* - run_split_simulation: Runs the functional producer and the timing consumers.
+*/
+
+#include "split_sim.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "commit_trace.h" // For commit_trace_step
+#include "sim_context.h"
+#include "spsc_ring.h"
+#include "timing_memo.h"
+#include "watchdog.h"   // For watchdog_commit
+
+// Per-thread state of a timing consumer
+typedef struct {
+    SplitConsumer *consumer;
+    SpscRing ring;
+} SplitChannel;
+
+/*
+* Timing consumer thread: replays records until the stream ends or the cycle limit is hit.
+*/
+static void *split_consumer_thread(void *arg) {
+    SplitChannel *channel = (SplitChannel *)arg;
+    SplitConsumer *consumer = channel->consumer;
+    CommitRecord batch[SPLIT_POP_BATCH];
+    size_t count;
+
+    // Without memoization (out of memory) every record is timed individually
+    TimingMemo memo;
+    int memoize = timing_memo_init(&memo, &consumer->model) == 0;
+    memo.cycle_limit = consumer->cycle_limit;
+
+    while ((count = spsc_ring_pop(&channel->ring, batch, SPLIT_POP_BATCH)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            if (memoize) {
+                timing_memo_commit(&memo, &batch[i]);
+            } else {
+                timing_model_commit(&consumer->model, &batch[i]);
+            }
+            if (consumer->cycle_limit && consumer->model.cycles > consumer->cycle_limit) break;
+        }
+        if (consumer->cycle_limit && consumer->model.cycles > consumer->cycle_limit) break;
+    }
+    if (memoize) {
+        timing_memo_flush(&memo);
+        consumer->memo_skipped = memo.skipped;
+        timing_memo_free(&memo);
+    }
+    if (consumer->cycle_limit && consumer->model.cycles > consumer->cycle_limit) {
+        consumer->limit_hit = 1;
+        spsc_ring_cancel(&channel->ring);
+    }
+    return NULL;
+}
+
+/*
+* Runs the program loaded in ctx functionally on the calling thread and times it with
+* count consumers, each on its own thread behind a ring of ring_capacity records
+* (a power of two). ctx holds the final architectural state afterwards; the consumers
+* hold their timing results.
+* Returns 0 on success, -1 if the rings or threads cannot be set up.
+*/
+int run_split_simulation(SimContext *ctx, SplitConsumer *consumers, int count, size_t ring_capacity) {
+    if (count < 1 || count > SPLIT_MAX_CONSUMERS) return -1;
+
+    SplitChannel channels[SPLIT_MAX_CONSUMERS];
+    pthread_t threads[SPLIT_MAX_CONSUMERS];
+    int started = 0;
+    int result = 0;
+
+    for (int i = 0; i < count; i++) {
+        consumers[i].limit_hit = 0;
+        consumers[i].memo_skipped = 0;
+        channels[i].consumer = &consumers[i];
+        if (timing_model_init(&consumers[i].model, &consumers[i].cfg) < 0) {
+            fprintf(stderr, "Error: Invalid pipeline configuration for split consumer %d\n", i);
+            result = -1;
+            break;
+        }
+        if (spsc_ring_init(&channels[i].ring, ring_capacity) < 0) {
+            perror("Error allocating split simulation ring");
+            timing_model_free(&consumers[i].model);
+            result = -1;
+            break;
+        }
+        if (pthread_create(&threads[i], NULL, split_consumer_thread, &channels[i]) != 0) {
+            perror("Error starting split simulation thread");
+            spsc_ring_free(&channels[i].ring);
+            timing_model_free(&consumers[i].model);
+            result = -1;
+            break;
+        }
+        started++;
+    }
+
+    // Functional producer: runs until HALT, the watchdog stops the run, or no consumer wants more records
+    if (result == 0) {
+        int active = count;
+        int accepting[SPLIT_MAX_CONSUMERS];
+        for (int i = 0; i < count; i++) accepting[i] = 1;
+
+        CommitRecord rec;
+        DecodedInstruction instr;
+        while (active > 0 && commit_trace_step(ctx, &rec, &instr)) {
+            watchdog_commit(ctx, &instr, rec.pc);
+            for (int i = 0; i < count; i++) {
+                if (accepting[i] && spsc_ring_push(&channels[i].ring, &rec) < 0) {
+                    accepting[i] = 0;
+                    active--;
+                }
+            }
+            if (ctx->watchdog.stop != WATCHDOG_RUNNING) {
+                ctx->halted = 1; // The committed instruction is still timed
+                break;
+            }
+        }
+    }
+
+    for (int i = 0; i < started; i++) {
+        spsc_ring_close(&channels[i].ring);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        spsc_ring_free(&channels[i].ring);
+        if (result < 0) timing_model_free(&consumers[i].model);
+    }
+    return result;
+}
@@ -0,0 +1,36 @@
+/*
+* Split Simulation Header File
+* This header file declares the producer/consumer execution mode: the functional simulator
+* runs ahead on the calling thread and streams commit records through one lock-free ring
+* per timing model, each of which runs on its own thread.
+*/
+
+#ifndef SPLIT_SIM_H
+#define SPLIT_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "timing_model.h" // For PipelineConfig and TimingModel
+
+#define SPLIT_MAX_CONSUMERS 8   // Timing models fed by one functional run
+#define SPLIT_POP_BATCH 256     // Records a consumer takes from its ring at once
+
+typedef struct SimContext SimContext;
+
+/*
+* SplitConsumer structure:
+* One timing model fed by the functional thread. cfg and cycle_limit are inputs;
+* model and limit_hit hold the result after run_split_simulation().
+*/
+typedef struct {
+    PipelineConfig cfg;
+    uint64_t cycle_limit; // Stop timing (and stop feeding this model) past this cycle, 0 = none
+    TimingModel model;
+    int limit_hit;        // 1 if the model stopped at cycle_limit
+    uint64_t memo_skipped; // Instructions timed through memoized loop iterations
+} SplitConsumer;
+
+// Function prototypes
+int run_split_simulation(SimContext *ctx, SplitConsumer *consumers, int count, size_t ring_capacity);
+
+#endif // SPLIT_SIM_H
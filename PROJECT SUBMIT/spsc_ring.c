@@ -0,0 +1,113 @@
+/*
+* SPSC Ring
+* This file implements a bounded lock-free ring buffer with exactly one producer thread
+* and one consumer thread. The producer publishes records with a release store of tail and
+* the consumer frees slots with a release store of head; each side reads the other's index
+* with an acquire load only when its cached copy says the ring is full (or empty), so in the
+* steady state a push or pop touches no cache line written by the other thread.
+*
+* Supported Operations:
+* - Blocking push (yields while full) that gives up once the consumer cancels
+* - Batched pop of up to N records (yields while empty) that drains the ring before
+*   reporting end of stream
+*
+* Functions:
+* - spsc_ring_init: Allocates a ring.
+* - spsc_ring_push: Appends one record (producer side).
+* - spsc_ring_pop: Removes up to max records (consumer side).
+* - spsc_ring_close: Marks the end of the stream (producer side).
+* - spsc_ring_cancel: Asks the producer to stop (consumer side).
+* - spsc_ring_free: Releases a ring.
+*/
+
+#include "spsc_ring.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+* Allocates a ring of the given capacity (a power of two, at least 2).
+* Returns 0 on success, -1 if the capacity is invalid or memory cannot be allocated.
+*/
+int spsc_ring_init(SpscRing *ring, size_t capacity) {
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0) return -1;
+
+    memset(ring, 0, sizeof(SpscRing));
+    ring->slots = malloc(capacity * sizeof(CommitRecord));
+    if (!ring->slots) return -1;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->closed, 0);
+    atomic_init(&ring->cancelled, 0);
+    return 0;
+}
+
+/*
+* Appends one record, waiting while the ring is full.
+* Returns 0 on success, -1 if the consumer has cancelled the stream (the record is dropped).
+*/
+int spsc_ring_push(SpscRing *ring, const CommitRecord *rec) {
+    if (atomic_load_explicit(&ring->cancelled, memory_order_relaxed)) return -1;
+
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    while (tail - ring->cached_head > ring->mask) {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail - ring->cached_head <= ring->mask) break;
+        if (atomic_load_explicit(&ring->cancelled, memory_order_relaxed)) return -1;
+        sched_yield();
+    }
+
+    ring->slots[tail & ring->mask] = *rec;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+/*
+* Removes up to max records into out, waiting while the ring is empty and still open.
+* Returns the number of records removed, 0 once the producer has closed the stream
+* and every record has been consumed.
+*/
+size_t spsc_ring_pop(SpscRing *ring, CommitRecord *out, size_t max) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    while (ring->cached_tail == head) {
+        // Read closed before tail: if closed is seen, the tail load sees the final push
+        int closed = atomic_load_explicit(&ring->closed, memory_order_acquire);
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (ring->cached_tail != head) break;
+        if (closed) return 0;
+        sched_yield();
+    }
+
+    size_t count = ring->cached_tail - head;
+    if (count > max) count = max;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = ring->slots[(head + i) & ring->mask];
+    }
+    atomic_store_explicit(&ring->head, head + count, memory_order_release);
+    return count;
+}
+
+/*
+* Marks the end of the stream; called by the producer after its last push.
+*/
+void spsc_ring_close(SpscRing *ring) {
+    atomic_store_explicit(&ring->closed, 1, memory_order_release);
+}
+
+/*
+* Tells the producer that the consumer will not read any more records.
+*/
+void spsc_ring_cancel(SpscRing *ring) {
+    atomic_store_explicit(&ring->cancelled, 1, memory_order_relaxed);
+}
+
+/*
+* Releases the ring's slots (both threads must have finished with it).
+*/
+void spsc_ring_free(SpscRing *ring) {
+    free(ring->slots);
+    ring->slots = NULL;
+}
@@ -0,0 +1,43 @@
+/*
+* SPSC Ring Header File
+* This header file defines a lock-free single-producer/single-consumer ring buffer of
+* commit records, used to stream functional execution from one thread into a timing
+* model on another. Head and tail live on separate cache lines, and each side keeps a
+* cached copy of the other side's index so the shared lines are only read when needed.
+*/
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "commit_trace.h" // For CommitRecord
+
+#define SPSC_RING_DEFAULT_CAPACITY 4096 // Records (must be a power of two)
+#define SPSC_CACHE_LINE 64
+
+/*
+* SpscRing structure:
+* tail is only written by the producer, head only by the consumer. Indices grow without
+* wrapping; slot = index & mask.
+*/
+typedef struct {
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t tail; // Next slot to write (producer)
+    size_t cached_head;                           // Producer's last view of head
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t head; // Next slot to read (consumer)
+    size_t cached_tail;                           // Consumer's last view of tail
+    _Alignas(SPSC_CACHE_LINE) atomic_int closed;  // Set by the producer after its last push
+    atomic_int cancelled;                         // Set by the consumer to stop the producer early
+    size_t mask;
+    CommitRecord *slots;
+} SpscRing;
+
+// Function prototypes
+int spsc_ring_init(SpscRing *ring, size_t capacity);
+int spsc_ring_push(SpscRing *ring, const CommitRecord *rec);
+size_t spsc_ring_pop(SpscRing *ring, CommitRecord *out, size_t max);
+void spsc_ring_close(SpscRing *ring);
+void spsc_ring_cancel(SpscRing *ring);
+void spsc_ring_free(SpscRing *ring);
+
+#endif // SPSC_RING_H
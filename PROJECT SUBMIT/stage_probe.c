@@ -0,0 +1,138 @@
+/*
+* Stage Probes
+* This file implements the compile-in stage timing probes (-DSTAGE_PROBES). Every probe
+* adds one interval to a per-model, per-stage log-linear histogram, from which the report
+* derives the percentiles. The tables are thread-local, so concurrent runs (batch, daemon,
+* --split) do not race; the report at exit covers the thread that runs main.
+*
+* Supported Operations:
+* - Per-stage calls, total, share of the probed time, mean, p50/p90/p99 and max
+* - Time stamp counter ticks converted to nanoseconds by calibrating against
+*   clock_gettime over the run (clock_gettime alone where there is no TSC)
+* - The cost of one probe, measured at exit, so short stages can be read against it
+*
+* Functions:
+* - stage_probe_add: Records one interval of a stage.
+* - stage_probe_report: Prints the table to stderr.
+*/
+
+#ifdef STAGE_PROBES
+
+#include "stage_probe.h"
+
+#include <stdio.h>
+
+#include "sim_util.h" // For sim_util_now_ns
+
+static const char *probe_model_names[PROBE_NUM_MODELS] = { "NF", "WF" };
+static const char *probe_stage_names[PROBE_NUM_STAGES] = {
+    "Prologue", "WB commit", "MEM access", "EX", "ID hazard detection", "Advance", "IF fetch/decode",
+    "CPI accounting"
+};
+
+/*
+* ProbeStats structure:
+* Intervals of one stage, in ticks.
+*/
+typedef struct {
+    uint64_t calls;
+    uint64_t total;
+    uint64_t max;
+    uint64_t hist[PROBE_BUCKETS];
+} ProbeStats;
+
+static _Thread_local struct {
+    int started;
+    uint64_t start_ticks, start_ns; // Calibration point at the first interval
+    ProbeStats stats[PROBE_NUM_MODELS][PROBE_NUM_STAGES];
+} probes;
+
+/*
+* Maps an interval to its histogram bucket: exact below 16, then 8 buckets per power of two
+* (at most 12.5% wide).
+*/
+static int probe_bucket(uint64_t ticks) {
+    if (ticks < 16) return (int)ticks;
+    int e = 63 - __builtin_clzll(ticks);
+    return 16 + (e - 4) * 8 + (int)((ticks >> (e - 3)) & 7);
+}
+
+/*
+* Returns the lower bound of a bucket.
+*/
+static uint64_t probe_bucket_value(int bucket) {
+    if (bucket < 16) return (uint64_t)bucket;
+    int e = (bucket - 16) / 8 + 4;
+    return (uint64_t)(8 + (bucket - 16) % 8) << (e - 3);
+}
+
+void stage_probe_add(int model, int stage, uint64_t ticks) {
+    if (!probes.started) {
+        probes.started = 1;
+        probes.start_ticks = stage_probe_now();
+        probes.start_ns = sim_util_now_ns();
+    }
+    ProbeStats *s = &probes.stats[model][stage];
+    s->calls++;
+    s->total += ticks;
+    if (ticks > s->max) s->max = ticks;
+    s->hist[probe_bucket(ticks)]++;
+}
+
+/*
+* Returns the interval below which the given fraction of the calls fall.
+*/
+static uint64_t probe_percentile(const ProbeStats *s, double fraction) {
+    uint64_t rank = (uint64_t)(fraction * (double)s->calls);
+    uint64_t seen = 0;
+    for (int b = 0; b < PROBE_BUCKETS; b++) {
+        seen += s->hist[b];
+        if (seen > rank) return probe_bucket_value(b);
+    }
+    return s->max;
+}
+
+void stage_probe_report(void) {
+    if (!probes.started) return;
+
+    // Nanoseconds per tick over the run (1 when the probes read clock_gettime)
+    double ns_per_tick = 1.0;
+#if defined(__x86_64__) || defined(__i386__)
+    uint64_t ticks = stage_probe_now() - probes.start_ticks;
+    uint64_t ns = sim_util_now_ns() - probes.start_ns;
+    if (ticks > 0 && ns > 0) ns_per_tick = (double)ns / (double)ticks;
+#endif
+
+    // Cost of one probe: back-to-back intervals into a scratch table
+    ProbeStats saved = probes.stats[0][PROBE_PROLOGUE];
+    enum { CALIBRATION_PROBES = 10000 };
+    uint64_t t = stage_probe_now();
+    uint64_t begin = t;
+    for (int i = 0; i < CALIBRATION_PROBES; i++) t = stage_probe_record(0, PROBE_PROLOGUE, t);
+    double probe_ns = (double)(t - begin) * ns_per_tick / CALIBRATION_PROBES;
+    probes.stats[0][PROBE_PROLOGUE] = saved;
+
+    fflush(stdout); // The table follows the simulator output
+    fprintf(stderr, "Stage probes (time inside simulate_one_cycle_*_internal, this thread):\n");
+    fprintf(stderr, "  %-5s %-20s %12s %10s %6s %8s %8s %8s %8s %10s\n", "Model", "Stage", "Calls", "Total ms",
+            "Share", "Mean ns", "p50 ns", "p90 ns", "p99 ns", "Max ns");
+    for (int m = 0; m < PROBE_NUM_MODELS; m++) {
+        uint64_t model_total = 0;
+        for (int st = 0; st < PROBE_NUM_STAGES; st++) model_total += probes.stats[m][st].total;
+        if (model_total == 0) continue;
+        for (int st = 0; st < PROBE_NUM_STAGES; st++) {
+            const ProbeStats *s = &probes.stats[m][st];
+            if (s->calls == 0) continue;
+            fprintf(stderr, "  %-5s %-20s %12llu %10.3f %5.1f%% %8.1f %8.0f %8.0f %8.0f %10.0f\n",
+                    probe_model_names[m], probe_stage_names[st], (unsigned long long)s->calls,
+                    (double)s->total * ns_per_tick / 1e6, 100.0 * (double)s->total / (double)model_total,
+                    (double)s->total * ns_per_tick / (double)s->calls,
+                    (double)probe_percentile(s, 0.50) * ns_per_tick, (double)probe_percentile(s, 0.90) * ns_per_tick,
+                    (double)probe_percentile(s, 0.99) * ns_per_tick, (double)s->max * ns_per_tick);
+        }
+    }
+    fprintf(stderr, "  (Each interval includes about %.1f ns of probe cost; percentiles are bucket lower bounds, "
+            "within 12.5%%.)\n", probe_ns);
+}
+
+#endif // STAGE_PROBES
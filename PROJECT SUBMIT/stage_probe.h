@@ -0,0 +1,75 @@
+/*
+* Stage Probes Header File
+* This header file declares compile-in timing probes for the stages of the NF and WF cycle
+* functions. Built with -DSTAGE_PROBES, each simulate_one_cycle_*_internal() reads the time
+* stamp counter (clock_gettime where there is none) between its stages and charges the
+* interval to the stage just finished; a per-stage table with totals and percentiles is
+* printed to stderr at exit. Without the flag the probe macros expand to nothing.
+*/
+
+#ifndef STAGE_PROBE_H
+#define STAGE_PROBE_H
+
+#include <stdint.h>
+
+// Pipeline models probed
+typedef enum {
+    PROBE_NF,
+    PROBE_WF,
+    PROBE_NUM_MODELS
+} ProbeModel;
+
+// Parts of a simulated cycle
+typedef enum {
+    PROBE_PROLOGUE, // Cycle count, pipeline viewer and debug output
+    PROBE_WB,       // Commit in WB (simulate_instruction)
+    PROBE_MEM,      // Memory access (WF)
+    PROBE_EX,       // NF: branch resolution; WF: forwarding, ALU and branch resolution
+    PROBE_HAZARD,   // RAW / load-use hazard detection in ID
+    PROBE_ADVANCE,  // Moving the pipeline registers, stall and flush bubbles
+    PROBE_FETCH,    // Fetch and decode in IF
+    PROBE_ACCOUNT,  // CPI stack accounting
+    PROBE_NUM_STAGES
+} ProbeStage;
+
+#define PROBE_BUCKETS 496 // Log-linear histogram: exact below 16 ticks, then 8 buckets per power of two
+
+#ifdef STAGE_PROBES
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define stage_probe_now() __rdtsc()
+#else
+#include "sim_util.h"
+#define stage_probe_now() sim_util_now_ns()
+#endif
+
+void stage_probe_add(int model, int stage, uint64_t ticks);
+void stage_probe_report(void);
+
+/*
+* Charges the time since start to a stage and returns the current time.
+*/
+static inline uint64_t stage_probe_record(int model, int stage, uint64_t start) {
+    uint64_t now = stage_probe_now();
+    stage_probe_add(model, stage, now - start);
+    return now;
+}
+
+// At the top of a cycle function, then after each stage
+#define STAGE_PROBE_START(model) \
+    const int stage_probe_model = (model); \
+    uint64_t stage_probe_t = stage_probe_now()
+#define STAGE_PROBE(stage) (stage_probe_t = stage_probe_record(stage_probe_model, (stage), stage_probe_t))
+// In main: prints the table when the process exits
+#define STAGE_PROBE_INIT() atexit(stage_probe_report)
+
+#else
+
+#define STAGE_PROBE_START(model) do { } while (0)
+#define STAGE_PROBE(stage) do { } while (0)
+#define STAGE_PROBE_INIT() do { } while (0)
+
+#endif // STAGE_PROBES
+
+#endif // STAGE_PROBE_H
@@ -0,0 +1,471 @@
+/*
+* Design-Space Sweep
+* This file implements "--sweep <image>": the image is executed functionally once, and the
+* resulting commit trace is shared read-only by every configuration in the cross product
+* of the swept pipeline parameters. Each configuration only replays the trace through the
+* timing model, in parallel on the work-stealing thread pool. The results table lists every
+* configuration with its cycles and cost, and marks the cycles vs cost Pareto frontier.
+*
+* Parameters (--param=<name>=<values>, values as "a,b,c" or "lo:hi[:step]"):
+*   fwd_ex, fwd_mem (0/1), predictor (nt, btfn, perfect), mul_latency, load_latency,
+*   dcache_lines (0 = perfect memory), dcache_line_words, dcache_miss_penalty
+* Parameters that are not swept keep their WF values.
+* Cost (--cost=<name>:<weight>,...): cost = sum of weight * value, where the predictor
+* value is its index (nt = 0, btfn = 1, perfect = 2). Unweighted parameters cost nothing.
+*
+* Supported Operations:
+* - Cross-product configuration generation
+* - Parallel timing of all configurations from one functional run
+* - Text table or CSV report with Pareto frontier
+*
+* Functions:
+* - sweep_main: Parses options, runs the sweep and writes the results.
+*/
+
+#include "sweep.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "commit_trace.h"
+#include "thread_pool.h"
+#include "timing_memo.h"
+#include "trace_reader.h"
+
+// A sweepable parameter: an int field of PipelineConfig
+typedef struct {
+    const char *name;
+    size_t offset;
+} SweepParam;
+
+static const SweepParam sweep_params[] = {
+    { "fwd_ex",              offsetof(PipelineConfig, fwd_ex_ex) },
+    { "fwd_mem",             offsetof(PipelineConfig, fwd_mem_ex) },
+    { "predictor",           offsetof(PipelineConfig, predictor) },
+    { "mul_latency",         offsetof(PipelineConfig, mul_latency) },
+    { "load_latency",        offsetof(PipelineConfig, load_latency) },
+    { "dcache_lines",        offsetof(PipelineConfig, dcache_lines) },
+    { "dcache_line_words",   offsetof(PipelineConfig, dcache_line_words) },
+    { "dcache_miss_penalty", offsetof(PipelineConfig, dcache_miss_penalty) },
+};
+#define SWEEP_NUM_PARAMS ((int)(sizeof(sweep_params) / sizeof(sweep_params[0])))
+
+static const char *predictor_names[] = { "nt", "btfn", "perfect" };
+
+// Values taken by each parameter, and its cost weight
+typedef struct {
+    int values[SWEEP_NUM_PARAMS][SWEEP_MAX_VALUES];
+    int num_values[SWEEP_NUM_PARAMS];
+    double weight[SWEEP_NUM_PARAMS];
+} SweepSpace;
+
+// One pool task: time one configuration against the shared trace
+typedef struct {
+    const CommitTrace *trace;
+    SweepResult *result;
+} SweepTask;
+
+/*
+* Returns a pointer to parameter p of a configuration.
+*/
+static int *sweep_field(PipelineConfig *cfg, int p) {
+    return (int *)((char *)cfg + sweep_params[p].offset);
+}
+
+/*
+* Returns the index of a parameter name, or -1 if unknown.
+*/
+static int sweep_find_param(const char *name, size_t len) {
+    for (int p = 0; p < SWEEP_NUM_PARAMS; p++) {
+        if (strlen(sweep_params[p].name) == len && strncmp(sweep_params[p].name, name, len) == 0) return p;
+    }
+    return -1;
+}
+
+/*
+* Parses one value of parameter p (a predictor name or an integer).
+* Returns 0 on success, -1 if malformed.
+*/
+static int sweep_parse_value(int p, const char *text, int *value) {
+    if (sweep_params[p].offset == offsetof(PipelineConfig, predictor)) {
+        for (int i = 0; i < 3; i++) {
+            if (strcmp(text, predictor_names[i]) == 0) {
+                *value = i;
+                return 0;
+            }
+        }
+        return -1;
+    }
+    char *end;
+    long v = strtol(text, &end, 0);
+    if (end == text || *end != '\0') return -1;
+    *value = (int)v;
+    return 0;
+}
+
+/*
+* Parses "<name>=<values>" into the sweep space.
+* Returns 0 on success, -1 (with a message) if malformed.
+*/
+static int sweep_parse_param(SweepSpace *space, const char *arg) {
+    const char *eq = strchr(arg, '=');
+    int p = eq ? sweep_find_param(arg, (size_t)(eq - arg)) : -1;
+    if (p < 0) {
+        fprintf(stderr, "Error: Unknown sweep parameter in '%s'\n", arg);
+        return -1;
+    }
+
+    char list[256];
+    snprintf(list, sizeof(list), "%s", eq + 1);
+    int count = 0;
+    int malformed = 0;
+    char *save = NULL;
+    for (char *tok = strtok_r(list, ",", &save); tok && !malformed; tok = strtok_r(NULL, ",", &save)) {
+        int lo, hi, step = 1;
+        char *colon = strchr(tok, ':');
+        if (colon && sweep_params[p].offset != offsetof(PipelineConfig, predictor)) {
+            // Range lo:hi[:step]
+            char *end;
+            lo = (int)strtol(tok, &end, 0);
+            malformed = end != colon;
+            hi = (int)strtol(colon + 1, &end, 0);
+            if (*end == ':') step = (int)strtol(end + 1, &end, 0);
+            if (*end != '\0' || step <= 0 || hi < lo) malformed = 1;
+        } else {
+            malformed = sweep_parse_value(p, tok, &lo) < 0;
+            hi = lo;
+        }
+        for (int v = lo; v <= hi && !malformed; v += step) {
+            if (count == SWEEP_MAX_VALUES) {
+                fprintf(stderr, "Error: Too many values for %s (max %d)\n", sweep_params[p].name, SWEEP_MAX_VALUES);
+                return -1;
+            }
+            space->values[p][count++] = v;
+        }
+    }
+    if (malformed || count == 0) {
+        fprintf(stderr, "Error: Invalid values in '%s'\n", arg);
+        return -1;
+    }
+    space->num_values[p] = count;
+    return 0;
+}
+
+/*
+* Parses "<name>:<weight>,..." into the cost weights.
+* Returns 0 on success, -1 (with a message) if malformed.
+*/
+static int sweep_parse_cost(SweepSpace *space, const char *arg) {
+    char list[512];
+    snprintf(list, sizeof(list), "%s", arg);
+    char *save = NULL;
+    for (char *tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        char *colon = strchr(tok, ':');
+        int p = colon ? sweep_find_param(tok, (size_t)(colon - tok)) : -1;
+        char *end = NULL;
+        double weight = colon ? strtod(colon + 1, &end) : 0.0;
+        if (p < 0 || end == colon + 1 || *end != '\0') {
+            fprintf(stderr, "Error: Invalid cost term '%s'\n", tok);
+            return -1;
+        }
+        space->weight[p] = weight;
+    }
+    return 0;
+}
+
+/*
+* Pool task: replays the shared trace through one configuration.
+*/
+static void sweep_run_config(void *arg, int worker) {
+    (void)worker;
+    SweepTask *task = arg;
+    SweepResult *result = task->result;
+
+    TimingModel tm;
+    TimingMemo memo;
+    if (timing_model_init(&tm, &result->cfg) < 0) return; // result->ok stays 0
+    if (timing_memo_init(&memo, &tm) < 0) {
+        timing_model_free(&tm);
+        return;
+    }
+    const CommitRecord *records = task->trace->records;
+    for (size_t i = 0; i < task->trace->count; i++) {
+        timing_memo_commit(&memo, &records[i]);
+    }
+    timing_memo_flush(&memo);
+    result->memo_skipped = memo.skipped;
+    timing_memo_free(&memo);
+    result->cycles = tm.cycles;
+    result->stalls = tm.stalls;
+    result->flushes = tm.flushes;
+    result->dcache_misses = tm.dcache_misses;
+    result->ok = 1;
+    timing_model_free(&tm);
+}
+
+// Sort order for the Pareto scan: cost, then cycles
+static const SweepResult *sweep_sort_base;
+static int sweep_compare(const void *a, const void *b) {
+    const SweepResult *x = &sweep_sort_base[*(const long *)a];
+    const SweepResult *y = &sweep_sort_base[*(const long *)b];
+    if (x->cost != y->cost) return x->cost < y->cost ? -1 : 1;
+    if (x->cycles != y->cycles) return x->cycles < y->cycles ? -1 : 1;
+    return 0;
+}
+
+/*
+* Marks the configurations on the cycles vs cost Pareto frontier.
+* Fills order[] with result indices sorted by cost and returns the number of valid results.
+*/
+static long sweep_pareto(SweepResult *results, long count, long *order) {
+    long valid = 0;
+    for (long i = 0; i < count; i++) {
+        if (results[i].ok) order[valid++] = i;
+    }
+    sweep_sort_base = results;
+    qsort(order, (size_t)valid, sizeof(long), sweep_compare);
+
+    uint64_t best_cycles = UINT64_MAX;
+    const SweepResult *last = NULL;
+    for (long i = 0; i < valid; i++) {
+        SweepResult *r = &results[order[i]];
+        if (r->cycles < best_cycles) {
+            r->pareto = 1;
+            best_cycles = r->cycles;
+            last = r;
+        } else if (last && r->cycles == last->cycles && r->cost == last->cost) {
+            r->pareto = 1; // Equivalent to a frontier point
+        }
+    }
+    return valid;
+}
+
+/*
+* Writes the results as a text table followed by the Pareto frontier.
+*/
+static void sweep_write_table(FILE *out, const SweepResult *results, long count, const long *order, long valid,
+                              uint64_t instructions) {
+    fprintf(out, "%6s %7s %7s %7s %8s %8s %8s %7s %10s %9s %9s %9s %7s %10s %s\n",
+            "fwd_ex", "fwd_mem", "pred", "mul_lat", "load_lat", "dc_lines", "dc_words", "dc_miss",
+            "cycles", "stalls", "flushes", "dc_misses", "CPI", "cost", "pareto");
+    for (long i = 0; i < count; i++) {
+        const SweepResult *r = &results[i];
+        const PipelineConfig *c = &r->cfg;
+        fprintf(out, "%6d %7d %7s %7d %8d %8d %8d %7d ", c->fwd_ex_ex, c->fwd_mem_ex, predictor_names[c->predictor],
+                c->mul_latency, c->load_latency, c->dcache_lines, c->dcache_line_words, c->dcache_miss_penalty);
+        if (!r->ok) {
+            fprintf(out, "%10s\n", "invalid");
+            continue;
+        }
+        fprintf(out, "%10" PRIu64 " %9" PRIu64 " %9" PRIu64 " %9" PRIu64 " %7.3f %10.2f %s\n",
+                r->cycles, r->stalls, r->flushes, r->dcache_misses,
+                instructions ? (double)r->cycles / (double)instructions : 0.0, r->cost, r->pareto ? "*" : "");
+    }
+
+    fprintf(out, "\nPareto frontier (cost vs cycles):\n");
+    for (long i = 0; i < valid; i++) {
+        const SweepResult *r = &results[order[i]];
+        if (!r->pareto) continue;
+        const PipelineConfig *c = &r->cfg;
+        fprintf(out, "  cost %10.2f  cycles %10" PRIu64 "  fwd_ex=%d fwd_mem=%d predictor=%s mul_latency=%d load_latency=%d"
+                     " dcache_lines=%d dcache_line_words=%d dcache_miss_penalty=%d\n",
+                r->cost, r->cycles, c->fwd_ex_ex, c->fwd_mem_ex, predictor_names[c->predictor], c->mul_latency,
+                c->load_latency, c->dcache_lines, c->dcache_line_words, c->dcache_miss_penalty);
+    }
+}
+
+/*
+* Writes the results as CSV (one row per configuration).
+*/
+static void sweep_write_csv(FILE *out, const SweepResult *results, long count, uint64_t instructions) {
+    fprintf(out, "fwd_ex,fwd_mem,predictor,mul_latency,load_latency,dcache_lines,dcache_line_words,"
+                 "dcache_miss_penalty,status,cycles,stalls,flushes,dcache_misses,cpi,cost,pareto\n");
+    for (long i = 0; i < count; i++) {
+        const SweepResult *r = &results[i];
+        const PipelineConfig *c = &r->cfg;
+        fprintf(out, "%d,%d,%s,%d,%d,%d,%d,%d,", c->fwd_ex_ex, c->fwd_mem_ex, predictor_names[c->predictor],
+                c->mul_latency, c->load_latency, c->dcache_lines, c->dcache_line_words, c->dcache_miss_penalty);
+        if (!r->ok) {
+            fprintf(out, "invalid,,,,,,,\n");
+            continue;
+        }
+        fprintf(out, "ok,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.6f,%.6g,%d\n",
+                r->cycles, r->stalls, r->flushes, r->dcache_misses,
+                instructions ? (double)r->cycles / (double)instructions : 0.0, r->cost, r->pareto);
+    }
+}
+
+/*
+* Prints the sweep usage.
+*/
+static void print_sweep_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --sweep <memory_image_file> [options]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --param=<name>=<values>   Sweep a parameter over a,b,c or lo:hi[:step] (repeatable)\n");
+    fprintf(stderr, "                            fwd_ex fwd_mem predictor(nt,btfn,perfect) mul_latency load_latency\n");
+    fprintf(stderr, "                            dcache_lines dcache_line_words dcache_miss_penalty\n");
+    fprintf(stderr, "  --cost=<name>:<weight>,.. Cost metric: sum of weight * parameter value\n");
+    fprintf(stderr, "  --jobs=<n>                Worker threads (default: online cores)\n");
+    fprintf(stderr, "  --report=<file>           Write the results to file (default: stdout)\n");
+    fprintf(stderr, "  --format=<table|csv>      Results format (default: csv for *.csv reports, else table)\n");
+    fprintf(stderr, "  --max-instructions=<n>    Functional run limit (default %llu)\n",
+            (unsigned long long)SWEEP_DEFAULT_MAX_INSTRUCTIONS);
+}
+
+/*
+* Entry point for the sweep driver.
+* argv[0] is "--sweep" and argv[1] the memory image.
+* Returns 0 on success, 2 on usage or I/O errors.
+*/
+int sweep_main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_sweep_usage("simulator");
+        return 2;
+    }
+
+    const char *image_file = argv[1];
+    const char *report_file = NULL;
+    const char *format = NULL;
+    int threads = 0;
+    uint64_t max_instructions = SWEEP_DEFAULT_MAX_INSTRUCTIONS;
+
+    static SweepSpace space; // Large; one per process
+    memset(&space, 0, sizeof(space));
+    PipelineConfig base;
+    pipeline_config_preset(&base, 1);
+    for (int p = 0; p < SWEEP_NUM_PARAMS; p++) {
+        space.values[p][0] = *sweep_field(&base, p);
+        space.num_values[p] = 1;
+    }
+
+    for (int i = 2; i < argc; i++) {
+        if (strncmp(argv[i], "--param=", 8) == 0) {
+            if (sweep_parse_param(&space, argv[i] + 8) < 0) return 2;
+        } else if (strncmp(argv[i], "--cost=", 7) == 0) {
+            if (sweep_parse_cost(&space, argv[i] + 7) < 0) return 2;
+        } else if (strncmp(argv[i], "--jobs=", 7) == 0) {
+            threads = atoi(argv[i] + 7);
+            if (threads <= 0) {
+                fprintf(stderr, "Error: Invalid thread count '%s'\n", argv[i] + 7);
+                return 2;
+            }
+        } else if (strncmp(argv[i], "--report=", 9) == 0) {
+            report_file = argv[i] + 9;
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            format = argv[i] + 9;
+            if (strcmp(format, "table") != 0 && strcmp(format, "csv") != 0) {
+                fprintf(stderr, "Error: Invalid results format '%s'\n", format);
+                return 2;
+            }
+        } else if (strncmp(argv[i], "--max-instructions=", 19) == 0) {
+            max_instructions = strtoull(argv[i] + 19, NULL, 0);
+            if (max_instructions == 0) {
+                fprintf(stderr, "Error: Invalid instruction limit '%s'\n", argv[i] + 19);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            print_sweep_usage("simulator");
+            return 2;
+        }
+    }
+    if (!format) {
+        size_t len = report_file ? strlen(report_file) : 0;
+        format = (len >= 4 && strcmp(report_file + len - 4, ".csv") == 0) ? "csv" : "table";
+    }
+
+    long num_configs = 1;
+    for (int p = 0; p < SWEEP_NUM_PARAMS; p++) {
+        num_configs *= space.num_values[p];
+        if (num_configs > SWEEP_MAX_CONFIGS) {
+            fprintf(stderr, "Error: Sweep has more than %d configurations\n", SWEEP_MAX_CONFIGS);
+            return 2;
+        }
+    }
+
+    // Shared work: one functional run for all configurations
+    static uint32_t memory[MAX_MEMORY_LINES];
+    if (read_memory_image(image_file, memory) < 0) {
+        fprintf(stderr, "Error: Failed to load memory image from file '%s'\n", image_file);
+        return 2;
+    }
+    CommitTrace trace;
+    if (commit_trace_collect(memory, max_instructions, &trace) < 0) {
+        fprintf(stderr, "Error: Out of memory recording the commit trace\n");
+        return 2;
+    }
+    if (!trace.complete) {
+        fprintf(stderr, "Warning: '%s' did not halt within %zu instructions; timing covers that prefix\n",
+                image_file, trace.count);
+    }
+
+    SweepResult *results = calloc((size_t)num_configs, sizeof(SweepResult));
+    SweepTask *tasks = calloc((size_t)num_configs, sizeof(SweepTask));
+    long *order = calloc((size_t)num_configs, sizeof(long));
+    if (threads <= 0) threads = thread_pool_default_size();
+    ThreadPool *pool = (results && tasks && order) ? thread_pool_create(threads) : NULL;
+    if (!pool) {
+        fprintf(stderr, "Error: Cannot allocate the sweep\n");
+        free(results);
+        free(tasks);
+        free(order);
+        commit_trace_free(&trace);
+        return 2;
+    }
+
+    // Cross product in mixed radix order (the last parameter varies fastest)
+    for (long n = 0; n < num_configs; n++) {
+        SweepResult *r = &results[n];
+        r->cfg = base;
+        long rest = n;
+        for (int p = SWEEP_NUM_PARAMS - 1; p >= 0; p--) {
+            int value = space.values[p][rest % space.num_values[p]];
+            rest /= space.num_values[p];
+            *sweep_field(&r->cfg, p) = value;
+            r->cost += space.weight[p] * value;
+        }
+        if (r->cfg.predictor < PREDICT_NOT_TAKEN || r->cfg.predictor > PREDICT_PERFECT) {
+            continue; // Left invalid
+        }
+        tasks[n].trace = &trace;
+        tasks[n].result = r;
+        if (thread_pool_submit(pool, sweep_run_config, &tasks[n]) < 0) {
+            sweep_run_config(&tasks[n], -1);
+        }
+    }
+    thread_pool_wait(pool);
+    thread_pool_destroy(pool);
+
+    long valid = sweep_pareto(results, num_configs, order);
+    uint64_t memo_skipped = 0;
+    for (long n = 0; n < num_configs; n++) memo_skipped += results[n].memo_skipped;
+
+    int result = 0;
+    FILE *out = report_file ? fopen(report_file, "w") : stdout;
+    if (!out) {
+        perror("Error opening sweep report file");
+        result = 2;
+    } else {
+        if (strcmp(format, "csv") == 0) {
+            sweep_write_csv(out, results, num_configs, (uint64_t)trace.count);
+        } else {
+            sweep_write_table(out, results, num_configs, order, valid, (uint64_t)trace.count);
+        }
+        if (out != stdout && fclose(out) != 0) {
+            perror("Error writing sweep report file");
+            result = 2;
+        }
+    }
+    fprintf(stderr, "Sweep: %ld configurations (%ld valid) of %zu instructions on %d threads, "
+            "%.1f%% of instructions timed from memoized loop iterations\n", num_configs, valid, trace.count, threads,
+            valid && trace.count ? 100.0 * (double)memo_skipped / ((double)valid * (double)trace.count) : 0.0);
+
+    free(results);
+    free(tasks);
+    free(order);
+    commit_trace_free(&trace);
+    return result;
+}
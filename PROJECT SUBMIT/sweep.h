@@ -0,0 +1,36 @@
+/*
+* Design-Space Sweep Header File
+* This header file declares the sweep driver, which times one workload under the cross
+* product of pipeline parameters in parallel and reports the cycles vs cost Pareto frontier.
+*/
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdint.h>
+#include "timing_model.h" // For PipelineConfig
+
+#define SWEEP_MAX_VALUES 64                  // Values per swept parameter
+#define SWEEP_MAX_CONFIGS 1000000            // Largest cross product accepted
+#define SWEEP_DEFAULT_MAX_INSTRUCTIONS 10000000ULL // Functional run limit for the shared trace
+
+/*
+* SweepResult structure:
+* One configuration and its timing.
+*/
+typedef struct {
+    PipelineConfig cfg;
+    int ok;           // 0 if the configuration was rejected by the timing model
+    uint64_t cycles;
+    uint64_t stalls;
+    uint64_t flushes;
+    uint64_t dcache_misses;
+    double cost;      // User cost metric
+    int pareto;       // 1 if no other configuration is both cheaper-or-equal and faster-or-equal
+    uint64_t memo_skipped; // Instructions timed through memoized loop iterations
+} SweepResult;
+
+// Entry point for "<prog> --sweep <image> [options]"; returns 0 on success, 2 on errors
+int sweep_main(int argc, char *argv[]);
+
+#endif // SWEEP_H
@@ -0,0 +1,289 @@
+/*
+* Work-Stealing Thread Pool
+* This file implements a fixed-size pool of worker threads. Every worker has its own
+* double-ended task queue: the owner pushes and pops at the tail (most recent first),
+* while idle workers steal from the head of other queues (oldest first). Tasks submitted
+* from outside the pool are spread round-robin over the queues; tasks submitted from a
+* running task go to that worker's own queue.
+*
+* Supported Operations:
+* - Submitting tasks from the main thread or from inside a task
+* - Waiting until every submitted task has finished
+* - Sizing the pool to the host's online cores
+*
+* Functions:
+* - thread_pool_default_size: Returns the number of online cores.
+* - thread_pool_create: Starts a pool with the given number of workers.
+* - thread_pool_submit: Queues a task.
+* - thread_pool_wait: Blocks until all submitted tasks have completed.
+* - thread_pool_destroy: Stops the workers and frees the pool.
+*/
+
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define THREAD_POOL_INITIAL_QUEUE 64 // Initial capacity of each worker queue (grows as needed)
+
+// A queued task
+typedef struct {
+    ThreadPoolTask task;
+    void *arg;
+} ThreadPoolItem;
+
+// One worker's double-ended queue (circular buffer)
+typedef struct {
+    pthread_mutex_t lock;
+    ThreadPoolItem *items;
+    size_t head;     // Index of the oldest item (steal end)
+    size_t count;
+    size_t capacity;
+} WorkQueue;
+
+// Per-thread startup argument
+typedef struct {
+    ThreadPool *pool;
+    int index;
+} WorkerArg;
+
+struct ThreadPool {
+    int num_threads;               // Workers actually running
+    int num_queues;                // Queues allocated (one per requested worker)
+    pthread_t *threads;
+    WorkerArg *worker_args;
+    WorkQueue *queues;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_available; // Signalled when tasks are queued or on shutdown
+    pthread_cond_t all_done;       // Signalled when pending drops to 0
+    long queued;                   // Tasks sitting in queues (may briefly go negative)
+    long pending;                  // Tasks submitted and not yet finished
+    unsigned next_queue;           // Round-robin target for external submissions
+    int shutting_down;
+};
+
+// Pool and worker index of the calling thread, if it is a pool worker
+static __thread ThreadPool *current_pool = NULL;
+static __thread int current_worker = -1;
+
+/*
+* Appends an item at the tail of a queue, growing it if full.
+* Returns 0 on success, -1 if memory cannot be allocated.
+*/
+static int queue_push(WorkQueue *q, ThreadPoolItem item) {
+    pthread_mutex_lock(&q->lock);
+    if (q->count == q->capacity) {
+        size_t new_capacity = q->capacity ? q->capacity * 2 : THREAD_POOL_INITIAL_QUEUE;
+        ThreadPoolItem *items = malloc(new_capacity * sizeof(ThreadPoolItem));
+        if (!items) {
+            pthread_mutex_unlock(&q->lock);
+            return -1;
+        }
+        for (size_t i = 0; i < q->count; i++) {
+            items[i] = q->items[(q->head + i) % q->capacity];
+        }
+        free(q->items);
+        q->items = items;
+        q->head = 0;
+        q->capacity = new_capacity;
+    }
+    q->items[(q->head + q->count) % q->capacity] = item;
+    q->count++;
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+}
+
+/*
+* Takes an item from the tail (owner) or the head (thief) of a queue.
+* Returns 1 and fills *item if the queue was not empty.
+*/
+static int queue_take(WorkQueue *q, int steal, ThreadPoolItem *item) {
+    int found = 0;
+    pthread_mutex_lock(&q->lock);
+    if (q->count > 0) {
+        if (steal) {
+            *item = q->items[q->head];
+            q->head = (q->head + 1) % q->capacity;
+        } else {
+            *item = q->items[(q->head + q->count - 1) % q->capacity];
+        }
+        q->count--;
+        found = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return found;
+}
+
+/*
+* Finds the next task for worker index: its own queue first, then the other queues.
+*/
+static int find_task(ThreadPool *pool, int index, ThreadPoolItem *item) {
+    if (queue_take(&pool->queues[index], 0, item)) return 1;
+    for (int i = 1; i < pool->num_threads; i++) {
+        int victim = (index + i) % pool->num_threads;
+        if (queue_take(&pool->queues[victim], 1, item)) return 1;
+    }
+    return 0;
+}
+
+/*
+* Worker thread main loop: run tasks until the pool shuts down.
+*/
+static void *worker_main(void *arg) {
+    WorkerArg *worker = arg;
+    ThreadPool *pool = worker->pool;
+    current_pool = pool;
+    current_worker = worker->index;
+
+    while (1) {
+        ThreadPoolItem item;
+        if (find_task(pool, worker->index, &item)) {
+            pthread_mutex_lock(&pool->lock);
+            pool->queued--;
+            pthread_mutex_unlock(&pool->lock);
+
+            item.task(item.arg, worker->index);
+
+            pthread_mutex_lock(&pool->lock);
+            if (--pool->pending == 0) pthread_cond_broadcast(&pool->all_done);
+            pthread_mutex_unlock(&pool->lock);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        while (pool->queued <= 0 && !pool->shutting_down) {
+            pthread_cond_wait(&pool->work_available, &pool->lock);
+        }
+        int stop = pool->shutting_down && pool->queued <= 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (stop) break;
+    }
+    return NULL;
+}
+
+/*
+* Returns the number of online cores (at least 1).
+*/
+int thread_pool_default_size(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+/*
+* Starts a pool with num_threads workers (the number of online cores if num_threads <= 0).
+* Returns NULL if the pool cannot be created.
+*/
+ThreadPool *thread_pool_create(int num_threads) {
+    if (num_threads <= 0) num_threads = thread_pool_default_size();
+
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+    pool->num_threads = num_threads;
+    pool->num_queues = num_threads;
+    pool->threads = calloc(num_threads, sizeof(pthread_t));
+    pool->worker_args = calloc(num_threads, sizeof(WorkerArg));
+    pool->queues = calloc(num_threads, sizeof(WorkQueue));
+    if (!pool->threads || !pool->worker_args || !pool->queues) {
+        free(pool->threads);
+        free(pool->worker_args);
+        free(pool->queues);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_available, NULL);
+    pthread_cond_init(&pool->all_done, NULL);
+    for (int i = 0; i < num_threads; i++) {
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        pool->worker_args[i].pool = pool;
+        pool->worker_args[i].index = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->worker_args[i]) != 0) {
+            // Run with the workers that did start
+            pool->num_threads = i;
+            break;
+        }
+    }
+    if (pool->num_threads == 0) {
+        thread_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+/*
+* Queues a task. From inside a task of the same pool it goes to the calling worker's
+* queue, otherwise to the next queue in round-robin order.
+* Returns 0 on success, -1 if the task cannot be queued.
+*/
+int thread_pool_submit(ThreadPool *pool, ThreadPoolTask task, void *arg) {
+    ThreadPoolItem item = { task, arg };
+    int index;
+    if (current_pool == pool && current_worker >= 0) {
+        index = current_worker;
+    } else {
+        pthread_mutex_lock(&pool->lock);
+        index = (int)(pool->next_queue++ % (unsigned)pool->num_threads);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->pending++;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (queue_push(&pool->queues[index], item) < 0) {
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) pthread_cond_broadcast(&pool->all_done);
+        pthread_mutex_unlock(&pool->lock);
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->queued++;
+    pthread_cond_signal(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+/*
+* Blocks until every submitted task (including tasks submitted by tasks) has finished.
+* Must not be called from inside a task.
+*/
+void thread_pool_wait(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->all_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+* Finishes the queued tasks, stops the workers and frees the pool.
+*/
+void thread_pool_destroy(ThreadPool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutting_down = 1;
+    pthread_cond_broadcast(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    for (int i = 0; i < pool->num_queues; i++) {
+        pthread_mutex_destroy(&pool->queues[i].lock);
+        free(pool->queues[i].items);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_available);
+    pthread_cond_destroy(&pool->all_done);
+    free(pool->threads);
+    free(pool->worker_args);
+    free(pool->queues);
+    free(pool);
+}
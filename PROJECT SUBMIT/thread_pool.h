@@ -0,0 +1,24 @@
+/*
+* Work-Stealing Thread Pool Header File
+* This header file declares a fixed-size thread pool used to run many independent
+* simulations in one process. Each worker owns a task queue; idle workers steal from
+* the other queues, so a few long-running jobs do not leave cores idle.
+*/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// A task receives its argument and the index of the worker running it (0..num_threads-1)
+typedef void (*ThreadPoolTask)(void *arg, int worker);
+
+// Opaque pool handle
+typedef struct ThreadPool ThreadPool;
+
+// Function prototypes
+int thread_pool_default_size(void);
+ThreadPool *thread_pool_create(int num_threads);
+int thread_pool_submit(ThreadPool *pool, ThreadPoolTask task, void *arg);
+void thread_pool_wait(ThreadPool *pool);
+void thread_pool_destroy(ThreadPool *pool);
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,288 @@
+/*
+* Timing Memoization
+* This file memoizes the timing of loop iterations on top of the trace-driven timing model.
+* The model's next state depends only on its current state and the next commit record, and
+* every update is built from max() and additions of cycle numbers, so shifting the whole
+* state by a constant shifts the result by the same constant. An iteration is therefore
+* characterized by its loop head, its start state relative to the last writeback cycle
+* (availability that can no longer delay an instruction is clamped) and a hash of its
+* commit records. The first time such an iteration is seen it is timed instruction by
+* instruction and its effect stored; repeats are applied from the table. The functional
+* simulator still executes every instruction, so architectural state stays exact.
+*
+* Supported Operations:
+* - Loop heads found dynamically (targets of backward taken BZ/BEQ/JR)
+* - Exact results, including where a cycle limit is crossed
+* - Disabled automatically when the model has a data cache (its tags are not in the signature)
+*
+* Functions:
+* - timing_memo_init: Attaches memoization to an initialized timing model.
+* - timing_memo_commit: Times the next committed instruction.
+* - timing_memo_flush: Times any buffered instructions (call at the end of the stream).
+* - timing_memo_free: Releases the memo table.
+*/
+
+#include "timing_memo.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_hash.h" // For SIM_HASH_SEED
+
+#define MEMO_HASH_PRIME 0x100000001b3ULL
+
+/*
+* Mixes one 64-bit word into a hash (word-wise FNV-1a with an extra shift for diffusion).
+*/
+static uint64_t memo_mix(uint64_t hash, uint64_t word) {
+    hash ^= word;
+    hash *= MEMO_HASH_PRIME;
+    return hash ^ (hash >> 29);
+}
+
+/*
+* Hashes a signature word by word.
+*/
+static uint64_t signature_hash(const TimingSignature *sig, uint64_t hash) {
+    const int32_t *words = (const int32_t *)sig;
+    for (size_t i = 0; i < sizeof(TimingSignature) / sizeof(int32_t); i++) {
+        hash = memo_mix(hash, (uint32_t)words[i]);
+    }
+    return hash;
+}
+
+/*
+* Shifts the whole model state by delta cycles (the signature is unchanged).
+*/
+static void model_shift(TimingModel *tm, uint64_t delta) {
+    tm->prev_if += delta;
+    tm->prev_id += delta;
+    tm->prev_ex += delta;
+    tm->prev_mem += delta;
+    tm->prev_wb += delta;
+    tm->cycles = tm->prev_wb;
+    tm->fetch_ready += delta;
+    for (int r = 0; r < 32; r++) {
+        tm->reg_ready[r] += delta;
+    }
+}
+
+/*
+* Captures the model state relative to its last writeback cycle.
+*/
+static void signature_capture(const TimingModel *tm, TimingSignature *sig) {
+    uint64_t base = tm->prev_wb;
+    uint64_t fetch_floor = tm->prev_if + 1; // The next fetch is never earlier
+    uint64_t reg_floor = tm->prev_ex + 1;   // The next EX is never earlier
+
+    sig->stage[0] = (int32_t)(tm->prev_if - base);
+    sig->stage[1] = (int32_t)(tm->prev_id - base);
+    sig->stage[2] = (int32_t)(tm->prev_ex - base);
+    sig->stage[3] = (int32_t)(tm->prev_mem - base);
+    sig->fetch_ready = (int32_t)((tm->fetch_ready > fetch_floor ? tm->fetch_ready : fetch_floor) - base);
+    for (int r = 0; r < 32; r++) {
+        sig->reg_ready[r] = (int32_t)((tm->reg_ready[r] > reg_floor ? tm->reg_ready[r] : reg_floor) - base);
+    }
+}
+
+/*
+* Sets the model state to a signature placed at writeback cycle base.
+*/
+static void signature_apply(TimingModel *tm, const TimingSignature *sig, uint64_t base) {
+    tm->prev_if = base + (int64_t)sig->stage[0];
+    tm->prev_id = base + (int64_t)sig->stage[1];
+    tm->prev_ex = base + (int64_t)sig->stage[2];
+    tm->prev_mem = base + (int64_t)sig->stage[3];
+    tm->prev_wb = base;
+    tm->cycles = base;
+    tm->fetch_ready = base + (int64_t)sig->fetch_ready;
+    for (int r = 0; r < 32; r++) {
+        tm->reg_ready[r] = base + (int64_t)sig->reg_ready[r];
+    }
+}
+
+/*
+* Times one record on the model unless the cycle limit has already been passed.
+*/
+static void memo_time(TimingMemo *memo, const CommitRecord *rec) {
+    if (memo->cycle_limit && memo->model->cycles > memo->cycle_limit) return;
+    timing_model_commit(memo->model, rec);
+}
+
+/*
+* Times the buffered records of the current iteration instruction by instruction.
+*/
+static void memo_replay(TimingMemo *memo) {
+    for (size_t i = 0; i < memo->pending_count; i++) {
+        memo_time(memo, &memo->pending[i]);
+    }
+    memo->pending_count = 0;
+}
+
+/*
+* Returns the table slot where an iteration is (or would be) stored, or NULL if the
+* iteration is not stored and the table is full.
+*/
+static TimingMemoEntry *memo_find(TimingMemo *memo, uint32_t head, uint32_t length, uint64_t path,
+                                  const TimingSignature *start) {
+    uint64_t hash = signature_hash(start, memo_mix(path, (uint64_t)head << 32 | length));
+    for (size_t probe = 0; probe < TIMING_MEMO_ENTRIES; probe++) {
+        TimingMemoEntry *e = &memo->entries[(hash + probe) & (TIMING_MEMO_ENTRIES - 1)];
+        if (!e->used) return e;
+        if (e->head == head && e->length == length && e->path == path &&
+            memcmp(&e->start, start, sizeof(TimingSignature)) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/*
+* Ends the current iteration: applies it from the table on a repeat, otherwise times it
+* and stores its effect.
+*/
+static void memo_close_iteration(TimingMemo *memo) {
+    if (memo->overflowed || memo->pending_count == 0) {
+        memo->pending_count = 0;
+        return;
+    }
+
+    TimingModel *tm = memo->model;
+    uint32_t length = (uint32_t)memo->pending_count;
+
+    // Steady state: the last iteration started and ended in the same shape and this one
+    // started where it ended, so a repeat of its path just shifts the state
+    TimingMemoEntry *steady = memo->steady;
+    memo->steady = NULL;
+    if (steady && steady->head == memo->head && steady->length == length && steady->path == memo->path &&
+        !(memo->cycle_limit && tm->prev_wb + steady->wb_delta > memo->cycle_limit)) {
+        model_shift(tm, steady->wb_delta);
+        tm->stalls += steady->stalls;
+        tm->flushes += steady->flushes;
+        tm->instructions += length;
+        memo->pending_count = 0;
+        memo->hits++;
+        memo->skipped += length;
+        memo->steady = steady;
+        return;
+    }
+
+    // Buffered records have not touched the model, so it is still in the iteration's start state
+    signature_capture(tm, &memo->start);
+    TimingMemoEntry *e = memo_find(memo, memo->head, length, memo->path, &memo->start);
+    if (e && e->used && !(memo->cycle_limit && tm->prev_wb + e->wb_delta > memo->cycle_limit)) {
+        signature_apply(tm, &e->end, tm->prev_wb + e->wb_delta);
+        tm->stalls += e->stalls;
+        tm->flushes += e->flushes;
+        tm->instructions += length;
+        memo->pending_count = 0;
+        memo->hits++;
+        memo->skipped += length;
+        if (memcmp(&e->start, &e->end, sizeof(TimingSignature)) == 0) memo->steady = e;
+        return;
+    }
+
+    uint64_t wb_before = tm->prev_wb, stalls_before = tm->stalls, flushes_before = tm->flushes;
+    memo_replay(memo);
+    memo->misses++;
+    if (e && !e->used && !(memo->cycle_limit && tm->cycles > memo->cycle_limit)) {
+        e->used = 1;
+        e->head = memo->head;
+        e->length = length;
+        e->path = memo->path;
+        e->start = memo->start;
+        signature_capture(tm, &e->end);
+        e->wb_delta = tm->prev_wb - wb_before;
+        e->stalls = tm->stalls - stalls_before;
+        e->flushes = tm->flushes - flushes_before;
+        if (memcmp(&e->start, &e->end, sizeof(TimingSignature)) == 0) memo->steady = e;
+    }
+}
+
+/*
+* Attaches memoization to an initialized model. Memoization is disabled (records pass
+* straight through) when the model has a data cache.
+* Returns 0 on success, -1 if memory cannot be allocated.
+*/
+int timing_memo_init(TimingMemo *memo, TimingModel *model) {
+    memset(memo, 0, sizeof(TimingMemo));
+    memo->model = model;
+    memo->enabled = model->cfg.dcache_lines == 0;
+    if (!memo->enabled) return 0;
+
+    memo->entries = calloc(TIMING_MEMO_ENTRIES, sizeof(TimingMemoEntry));
+    memo->pending = malloc(TIMING_MEMO_MAX_ITERATION * sizeof(CommitRecord));
+    if (!memo->entries || !memo->pending) {
+        timing_memo_free(memo);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+* Times the next committed instruction (records must be given in commit order). Records of
+* a loop iteration are buffered until the iteration ends, so model statistics lag by at
+* most one iteration; call timing_memo_flush() before reading final results.
+*/
+void timing_memo_commit(TimingMemo *memo, const CommitRecord *rec) {
+    if (!memo->enabled) {
+        memo_time(memo, rec);
+        return;
+    }
+
+    // A backward taken branch has just landed on rec->pc: a loop head
+    if (memo->last_valid && memo->last_taken && rec->pc <= memo->last_pc) {
+        if (memo->in_loop && memo->head == rec->pc) {
+            memo_close_iteration(memo);
+        } else {
+            memo_replay(memo); // Different loop: the partial iteration is not memoized
+            memo->steady = NULL;
+        }
+        memo->in_loop = 1;
+        memo->head = rec->pc;
+        memo->path = SIM_HASH_SEED;
+        memo->overflowed = 0;
+    }
+    memo->last_valid = 1;
+    memo->last_pc = rec->pc;
+    memo->last_taken = rec->taken;
+
+    if (!memo->in_loop || memo->overflowed) {
+        memo_time(memo, rec);
+        return;
+    }
+    if (memo->pending_count == TIMING_MEMO_MAX_ITERATION) {
+        memo_replay(memo);
+        memo->overflowed = 1;
+        memo->steady = NULL;
+        memo_time(memo, rec);
+        return;
+    }
+
+    // The effective address only matters to the data cache, which disables memoization
+    uint64_t words[2];
+    memcpy(words, rec, sizeof(words));
+    memo->path = memo_mix(memo_mix(memo->path, words[0] & ~0xFFFFFFFF00000000ULL), words[1]);
+    memo->pending[memo->pending_count++] = *rec;
+}
+
+/*
+* Times any buffered records, so the model holds the results of every record given so far.
+* The current iteration is not memoized; the next record starts outside any loop.
+*/
+void timing_memo_flush(TimingMemo *memo) {
+    memo_replay(memo);
+    memo->in_loop = 0;
+    memo->last_valid = 0;
+    memo->steady = NULL;
+}
+
+/*
+* Releases the memo table and buffer (the model itself is not freed).
+*/
+void timing_memo_free(TimingMemo *memo) {
+    free(memo->entries);
+    free(memo->pending);
+    memo->entries = NULL;
+    memo->pending = NULL;
+}
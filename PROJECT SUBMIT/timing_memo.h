@@ -0,0 +1,87 @@
+/*
+* Timing Memoization Header File
+* This header file declares loop-iteration memoization for the trace-driven timing model.
+* An iteration runs from a loop head (the target of a backward taken branch) back to the
+* same head. If an iteration starts in the same pipeline shape (stage and register
+* availability cycles relative to the last writeback) and follows the same instruction
+* path as one timed before, it takes the same cycles, stalls and flushes and ends in the
+* same shape, so its timing is applied in one step instead of instruction by instruction.
+*/
+
+#ifndef TIMING_MEMO_H
+#define TIMING_MEMO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "timing_model.h" // For TimingModel and CommitRecord
+
+#define TIMING_MEMO_ENTRIES 1024      // Memoized iterations per model (power of two)
+#define TIMING_MEMO_MAX_ITERATION 4096 // Longest iteration (instructions) that is memoized
+
+/*
+* TimingSignature structure:
+* Timing model state relative to prev_wb. Register and fetch availability that can no
+* longer delay anything is clamped, so equivalent states compare equal.
+*/
+typedef struct {
+    int32_t stage[4];      // prev_if, prev_id, prev_ex, prev_mem
+    int32_t fetch_ready;
+    int32_t reg_ready[32];
+} TimingSignature;
+
+/*
+* TimingMemoEntry structure:
+* One timed iteration: its start state and path, and its effect on the model.
+*/
+typedef struct {
+    int used;
+    uint32_t head;            // Loop head PC
+    uint32_t length;          // Instructions in the iteration
+    uint64_t path;            // Hash of the iteration's commit records
+    TimingSignature start;
+    TimingSignature end;
+    uint64_t wb_delta;        // Advance of prev_wb over the iteration
+    uint64_t stalls;
+    uint64_t flushes;
+} TimingMemoEntry;
+
+/*
+* TimingMemo structure:
+* Wraps a TimingModel. Records are buffered for the current iteration and either replayed
+* through the model (first occurrence) or applied from the memo table (repeat).
+*/
+typedef struct {
+    TimingModel *model;
+    int enabled;                 // 0 when the model has state outside the signature (data cache)
+    uint64_t cycle_limit;        // If set, stop timing once the model passes this cycle (exactly where
+                                 // instruction-by-instruction timing would), 0 = none
+    TimingMemoEntry *entries;
+
+    // Current iteration
+    int in_loop;                 // 1 once a loop head has been seen
+    uint32_t head;
+    TimingSignature start;       // Captured when the iteration is looked up
+    uint64_t path;
+    CommitRecord *pending;       // Buffered records of the current iteration
+    size_t pending_count;
+    int overflowed;              // Iteration too long: records were replayed, not memoized
+    TimingMemoEntry *steady;     // Last iteration if it ended in its own start shape (model is in it)
+
+    // Previous record (to detect backward taken branches)
+    int last_valid;
+    uint32_t last_pc;
+    int last_taken;
+
+    // Statistics
+    uint64_t hits;               // Iterations applied from the table
+    uint64_t misses;             // Iterations timed instruction by instruction
+    uint64_t skipped;            // Instructions timed through hits
+} TimingMemo;
+
+// Function prototypes
+int timing_memo_init(TimingMemo *memo, TimingModel *model);
+void timing_memo_commit(TimingMemo *memo, const CommitRecord *rec);
+void timing_memo_flush(TimingMemo *memo);
+void timing_memo_free(TimingMemo *memo);
+
+#endif // TIMING_MEMO_H
@@ -0,0 +1,170 @@
+/*
+* Trace-Driven Timing Model
+* This file times a commit trace on a configurable in-order 5-stage pipeline. Instead of
+* moving instructions through pipeline registers every cycle, it computes for each
+* committed instruction the cycle it enters IF, ID, EX, MEM and WB from the previous
+* instruction's stage cycles (a stage is free once its occupant has moved on), the cycle
+* each source register becomes available on the enabled forwarding paths, and branch
+* redirects. Data and structural hazards show up as extra cycles spent in ID.
+*
+* Supported Operations:
+* - Forwarding paths EX/MEM -> EX and MEM/WB -> EX (none = register file only, as NF)
+* - Static not-taken, backward-taken/forward-not-taken and perfect branch prediction
+* - Multi-cycle MUL/MULI and LDW, and a direct-mapped data cache with a miss penalty
+*
+* Functions:
+* - pipeline_config_preset: Fills in the NF or WF configuration.
+* - timing_model_init: Prepares a model for a configuration.
+* - timing_model_commit: Times the next committed instruction.
+* - timing_model_free: Releases the model.
+*/
+
+#include "timing_model.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "instruction_decoder.h" // For opcodes and instruction types
+
+/*
+* Returns the larger of two cycle numbers.
+*/
+static uint64_t max_cycle(uint64_t a, uint64_t b) {
+    return a > b ? a : b;
+}
+
+/*
+* Fills in the configuration of the NF (forwarding = 0) or WF (forwarding = 1) simulator:
+* branches resolved in EX with not-taken fetch, single-cycle units and perfect memory.
+*/
+void pipeline_config_preset(PipelineConfig *cfg, int forwarding) {
+    memset(cfg, 0, sizeof(PipelineConfig));
+    cfg->fwd_ex_ex = forwarding;
+    cfg->fwd_mem_ex = forwarding;
+    cfg->predictor = PREDICT_NOT_TAKEN;
+    cfg->mul_latency = 1;
+    cfg->load_latency = 1;
+    cfg->dcache_lines = 0;
+    cfg->dcache_line_words = 4;
+    cfg->dcache_miss_penalty = 10;
+}
+
+/*
+* Prepares a model for the given configuration.
+* Returns 0 on success, -1 if the configuration is invalid or memory cannot be allocated.
+*/
+int timing_model_init(TimingModel *tm, const PipelineConfig *cfg) {
+    if (cfg->mul_latency < 1 || cfg->load_latency < 1 || cfg->dcache_lines < 0 ||
+        cfg->dcache_line_words < 1 || cfg->dcache_miss_penalty < 0) {
+        return -1;
+    }
+
+    memset(tm, 0, sizeof(TimingModel));
+    tm->cfg = *cfg;
+    tm->fetch_ready = 1; // The first instruction is fetched in cycle 1
+    if (cfg->dcache_lines > 0) {
+        tm->dcache_tags = calloc((size_t)cfg->dcache_lines, sizeof(uint32_t));
+        if (!tm->dcache_tags) return -1;
+    }
+    return 0;
+}
+
+/*
+* Returns the extra MEM cycles of a data access (0 on a hit or with perfect memory).
+*/
+static int dcache_access(TimingModel *tm, uint32_t address) {
+    if (!tm->dcache_tags) return 0;
+
+    uint32_t line = (address / 4) / (uint32_t)tm->cfg.dcache_line_words;
+    uint32_t index = line % (uint32_t)tm->cfg.dcache_lines;
+    uint32_t tag = line / (uint32_t)tm->cfg.dcache_lines;
+    if (tm->dcache_tags[index] == tag + 1) return 0;
+
+    tm->dcache_tags[index] = tag + 1;
+    tm->dcache_misses++;
+    return tm->cfg.dcache_miss_penalty;
+}
+
+/*
+* Times the next committed instruction (records must be given in commit order).
+*/
+void timing_model_commit(TimingModel *tm, const CommitRecord *rec) {
+    const PipelineConfig *cfg = &tm->cfg;
+    Opcode op = (Opcode)rec->opcode;
+
+    // Stage entry: each stage is free once the previous instruction has entered the next one
+    uint64_t if_cycle = max_cycle(max_cycle(tm->prev_if + 1, tm->prev_id), tm->fetch_ready);
+    uint64_t id_cycle = max_cycle(if_cycle + 1, tm->prev_ex);
+    uint64_t ex_cycle = max_cycle(id_cycle + 1, tm->prev_mem);
+
+    // Source operands (same rules as the NF/WF hazard detection)
+    if (op != HALT && op != NOP) {
+        if (rec->rs != 0) ex_cycle = max_cycle(ex_cycle, tm->reg_ready[rec->rs]);
+        if ((rec->type == R_TYPE || op == BEQ || op == STW) && rec->rt != 0) {
+            ex_cycle = max_cycle(ex_cycle, tm->reg_ready[rec->rt]);
+        }
+    }
+    tm->stalls += ex_cycle - (id_cycle + 1);
+
+    int ex_latency = (op == MUL || op == MULI) ? cfg->mul_latency : 1;
+    int mem_latency = 1;
+    if (op == LDW) {
+        mem_latency = cfg->load_latency + dcache_access(tm, rec->mem_addr);
+    } else if (op == STW) {
+        mem_latency = 1 + dcache_access(tm, rec->mem_addr);
+    }
+    uint64_t mem_cycle = max_cycle(ex_cycle + ex_latency, tm->prev_wb);
+    uint64_t wb_cycle = max_cycle(mem_cycle + mem_latency, tm->prev_wb + 1);
+
+    // Destination register: earliest EX cycle of a consumer on the enabled paths
+    int dest = -1;
+    if (rec->type == R_TYPE) {
+        dest = rec->rd;
+    } else if (op == ADDI || op == SUBI || op == MULI || op == ORI || op == ANDI || op == XORI || op == LDW) {
+        dest = rec->rt;
+    }
+    if (dest > 0) {
+        uint64_t ready = wb_cycle + 1; // Register file: written in WB, read by a consumer in ID
+        if (cfg->fwd_mem_ex) ready = wb_cycle;
+        if (cfg->fwd_ex_ex && op != LDW) ready = mem_cycle;
+        tm->reg_ready[dest] = ready;
+    }
+
+    // Control transfer: where the next instruction can be fetched from
+    if (op == BZ || op == BEQ || op == JR) {
+        int predicted_taken = 0;
+        if (cfg->predictor == PREDICT_PERFECT) {
+            predicted_taken = rec->taken;
+        } else if (cfg->predictor == PREDICT_BTFN && op != JR) {
+            predicted_taken = rec->immediate < 0; // JR has no target in ID, treated as not taken
+        }
+
+        if (cfg->predictor == PREDICT_PERFECT) {
+            // Oracle fetch: no bubbles
+        } else if (predicted_taken == rec->taken) {
+            if (rec->taken) {
+                tm->fetch_ready = id_cycle + 1; // Redirected from ID, squashing the one instruction in IF
+                tm->flushes += 1;
+            }
+        } else {
+            tm->fetch_ready = ex_cycle + 1; // Resolved in EX, squashing IF and ID
+            tm->flushes += 2;
+        }
+    }
+
+    tm->prev_if = if_cycle;
+    tm->prev_id = id_cycle;
+    tm->prev_ex = ex_cycle;
+    tm->prev_mem = mem_cycle;
+    tm->prev_wb = wb_cycle;
+    tm->instructions++;
+    tm->cycles = wb_cycle;
+}
+
+/*
+* Releases the model's data cache state.
+*/
+void timing_model_free(TimingModel *tm) {
+    free(tm->dcache_tags);
+    tm->dcache_tags = NULL;
+}
@@ -0,0 +1,67 @@
+/*
+* Timing Model Header File
+* This header file defines a parameterized, trace-driven timing model of the 5-stage
+* MIPS-lite pipeline. It replays a commit trace and computes, for every instruction, the
+* cycle it enters each stage, so one functional run can be timed under many pipeline
+* configurations. With the NF and WF presets it reproduces the cycle and stall counts of
+* the cycle-by-cycle simulators in no_fwd.c and with_fwd.c.
+*/
+
+#ifndef TIMING_MODEL_H
+#define TIMING_MODEL_H
+
+#include <stdint.h>
+#include "commit_trace.h" // For CommitRecord
+
+// Branch handling (branches resolve in EX; predictions are made in ID)
+typedef enum {
+    PREDICT_NOT_TAKEN, // Static not-taken: every taken branch flushes IF/ID (NF/WF behaviour)
+    PREDICT_BTFN,      // Backward taken, forward not taken
+    PREDICT_PERFECT    // Oracle: no branch penalty
+} BranchPredictor;
+
+/*
+* PipelineConfig structure:
+* One point in the pipeline design space.
+*/
+typedef struct {
+    int fwd_ex_ex;           // EX/MEM -> EX forwarding path (ALU results one cycle after EX)
+    int fwd_mem_ex;          // MEM/WB -> EX forwarding path (ALU and load results)
+    BranchPredictor predictor;
+    int mul_latency;         // EX cycles taken by MUL/MULI (1 = single cycle)
+    int load_latency;        // MEM cycles taken by a LDW cache hit (1 = single cycle)
+    int dcache_lines;        // Direct-mapped data cache lines (0 = perfect memory)
+    int dcache_line_words;   // Words per cache line
+    int dcache_miss_penalty; // Extra MEM cycles on a cache miss
+} PipelineConfig;
+
+/*
+* TimingModel structure:
+* Replay state: stage entry cycles of the previous instruction, register availability
+* and the statistics accumulated so far.
+*/
+typedef struct {
+    PipelineConfig cfg;
+
+    // Stage entry cycles of the previous instruction
+    uint64_t prev_if, prev_id, prev_ex, prev_mem, prev_wb;
+    uint64_t fetch_ready;      // Earliest fetch cycle for the next instruction (branch redirects)
+    uint64_t reg_ready[32];    // Earliest EX cycle at which each register's new value can be used
+
+    uint32_t *dcache_tags;     // Tag + 1 per line (0 = invalid), NULL for perfect memory
+
+    // Statistics
+    uint64_t instructions;
+    uint64_t cycles;           // Cycle in which the last instruction was in WB
+    uint64_t stalls;           // Cycles an instruction was held in ID (data and structural hazards)
+    uint64_t flushes;          // Wrong-path instructions squashed
+    uint64_t dcache_misses;
+} TimingModel;
+
+// Function prototypes
+void pipeline_config_preset(PipelineConfig *cfg, int forwarding);
+int timing_model_init(TimingModel *tm, const PipelineConfig *cfg);
+void timing_model_commit(TimingModel *tm, const CommitRecord *rec);
+void timing_model_free(TimingModel *tm);
+
+#endif // TIMING_MODEL_H
@@ -0,0 +1,330 @@
+/*
+* Trace Differ
+* This file implements a streaming comparison of two simulator traces, such as a debug run
+* against golden_trace.txt or the FS/NF/WF sample outputs. Both files are mmap'ed and walked
+* line by line without copying, so multi-gigabyte traces can be compared quickly.
+*
+* Only semantic records are compared: one commit record per executed instruction
+* ("SIMULATE_INSTRUCTION called with ..."), the final state (instruction counts, registers,
+* memory) and the timing totals. Debug lines (pipeline state, cycle headers, etc.) are skipped
+* unless --strict is given. Because records are compared in order, commits are aligned by
+* commit index. The first divergence is reported with surrounding context from both files.
+*
+* Supported Operations:
+* - Compare commits, final state and timing totals, with any kind optionally ignored
+* - Mask named fields (e.g. "Opcode") inside records
+* - Report the first divergence with N records of context
+*
+* Functions:
+* - trace_diff_main: Parses options, maps both files and runs the comparison.
+*/
+
+#include "trace_diff.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// A memory-mapped trace being walked one line at a time
+typedef struct {
+    const char *path;
+    const char *base;
+    size_t size;
+    size_t pos;
+    size_t line_no;
+    unsigned long long commits; // Commit records seen so far
+    TraceRecord history[TRACE_DIFF_MAX_CONTEXT]; // Ring of the most recent records
+    size_t history_count;
+} TraceStream;
+
+// Command line options for the differ
+typedef struct {
+    int ignore_kind[RECORD_OTHER + 1];
+    const char *ignored_fields[TRACE_DIFF_MAX_IGNORED_FIELDS];
+    int num_ignored_fields;
+    int context;
+} TraceDiffOptions;
+
+// Line prefixes for each record kind (anything else is RECORD_OTHER)
+static const char *commit_prefixes[] = { "SIMULATE_INSTRUCTION called with" };
+static const char *state_prefixes[] = {
+    "Total number of instructions:", "Arithmetic instructions:", "Logical instructions:",
+    "Memory access instructions:", "Control transfer instructions:", "Program counter:", "Address:"
+};
+static const char *timing_prefixes[] = { "Total stalls:", "Total flushes:", "Total number of clock cycles:" };
+
+/*
+* Checks whether a line starts with any of the given prefixes.
+*/
+static int has_prefix(const char *text, size_t len, const char *prefixes[], size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        size_t plen = strlen(prefixes[i]);
+        if (len >= plen && memcmp(text, prefixes[i], plen) == 0) return 1;
+    }
+    return 0;
+}
+
+/*
+* Classifies a line into a record kind.
+* Register lines ("R12: 34") are part of the final state.
+*/
+static TraceRecordKind classify_line(const char *text, size_t len) {
+    if (has_prefix(text, len, commit_prefixes, sizeof(commit_prefixes) / sizeof(commit_prefixes[0]))) return RECORD_COMMIT;
+    if (has_prefix(text, len, state_prefixes, sizeof(state_prefixes) / sizeof(state_prefixes[0]))) return RECORD_STATE;
+    if (has_prefix(text, len, timing_prefixes, sizeof(timing_prefixes) / sizeof(timing_prefixes[0]))) return RECORD_TIMING;
+    if (len >= 3 && text[0] == 'R' && isdigit((unsigned char)text[1]) && memchr(text, ':', len)) return RECORD_STATE;
+    return RECORD_OTHER;
+}
+
+/*
+* Maps a trace file read-only. Empty files map to an empty stream.
+* Returns 0 on success, -1 on failure.
+*/
+static int open_stream(TraceStream *ts, const char *path) {
+    memset(ts, 0, sizeof(*ts));
+    ts->path = path;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    ts->size = (size_t)st.st_size;
+    if (ts->size > 0) {
+        void *p = mmap(NULL, ts->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            perror(path);
+            close(fd);
+            return -1;
+        }
+        madvise(p, ts->size, MADV_SEQUENTIAL); // Hint the kernel to read ahead aggressively
+        ts->base = p;
+    }
+    close(fd); // The mapping stays valid after the descriptor is closed
+    return 0;
+}
+
+/*
+* Unmaps a trace file.
+*/
+static void close_stream(TraceStream *ts) {
+    if (ts->base) munmap((void *)ts->base, ts->size);
+    ts->base = NULL;
+}
+
+/*
+* Returns the next line of the stream (without "\n" or "\r\n"), or 0 at end of file.
+*/
+static int next_line(TraceStream *ts, const char **text, size_t *len) {
+    if (ts->pos >= ts->size) return 0;
+    const char *start = ts->base + ts->pos;
+    const char *nl = memchr(start, '\n', ts->size - ts->pos);
+    size_t line_len = nl ? (size_t)(nl - start) : ts->size - ts->pos;
+    ts->pos += line_len + (nl ? 1 : 0);
+    ts->line_no++;
+    if (line_len > 0 && start[line_len - 1] == '\r') line_len--;
+    *text = start;
+    *len = line_len;
+    return 1;
+}
+
+/*
+* Advances the stream to the next record that is not ignored and adds it to the history ring.
+* Returns 1 if a record was found, 0 at end of file.
+*/
+static int next_record(TraceStream *ts, const TraceDiffOptions *opts, TraceRecord *rec) {
+    const char *text;
+    size_t len;
+    while (next_line(ts, &text, &len)) {
+        TraceRecordKind kind = classify_line(text, len);
+        if (opts->ignore_kind[kind]) continue;
+        rec->text = text;
+        rec->len = len;
+        rec->line_no = ts->line_no;
+        rec->kind = kind;
+        if (kind == RECORD_COMMIT) ts->commits++;
+        ts->history[ts->history_count % TRACE_DIFF_MAX_CONTEXT] = *rec;
+        ts->history_count++;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+* Compares two records, skipping the values of ignored fields ("name=value" up to the next
+* ',', ';' or whitespace). Returns 1 if the records are equal.
+*/
+static int records_equal(const TraceRecord *a, const TraceRecord *b, const TraceDiffOptions *opts) {
+    if (a->kind != b->kind) return 0;
+    if (a->len == b->len && memcmp(a->text, b->text, a->len) == 0) return 1; // Fast path
+    if (opts->num_ignored_fields == 0) return 0;
+
+    size_t i = 0, j = 0;
+    while (i < a->len && j < b->len) {
+        // At a field boundary in both records, see whether an ignored field starts here
+        int skipped = 0;
+        int at_boundary = (i == 0 || !isalnum((unsigned char)a->text[i - 1]));
+        for (int f = 0; at_boundary && f < opts->num_ignored_fields && !skipped; f++) {
+            const char *name = opts->ignored_fields[f];
+            size_t nlen = strlen(name);
+            if (a->len - i > nlen && b->len - j > nlen &&
+                memcmp(a->text + i, name, nlen) == 0 && a->text[i + nlen] == '=' &&
+                memcmp(b->text + j, name, nlen) == 0 && b->text[j + nlen] == '=') {
+                i += nlen + 1;
+                j += nlen + 1;
+                while (i < a->len && a->text[i] != ',' && a->text[i] != ';' && !isspace((unsigned char)a->text[i])) i++;
+                while (j < b->len && b->text[j] != ',' && b->text[j] != ';' && !isspace((unsigned char)b->text[j])) j++;
+                skipped = 1;
+            }
+        }
+        if (skipped) continue;
+        if (a->text[i] != b->text[j]) return 0;
+        i++;
+        j++;
+    }
+    return i == a->len && j == b->len;
+}
+
+/*
+* Prints the records before (and including) the divergence from a stream's history ring.
+* If the stream has ended, the arrow marks its last record.
+*/
+static void print_history(const TraceStream *ts, int context) {
+    size_t count = ts->history_count;
+    size_t shown = count < (size_t)context + 1 ? count : (size_t)context + 1;
+    for (size_t k = count - shown; k < count; k++) {
+        const TraceRecord *r = &ts->history[k % TRACE_DIFF_MAX_CONTEXT];
+        printf("  %s %8zu: %.*s\n", k == count - 1 ? "->" : "  ", r->line_no, (int)r->len, r->text);
+    }
+}
+
+/*
+* Prints up to `context` records following the divergence.
+*/
+static void print_following(TraceStream *ts, const TraceDiffOptions *opts, int context) {
+    TraceRecord rec;
+    for (int k = 0; k < context && next_record(ts, opts, &rec); k++) {
+        printf("     %8zu: %.*s\n", rec.line_no, (int)rec.len, rec.text);
+    }
+}
+
+/*
+* Prints the command line usage for the differ.
+*/
+static void print_diff_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --diff <expected_trace> <actual_trace> [options]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --ignore=<commits|state|timing>  Skip a record kind (repeatable; timing = stalls/cycles)\n");
+    fprintf(stderr, "  --ignore-field=<name>            Ignore the value of name=... inside records (repeatable)\n");
+    fprintf(stderr, "  --context=<n>                    Records of context around the divergence (default %d)\n", TRACE_DIFF_DEFAULT_CONTEXT);
+    fprintf(stderr, "  --strict                         Also compare debug lines\n");
+}
+
+/*
+* Entry point for the trace differ.
+* argv[0] is "--diff", argv[1] the expected trace and argv[2] the actual trace.
+* Returns 0 if the traces match, 1 at the first divergence, 2 on usage or I/O errors.
+*/
+int trace_diff_main(int argc, char *argv[]) {
+    if (argc < 3) {
+        print_diff_usage("simulator");
+        return 2;
+    }
+
+    TraceDiffOptions opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.ignore_kind[RECORD_OTHER] = 1;
+    opts.context = TRACE_DIFF_DEFAULT_CONTEXT;
+
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--ignore=commits") == 0) {
+            opts.ignore_kind[RECORD_COMMIT] = 1;
+        } else if (strcmp(argv[i], "--ignore=state") == 0) {
+            opts.ignore_kind[RECORD_STATE] = 1;
+        } else if (strcmp(argv[i], "--ignore=timing") == 0) {
+            opts.ignore_kind[RECORD_TIMING] = 1;
+        } else if (strncmp(argv[i], "--ignore-field=", 15) == 0) {
+            if (opts.num_ignored_fields >= TRACE_DIFF_MAX_IGNORED_FIELDS) {
+                fprintf(stderr, "Error: Too many --ignore-field options (max %d)\n", TRACE_DIFF_MAX_IGNORED_FIELDS);
+                return 2;
+            }
+            opts.ignored_fields[opts.num_ignored_fields++] = argv[i] + 15;
+        } else if (strncmp(argv[i], "--context=", 10) == 0) {
+            opts.context = atoi(argv[i] + 10);
+            if (opts.context < 0) opts.context = 0;
+            if (opts.context > TRACE_DIFF_MAX_CONTEXT - 1) opts.context = TRACE_DIFF_MAX_CONTEXT - 1;
+        } else if (strcmp(argv[i], "--strict") == 0) {
+            opts.ignore_kind[RECORD_OTHER] = 0;
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            print_diff_usage("simulator");
+            return 2;
+        }
+    }
+
+    TraceStream expected, actual;
+    if (open_stream(&expected, argv[1]) < 0) return 2;
+    if (open_stream(&actual, argv[2]) < 0) {
+        close_stream(&expected);
+        return 2;
+    }
+
+    clock_t start = clock();
+    unsigned long long records = 0;
+    int result = 0;
+
+    while (1) {
+        TraceRecord a, b;
+        int has_a = next_record(&expected, &opts, &a);
+        int has_b = next_record(&actual, &opts, &b);
+        if (!has_a && !has_b) break;
+
+        if (has_a && has_b && records_equal(&a, &b, &opts)) {
+            records++;
+            continue;
+        }
+
+        // First divergence
+        result = 1;
+        if (!has_a || !has_b) {
+            const TraceStream *shorter = has_a ? &actual : &expected;
+            printf("Traces diverge after %llu records: %s ends after %llu commits.\n",
+                   records, shorter->path, shorter->commits);
+        } else if (a.kind == RECORD_COMMIT || b.kind == RECORD_COMMIT) {
+            printf("Traces diverge at commit #%llu (expected line %zu, actual line %zu):\n",
+                   a.kind == RECORD_COMMIT ? expected.commits : actual.commits, a.line_no, b.line_no);
+        } else {
+            printf("Traces diverge after %llu commits in the final state (expected line %zu, actual line %zu):\n",
+                   expected.commits, a.line_no, b.line_no);
+        }
+        printf("--- expected: %s\n", expected.path);
+        print_history(&expected, opts.context);
+        print_following(&expected, &opts, opts.context);
+        printf("+++ actual: %s\n", actual.path);
+        print_history(&actual, opts.context);
+        print_following(&actual, &opts, opts.context);
+        break;
+    }
+
+    if (result == 0) {
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+        printf("Traces match: %llu commits, %llu records compared (%.1f MB in %.2f s).\n",
+               expected.commits, records, (double)(expected.size + actual.size) / (1024.0 * 1024.0), seconds);
+    }
+
+    close_stream(&expected);
+    close_stream(&actual);
+    return result;
+}
@@ -0,0 +1,37 @@
+/*
+* Trace Differ Header File
+* This header file declares the offline trace comparison tool used to check simulator
+* output (debug traces and final state) against golden_trace.txt and the FS/NF/WF sample outputs.
+* It defines the record kinds, constants, and the entry point called from main.
+*/
+
+#ifndef TRACE_DIFF_H
+#define TRACE_DIFF_H
+
+#include <stddef.h>
+
+// Constants
+#define TRACE_DIFF_MAX_IGNORED_FIELDS 16 // Maximum number of --ignore-field options
+#define TRACE_DIFF_DEFAULT_CONTEXT 3     // Records shown before/after the first divergence
+#define TRACE_DIFF_MAX_CONTEXT 32
+
+// Kinds of semantic records found in a simulator trace
+typedef enum {
+    RECORD_COMMIT, // One per committed instruction ("SIMULATE_INSTRUCTION called with ...")
+    RECORD_STATE,  // Final instruction counts, registers and memory
+    RECORD_TIMING, // Total stalls / clock cycles
+    RECORD_OTHER   // Debug output (only compared with --strict)
+} TraceRecordKind;
+
+// A record is one line of an mmap'ed trace file
+typedef struct {
+    const char *text;
+    size_t len;
+    size_t line_no;
+    TraceRecordKind kind;
+} TraceRecord;
+
+// Entry point for "<prog> --diff <expected> <actual> [options]"; returns 0 if equal, 1 if different, 2 on error
+int trace_diff_main(int argc, char *argv[]);
+
+#endif // TRACE_DIFF_H
@@ -0,0 +1,212 @@
+/*
+* Watchdog
+* This file implements the run watchdog used by the FS, NF and WF step functions.
+* Budgets: NF and WF stop once clock_cycles passes the cycle budget (by default the
+* historical 200000 and 100000), and every mode stops once the instruction budget has
+* committed. Livelock: each committed instruction updates a hash of the architectural
+* state for the locations it may have written, and each taken backward branch samples
+* the hash together with the branch target. A sample equal to the previous one (the state
+* repeats every iteration) or to one saved by Brent's cycle detection (powers of two
+* samples apart, so longer periods are caught after at most two rounds of the cycle)
+* means the run can never finish.
+*
+* Supported Operations:
+* - Cycle and instruction budgets, each configurable or unlimited
+* - Livelock detection with the looping PC range and the instructions per repeat
+* - A one-line stop reason on stderr
+*
+* Functions:
+* - watchdog_config_default: Fills in the default configuration.
+* - watchdog_commit: Accounts one committed instruction.
+* - watchdog_expired: Tells a step function whether to stop the run.
+* - watchdog_report: Prints why the run was stopped (once).
+*/
+
+#include "watchdog.h"
+
+#include <stdio.h>
+
+#include "sim_context.h"
+
+#define WATCHDOG_MEMORY_SALT 0x100000000ULL // Keeps memory words apart from registers
+#define WATCHDOG_PC_SALT 0x200000000ULL     // Keeps the sampled PC apart from both
+
+/*
+* Hashes one (location, value) pair (splitmix64 finalizer).
+*/
+static uint64_t watchdog_mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/*
+* Hashes a value at a location (register number, or salted memory word / PC).
+*/
+static uint64_t location_hash(uint64_t location, uint32_t value) {
+    return watchdog_mix(location << 32 ^ location ^ value);
+}
+
+/*
+* Takes the shadow copies and the hash from the context's current state.
+*/
+static void watchdog_seed(SimContext *ctx) {
+    Watchdog *wd = &ctx->watchdog;
+    wd->hash = 0;
+    for (int r = 0; r < 32; r++) {
+        wd->registers[r] = ctx->state.registers[r];
+        wd->hash ^= location_hash((uint64_t)r, (uint32_t)wd->registers[r]);
+    }
+    for (int w = 0; w < 1024; w++) {
+        wd->memory[w] = ctx->state.memory[w];
+        wd->hash ^= location_hash(WATCHDOG_MEMORY_SALT + (uint64_t)w, wd->memory[w]);
+    }
+    wd->range_lo = UINT32_MAX;
+    wd->range_hi = 0;
+    wd->saved_lo = UINT32_MAX;
+    wd->saved_hi = 0;
+    wd->power = 1;
+    wd->seeded = 1;
+}
+
+/*
+* Folds a register's committed value into the hash if it changed.
+*/
+static void track_register(Watchdog *wd, int reg, int32_t value) {
+    if (wd->registers[reg] == value) return;
+    wd->hash ^= location_hash((uint64_t)reg, (uint32_t)wd->registers[reg]) ^
+                location_hash((uint64_t)reg, (uint32_t)value);
+    wd->registers[reg] = value;
+}
+
+/*
+* Records a livelock over the given PC range.
+*/
+static void watchdog_livelock(Watchdog *wd, uint32_t lo, uint32_t hi, uint64_t length) {
+    wd->stop = WATCHDOG_LIVELOCK;
+    wd->loop_lo = lo;
+    wd->loop_hi = hi;
+    wd->loop_length = length;
+}
+
+/*
+* Fills in the default configuration: the mode's cycle budget, no instruction budget,
+* livelock detection on.
+*/
+void watchdog_config_default(WatchdogConfig *cfg) {
+    cfg->max_cycles = 0;
+    cfg->max_instructions = 0;
+    cfg->detect_livelock = 1;
+}
+
+/*
+* Accounts one instruction that has just committed at pc (called after simulate_instruction,
+* so the registers and memory hold its results).
+*/
+void watchdog_commit(SimContext *ctx, const DecodedInstruction *instr, uint32_t pc) {
+    Watchdog *wd = &ctx->watchdog;
+    if (wd->cfg.max_instructions && ctx->total_instructions >= wd->cfg.max_instructions &&
+        wd->stop == WATCHDOG_RUNNING) {
+        wd->stop = WATCHDOG_INSTRUCTION_BUDGET;
+        wd->budget = wd->cfg.max_instructions;
+    }
+    if (!wd->cfg.detect_livelock) return;
+    if (!wd->seeded) watchdog_seed(ctx);
+
+    // Only these locations can have been written (R0 stays 0, so checking it is harmless)
+    track_register(wd, instr->rt, ctx->state.registers[instr->rt]);
+    if (instr->type == R_TYPE) track_register(wd, instr->rd, ctx->state.registers[instr->rd]);
+    if (instr->opcode == STW) {
+        uint32_t word = (uint32_t)(ctx->state.registers[instr->rs] + instr->immediate) / 4;
+        if (word < 1024 && wd->memory[word] != ctx->state.memory[word]) {
+            wd->hash ^= location_hash(WATCHDOG_MEMORY_SALT + word, wd->memory[word]) ^
+                        location_hash(WATCHDOG_MEMORY_SALT + word, ctx->state.memory[word]);
+            wd->memory[word] = ctx->state.memory[word];
+        }
+    }
+
+    wd->commits++;
+    if (pc < wd->range_lo) wd->range_lo = pc;
+    if (pc > wd->range_hi) wd->range_hi = pc;
+
+    // Sample at taken backward branches (branches write nothing, so registers are still the inputs)
+    uint32_t target;
+    if (instr->opcode == BZ && ctx->state.registers[instr->rs] == 0) {
+        target = pc + (uint32_t)((int32_t)instr->immediate * 4);
+    } else if (instr->opcode == BEQ && ctx->state.registers[instr->rs] == ctx->state.registers[instr->rt]) {
+        target = pc + (uint32_t)((int32_t)instr->immediate * 4);
+    } else if (instr->opcode == JR) {
+        target = (uint32_t)ctx->state.registers[instr->rs];
+    } else {
+        return;
+    }
+    if (target > pc) return;
+
+    uint64_t key = wd->hash ^ location_hash(WATCHDOG_PC_SALT, target);
+    if (wd->range_lo < wd->saved_lo) wd->saved_lo = wd->range_lo;
+    if (wd->range_hi > wd->saved_hi) wd->saved_hi = wd->range_hi;
+
+    if (wd->last_valid && key == wd->last_key) {
+        watchdog_livelock(wd, wd->range_lo, wd->range_hi, wd->commits - wd->last_commits);
+    } else if (wd->saved_valid && key == wd->saved_key) {
+        watchdog_livelock(wd, wd->saved_lo, wd->saved_hi, wd->commits - wd->saved_commits);
+    } else if (++wd->steps == wd->power) {
+        wd->saved_valid = 1;
+        wd->saved_key = key;
+        wd->saved_commits = wd->commits;
+        wd->saved_lo = UINT32_MAX;
+        wd->saved_hi = 0;
+        wd->power *= 2;
+        wd->steps = 0;
+    }
+
+    wd->last_valid = 1;
+    wd->last_key = key;
+    wd->last_commits = wd->commits;
+    wd->range_lo = UINT32_MAX;
+    wd->range_hi = 0;
+}
+
+/*
+* Checks the budgets after a step: the cycle budget (the configured one, or
+* default_max_cycles) and anything watchdog_commit() has found. Prints the reason once.
+* Returns 1 if the run must stop, 0 otherwise.
+*/
+int watchdog_expired(SimContext *ctx, uint64_t default_max_cycles) {
+    Watchdog *wd = &ctx->watchdog;
+    if (wd->stop == WATCHDOG_RUNNING) {
+        uint64_t max_cycles = wd->cfg.max_cycles ? wd->cfg.max_cycles : default_max_cycles;
+        if (max_cycles == WATCHDOG_UNLIMITED || ctx->clock_cycles <= max_cycles) return 0;
+        wd->stop = WATCHDOG_CYCLE_BUDGET;
+        wd->budget = max_cycles;
+    }
+    watchdog_report(ctx);
+    return 1;
+}
+
+/*
+* Prints why the run was stopped to stderr (only the first time; nothing while running).
+*/
+void watchdog_report(SimContext *ctx) {
+    Watchdog *wd = &ctx->watchdog;
+    if (wd->stop == WATCHDOG_RUNNING || wd->reported) return;
+    wd->reported = 1;
+
+    switch (wd->stop) {
+        case WATCHDOG_CYCLE_BUDGET:
+            fprintf(stderr, "Simulator stopped: cycle budget of %llu cycles exhausted.\n",
+                    (unsigned long long)wd->budget);
+            break;
+        case WATCHDOG_INSTRUCTION_BUDGET:
+            fprintf(stderr, "Simulator stopped: instruction budget of %llu instructions exhausted.\n",
+                    (unsigned long long)wd->budget);
+            break;
+        case WATCHDOG_LIVELOCK:
+            fprintf(stderr, "Simulator stopped: infinite loop at PC %u-%u (architectural state repeats every "
+                    "%llu instructions).\n", wd->loop_lo, wd->loop_hi, (unsigned long long)wd->loop_length);
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,81 @@
+/*
+* Watchdog Header File
+* This header file defines the run watchdog: configurable cycle and instruction budgets, and
+* livelock detection. Registers and memory are hashed incrementally as instructions commit
+* (one XOR per changed location), and the hash is sampled whenever a backward branch is
+* taken. The machine is deterministic, so a sample that repeats an earlier one means the
+* program is looping forever; the loop is reported with its PC range instead of running
+* into the cycle budget.
+*/
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <stdint.h>
+#include "instruction_decoder.h" // For DecodedInstruction
+
+#define WATCHDOG_UNLIMITED UINT64_MAX
+#define WATCHDOG_NF_DEFAULT_CYCLES 200000ULL // Cycle budget of NF unless configured
+#define WATCHDOG_WF_DEFAULT_CYCLES 100000ULL // Cycle budget of WF unless configured
+
+// Why a run was stopped
+typedef enum {
+    WATCHDOG_RUNNING,
+    WATCHDOG_CYCLE_BUDGET,
+    WATCHDOG_INSTRUCTION_BUDGET,
+    WATCHDOG_LIVELOCK
+} WatchdogStop;
+
+/*
+* WatchdogConfig structure:
+* Kept across sim_context_reset(), like the context's attachments.
+*/
+typedef struct {
+    uint64_t max_cycles;       // 0 = the mode's default, WATCHDOG_UNLIMITED = none
+    uint64_t max_instructions; // Committed instructions (restored counts included), 0 = none
+    int detect_livelock;       // 1 to hash state at backward branches (the default)
+} WatchdogConfig;
+
+/*
+* Watchdog structure:
+* Lives in the SimContext. The hash covers the values in the shadow copies, which follow
+* the architectural registers and memory at commit (WF writes memory early, in MEM).
+*/
+typedef struct {
+    WatchdogConfig cfg;
+    WatchdogStop stop;
+    uint64_t budget;   // Budget that ran out (for the report)
+    int reported;
+
+    // Incremental state hash
+    int seeded;        // 0 until the shadows have been taken from the context
+    uint64_t hash;     // XOR of one hash per (location, value)
+    int32_t registers[32];
+    uint32_t memory[1024];
+
+    // Repeat detection over the samples at backward branches
+    uint64_t commits;              // Instructions seen since seeding
+    uint32_t range_lo, range_hi;   // PCs committed since the last sample
+    int last_valid;                // Previous sample (catches loops repeating every iteration)
+    uint64_t last_key, last_commits;
+    uint32_t last_lo, last_hi;
+    int saved_valid;               // Brent's cycle detection for longer periods
+    uint64_t saved_key, saved_commits;
+    uint32_t saved_lo, saved_hi;
+    uint64_t power, steps;
+
+    // Detected loop
+    uint32_t loop_lo, loop_hi;
+    uint64_t loop_length;          // Instructions per repeat of the state
+} Watchdog;
+
+// Simulator context (defined in sim_context.h)
+typedef struct SimContext SimContext;
+
+// Function prototypes
+void watchdog_config_default(WatchdogConfig *cfg);
+void watchdog_commit(SimContext *ctx, const DecodedInstruction *instr, uint32_t pc);
+int watchdog_expired(SimContext *ctx, uint64_t default_max_cycles);
+void watchdog_report(SimContext *ctx);
+
+#endif // WATCHDOG_H
@@ -11,7 +11,9 @@
 *
 * Functions:
 * - initialize_pipeline_fwd: Initializes the pipeline registers to NOPs.
+* - resume_pipeline_fwd: Empties the pipeline to continue from the current architectural state.
 * - simulate_pipeline_with_forwarding: Main simulation loop that processes instructions.
+* - step_pipeline_with_forwarding: Advances the pipeline by one clock cycle.
 * - detect_raw_hazard_with_fwd: Detects RAW hazards and returns if a stall is needed.
 * - simulate_one_cycle_with_forwarding_internal: Simulates one cycle of the pipeline with forwarding.
 * - instr_writes_to_reg: Checks if an instruction writes to a register.
@@ -28,46 +30,40 @@
 #include "instruction_decoder.h"
 #include "no_fwd.h"        // For PipelineRegister struct, pipeline_stages enum, NOP_INSTRUCTION
 #include "trace_reader.h"  // For MAX_MEMORY_LINES and WORD_SIZE
-
-#define PIPELINE_DEPTH 5
-
-// Global counters (these must be extern if defined in global_counters.c)
-extern int clock_cycles;
-extern int total_stalls;
-extern int total_flushes;
+#include "kanata.h"        // Pipeline viewer export
+#include "predecode.h"     // For fetch_instruction
+#include "sim_context.h"   // Pipeline registers, pipeline PC and counters live in the context
+#include "watchdog.h"      // Cycle/instruction budgets and livelock detection
+#include "progress.h"      // Progress heartbeat
+#include "live_stats.h"    // Counters page and SIGUSR1 snapshot
+#include "cpi_stack.h"     // Cycle accounting by category
+#include "pc_profile.h"    // Per-PC stall and flush profile
+#include "stage_probe.h"   // Stage timing probes (-DSTAGE_PROBES)
 
 // Global NOP_INSTRUCTION (from global_counters.c)
 extern DecodedInstruction NOP_INSTRUCTION;
 
-// Pipeline stages (conceptual pipeline registers) - MAKE STATIC
-static PipelineRegister pipeline[PIPELINE_DEPTH];
-
-// Internal PC for pipeline fetch - MAKE STATIC
-static uint32_t pipeline_pc = 0;
-static int pipeline_halt_seen = 0;
-
 /*
 * Initializes the pipeline registers to NOPs.
-* This function sets all pipeline registers to NOP_INSTRUCTION,
+* This function sets all of the context's pipeline registers to NOP_INSTRUCTION,
 * which is defined in global_counters.c.
 */
-void initialize_pipeline_fwd() {    // Renamed to avoid collision with no_fwd.c for main init
-    initialize_pipeline(pipeline);  // Use the common initialization function
+void initialize_pipeline_fwd(SimContext *ctx) {    // Renamed to avoid collision with no_fwd.c for main init
+    initialize_pipeline(ctx);  // Use the common initialization function
     // Specific resets for this simulator if needed, but common init handles all.
 }
 
-// Additional global variables for forwarding.
-static int forward_src1_from_ex_output_to_ex_input = 0;  // For EX -> EX forwarding path
-static int32_t result_for_src1_from_ex_output = 0;
-static int forward_src2_from_ex_output_to_ex_input = 0;
-static int32_t result_for_src2_from_ex_output = 0;
-
-static int forward_src1_from_mem_output_to_ex_input = 0;  // For MEM -> EX forwarding path
-static int32_t result_for_src1_from_mem_output = 0;
-static int forward_src2_from_mem_output_to_ex_input = 0;
-static int32_t result_for_src2_from_mem_output = 0;
-
-static int stall_for_load_use = 0;
+/*
+* Empties the pipeline to continue from the context's architectural state (restored
+* checkpoint or functional fast-forward), fetching from state.pc.
+* While running, this simulator keeps the PC of the last retired instruction in state.pc
+* (HALT then adds 4 twice), so state.pc is moved back to the instruction before the
+* resume point; fetching is unaffected.
+*/
+void resume_pipeline_fwd(SimContext *ctx) {
+    resume_pipeline(ctx);
+    ctx->state.pc -= 4;
+}
 
 /*
 * Checks if an instruction writes to a register.
@@ -136,50 +132,50 @@ int detect_raw_hazard_with_fwd(PipelineRegister curr_id_reg, PipelineRegister ex
 * It also handles forwarding paths from EX and MEM stages to EX inputs.
 * It updates the pipeline registers and handles stalls and flushes as needed.
 */
-static void simulate_one_cycle_with_forwarding_internal() {
-    clock_cycles++;
-
-    // Reset forwarding signals for the current cycle's detection phase
-    forward_src1_from_ex_output_to_ex_input = 0;
-    forward_src2_from_ex_output_to_ex_input = 0;
-    forward_src1_from_mem_output_to_ex_input = 0;
-    forward_src2_from_mem_output_to_ex_input = 0;
-    // forward_src1_from_wb_output_to_ex_input = 0; // If using WB->EX
-    // forward_src2_from_wb_output_to_ex_input = 0; // If using WB->EX
+static void simulate_one_cycle_with_forwarding_internal(SimContext *ctx) {
+    STAGE_PROBE_START(PROBE_WF);
+    ctx->clock_cycles++;
+    if (ctx->kanata) kanata_record_cycle(ctx->kanata, ctx->clock_cycles, ctx->pipeline);
+
+    // Forwarding is detected per operand in the EX stage below; no state carries across cycles
     int stall_for_load_use = 0;
     int flush_for_branch = 0;
 
     int current_cycle_branch_taken_in_ex = 0;
     uint32_t current_cycle_branch_target_pc = 0;
+    STAGE_PROBE(PROBE_PROLOGUE);
 
     // --- WB (Write-Back) Stage ---
     // Writes pipeline[WB].result_val to register file.
     // Calls simulate_instruction for PC update and counting.
-    if (pipeline[WB].valid && !is_nop(pipeline[WB].instr)) {
-        simulate_instruction(pipeline[WB].instr);
-        state.pc = pipeline[WB].pc;  // Update PC to the one in WB stage
+    if (ctx->pipeline[WB].valid && !is_nop(ctx->pipeline[WB].instr)) {
+        simulate_instruction(ctx, ctx->pipeline[WB].instr);
+        watchdog_commit(ctx, &ctx->pipeline[WB].instr, ctx->pipeline[WB].pc);
+        if (ctx->pc_profile) pc_profile_commit(ctx->pc_profile, &ctx->pipeline[WB].instr, ctx->pipeline[WB].pc);
+        ctx->state.pc = ctx->pipeline[WB].pc;  // Update PC to the one in WB stage
     }
+    STAGE_PROBE(PROBE_WB);
 
     // --- MEM (Memory Access) Stage ---
     // For LDW: reads memory, result goes to pipeline[MEM].result_val (for WB next cycle).
     // For STW: writes data (from pipeline[EX].result_val via pipeline[MEM].result_val) to memory.
     // For ALU: pipeline[MEM].result_val gets pipeline[EX].result_val.
     // It also passes through branch information from EX.
-    if (pipeline[MEM].valid && !is_nop(pipeline[MEM].instr)) {
-        DecodedInstruction mem_instr = pipeline[MEM].instr;
-        uint32_t eff_addr = pipeline[MEM].branch_target;  // Address came from EX's branch_target field
+    if (ctx->pipeline[MEM].valid && !is_nop(ctx->pipeline[MEM].instr)) {
+        DecodedInstruction mem_instr = ctx->pipeline[MEM].instr;
+        uint32_t eff_addr = ctx->pipeline[MEM].branch_target;  // Address came from EX's branch_target field
 
         if (mem_instr.opcode == LDW) {
             if (eff_addr < MAX_MEMORY_LINES * 4 && (eff_addr % 4 == 0)) {
-                pipeline[MEM].result_val = state.memory[eff_addr / 4];
+                ctx->pipeline[MEM].result_val = ctx->state.memory[eff_addr / 4];
             } else {
-                pipeline[MEM].result_val = 0;  // Handle error
+                ctx->pipeline[MEM].result_val = 0;  // Handle error
             }
         } else if (mem_instr.opcode == STW) {
             // Data for STW was in pipeline[MEM].result_val (passed from EX's result_val)
             if (eff_addr < MAX_MEMORY_LINES * 4 && (eff_addr % 4 == 0)) {
-                state.memory[eff_addr / 4] = pipeline[MEM].result_val;
-                if (memory_changed) memory_changed[eff_addr / 4] = 1;
+                ctx->state.memory[eff_addr / 4] = ctx->pipeline[MEM].result_val;
+                ctx->memory_changed[eff_addr / 4] = 1;
             } else {
                 // fprintf(stderr, "MEM Error: Bad address 0x%X for STW@0x%X\n", eff_addr, pipeline[MEM].pc);
             }
@@ -188,17 +184,18 @@ static void simulate_one_cycle_with_forwarding_internal() {
         // For ALU ops, pipeline[MEM].result_val already holds the value from EX.
         // Branch info is already in pipeline[MEM].branch_taken and .branch_target from EX.
     }
+    STAGE_PROBE(PROBE_MEM);
 
     // --- EX (Execute / Address Calculation) Stage ---
     // Also clear these bits (Edit 06/04/2025 at 11:40 pm)
-    pipeline[EX].branch_taken = 0;
-    pipeline[MEM].branch_taken = 0;
-    pipeline[WB].branch_taken = 0;
-
-    if (pipeline[EX].valid && !is_nop(pipeline[EX].instr)) {
-        DecodedInstruction instr_ex = pipeline[EX].instr;
-        int32_t val_rs = state.registers[instr_ex.rs];  // Default from register file
-        int32_t val_rt = state.registers[instr_ex.rt];  // Default from register file
+    ctx->pipeline[EX].branch_taken = 0;
+    ctx->pipeline[MEM].branch_taken = 0;
+    ctx->pipeline[WB].branch_taken = 0;
+
+    if (ctx->pipeline[EX].valid && !is_nop(ctx->pipeline[EX].instr)) {
+        DecodedInstruction instr_ex = ctx->pipeline[EX].instr;
+        int32_t val_rs = ctx->state.registers[instr_ex.rs];  // Default from register file
+        int32_t val_rt = ctx->state.registers[instr_ex.rt];  // Default from register file
         int32_t ex_stage_output_value = 0;
 
         // ** REVISED FORWARDING LOGIC FOR EX STAGE OPERANDS **
@@ -206,36 +203,52 @@ static void simulate_one_cycle_with_forwarding_internal() {
 
         // Forwarding for Rs (Operand 1 from instr_ex.rs)
         int rs_forwarded = 0;
-        if (pipeline[MEM].valid && instr_writes_to_reg(pipeline[MEM].instr) &&
-            get_dest_reg(pipeline[MEM].instr) == instr_ex.rs && instr_ex.rs != 0) {
-            val_rs = pipeline[MEM].result_val;  // Forward from MEM stage output
+        if (ctx->pipeline[MEM].valid && instr_writes_to_reg(ctx->pipeline[MEM].instr) &&
+            get_dest_reg(ctx->pipeline[MEM].instr) == instr_ex.rs && instr_ex.rs != 0) {
+            val_rs = ctx->pipeline[MEM].result_val;  // Forward from MEM stage output
             rs_forwarded = 1;
+            if (ctx->kanata) {
+                kanata_annotate(ctx->kanata, ctx->pipeline[EX].seq, "R%d forwarded from MEM", instr_ex.rs);
+                kanata_dependency(ctx->kanata, ctx->pipeline[EX].seq, ctx->pipeline[MEM].seq);
+            }
             // printf("Cycle %d: EX_PC=0x%X fwd Rs from MEM_PC=0x%X (val=%d)\n", clock_cycles, pipeline[EX].pc, pipeline[MEM].pc, val_rs);
         }
-        if (!rs_forwarded && pipeline[WB].valid && instr_writes_to_reg(pipeline[WB].instr) &&
-            get_dest_reg(pipeline[WB].instr) == instr_ex.rs && instr_ex.rs != 0) {
-            val_rs = pipeline[WB].result_val;  // Forward from WB stage output
+        if (!rs_forwarded && ctx->pipeline[WB].valid && instr_writes_to_reg(ctx->pipeline[WB].instr) &&
+            get_dest_reg(ctx->pipeline[WB].instr) == instr_ex.rs && instr_ex.rs != 0) {
+            val_rs = ctx->pipeline[WB].result_val;  // Forward from WB stage output
+            if (ctx->kanata) {
+                kanata_annotate(ctx->kanata, ctx->pipeline[EX].seq, "R%d forwarded from WB", instr_ex.rs);
+                kanata_dependency(ctx->kanata, ctx->pipeline[EX].seq, ctx->pipeline[WB].seq);
+            }
             // printf("Cycle %d: EX_PC=0x%X fwd Rs from WB_PC=0x%X (val=%d)\n", clock_cycles, pipeline[EX].pc, pipeline[WB].pc, val_rs);
         }
 
         // Forwarding for Rt (Operand 2, if Rt is a source for instr_ex)
         if (instr_ex.type == R_TYPE || instr_ex.opcode == BEQ || instr_ex.opcode == STW) {
             int rt_forwarded = 0;
-            if (pipeline[MEM].valid && instr_writes_to_reg(pipeline[MEM].instr) &&
-                get_dest_reg(pipeline[MEM].instr) == instr_ex.rt && instr_ex.rt != 0) {
-                val_rt = pipeline[MEM].result_val;
+            if (ctx->pipeline[MEM].valid && instr_writes_to_reg(ctx->pipeline[MEM].instr) &&
+                get_dest_reg(ctx->pipeline[MEM].instr) == instr_ex.rt && instr_ex.rt != 0) {
+                val_rt = ctx->pipeline[MEM].result_val;
                 rt_forwarded = 1;
+                if (ctx->kanata) {
+                    kanata_annotate(ctx->kanata, ctx->pipeline[EX].seq, "R%d forwarded from MEM", instr_ex.rt);
+                    kanata_dependency(ctx->kanata, ctx->pipeline[EX].seq, ctx->pipeline[MEM].seq);
+                }
                 // printf("Cycle %d: EX_PC=0x%X fwd Rt from MEM_PC=0x%X (val=%d)\n", clock_cycles, pipeline[EX].pc, pipeline[MEM].pc, val_rt);
             }
-            if (!rt_forwarded && pipeline[WB].valid && instr_writes_to_reg(pipeline[WB].instr) &&
-                get_dest_reg(pipeline[WB].instr) == instr_ex.rt && instr_ex.rt != 0) {
-                val_rt = pipeline[WB].result_val;
+            if (!rt_forwarded && ctx->pipeline[WB].valid && instr_writes_to_reg(ctx->pipeline[WB].instr) &&
+                get_dest_reg(ctx->pipeline[WB].instr) == instr_ex.rt && instr_ex.rt != 0) {
+                val_rt = ctx->pipeline[WB].result_val;
+                if (ctx->kanata) {
+                    kanata_annotate(ctx->kanata, ctx->pipeline[EX].seq, "R%d forwarded from WB", instr_ex.rt);
+                    kanata_dependency(ctx->kanata, ctx->pipeline[EX].seq, ctx->pipeline[WB].seq);
+                }
                 // printf("Cycle %d: EX_PC=0x%X fwd Rt from WB_PC=0x%X (val=%d)\n", clock_cycles, pipeline[EX].pc, pipeline[WB].pc, val_rt);
             }
         }
 
         // Execute operation using (potentially forwarded) val_rs, val_rt
-        uint32_t current_ex_pc = pipeline[EX].pc;
+        uint32_t current_ex_pc = ctx->pipeline[EX].pc;
 
         switch (instr_ex.opcode) {
             // ALU R-Type
@@ -278,19 +291,19 @@ static void simulate_one_cycle_with_forwarding_internal() {
                 break;
 
             case LDW:
-                pipeline[EX].branch_target = val_rs + instr_ex.immediate;  // Store effective_address
+                ctx->pipeline[EX].branch_target = val_rs + instr_ex.immediate;  // Store effective_address
                 ex_stage_output_value = 0;                                 // Actual data loaded in MEM stage for LDW
                 break;
             case STW:
-                pipeline[EX].branch_target = val_rs + instr_ex.immediate;  // Store effective_address
+                ctx->pipeline[EX].branch_target = val_rs + instr_ex.immediate;  // Store effective_address
                 ex_stage_output_value = val_rt;                            // Pass data_to_store (from val_rt) via result_val
                 break;
 
             // Control
             case BZ:
                 if (val_rs == 0) {
-                    pipeline[EX].branch_taken = 1;
-                    pipeline[EX].branch_target = current_ex_pc + (instr_ex.immediate * 4);  // Corrected target
+                    ctx->pipeline[EX].branch_taken = 1;
+                    ctx->pipeline[EX].branch_target = current_ex_pc + (instr_ex.immediate * 4);  // Corrected target
                 }
                 break;
             case BEQ:
@@ -298,16 +311,16 @@ static void simulate_one_cycle_with_forwarding_internal() {
                 DBG_PRINTF(stderr, "DEBUG: BEQ at EX PC=0x%X, val_rs=%d, val_rt=%d, imm=%d\n",
                         current_ex_pc, val_rs, val_rt, instr_ex.immediate);
                 if (val_rs == val_rt) {  // This comparison needs correct val_rs & val_rt
-                    pipeline[EX].branch_taken = 1;
-                    pipeline[EX].branch_target = current_ex_pc + (instr_ex.immediate * 4);  // Corrected target
+                    ctx->pipeline[EX].branch_taken = 1;
+                    ctx->pipeline[EX].branch_target = current_ex_pc + (instr_ex.immediate * 4);  // Corrected target
                 }
                 // Debug BEQ decision:
-                DBG_PRINTF("Cycle %d: EX BEQ PC=0x%X, R10(val_rs)=%d, R11(val_rt)=%d, Taken=%d\n",
-                        clock_cycles, current_ex_pc, val_rs, val_rt, pipeline[EX].branch_taken);
+                DBG_PRINTF("Cycle %llu: EX BEQ PC=0x%X, R10(val_rs)=%d, R11(val_rt)=%d, Taken=%d\n",
+                        (unsigned long long)ctx->clock_cycles, current_ex_pc, val_rs, val_rt, ctx->pipeline[EX].branch_taken);
                 break;
             case JR:
-                pipeline[EX].branch_taken = 1;
-                pipeline[EX].branch_target = (uint32_t)val_rs;
+                ctx->pipeline[EX].branch_taken = 1;
+                ctx->pipeline[EX].branch_target = (uint32_t)val_rs;
                 break;
 
             case HALT:
@@ -318,27 +331,29 @@ static void simulate_one_cycle_with_forwarding_internal() {
                 ex_stage_output_value = 0;
                 break;
         }
-        pipeline[EX].result_val = ex_stage_output_value;  // Store result for MEM stage / forwarding
+        ctx->pipeline[EX].result_val = ex_stage_output_value;  // Store result for MEM stage / forwarding
 
-        if (pipeline[EX].branch_taken) {
-            pipeline_pc = pipeline[EX].branch_target;  // Update global fetch PC
+        if (ctx->pipeline[EX].branch_taken) {
+            ctx->pipeline_pc = ctx->pipeline[EX].branch_target;  // Update global fetch PC
             flush_for_branch = 1;                      // Ensure this is declared or is your global flag
-            total_flushes += 2;
+            ctx->total_flushes += 2;
+            if (ctx->kanata) kanata_annotate(ctx->kanata, ctx->pipeline[EX].seq, "branch taken to 0x%X, flushing IF/ID", ctx->pipeline_pc);
         }
     } else {
-        pipeline[EX].result_val = 0;
+        ctx->pipeline[EX].result_val = 0;
     }
+    STAGE_PROBE(PROBE_EX);
 
     // --- ID Stage: Decode & Stall for Load-Use Hazard ---
     // Load-use: LDW currently in EX, and instruction currently in ID needs its result.
     // The result of LDW in EX will be available from MEM stage output *next cycle*.
     // The instruction in ID will be in EX *next cycle*. So it needs to stall for one cycle.
     stall_for_load_use = 0;
-    if (pipeline[EX].valid && pipeline[EX].instr.opcode == LDW && instr_writes_to_reg(pipeline[EX].instr)) {
-        int dest_reg_of_load_in_ex = get_dest_reg(pipeline[EX].instr);  // This is pipeline[EX].instr.rt
+    if (ctx->pipeline[EX].valid && ctx->pipeline[EX].instr.opcode == LDW && instr_writes_to_reg(ctx->pipeline[EX].instr)) {
+        int dest_reg_of_load_in_ex = get_dest_reg(ctx->pipeline[EX].instr);  // This is pipeline[EX].instr.rt
         if (dest_reg_of_load_in_ex != 0) {
-            if (pipeline[ID].valid && !is_nop(pipeline[ID].instr)) {
-                DecodedInstruction id_instr = pipeline[ID].instr;
+            if (ctx->pipeline[ID].valid && !is_nop(ctx->pipeline[ID].instr)) {
+                DecodedInstruction id_instr = ctx->pipeline[ID].instr;
                 int id_needs_rs = (id_instr.rs == dest_reg_of_load_in_ex);
                 int id_needs_rt_as_src = ((id_instr.type == R_TYPE || id_instr.opcode == BEQ || id_instr.opcode == STW) &&
                                           (id_instr.rt == dest_reg_of_load_in_ex));
@@ -348,40 +363,50 @@ static void simulate_one_cycle_with_forwarding_internal() {
             }
         }
     }
+    int stall_cause = CPI_LOAD_USE, stall_distance = 1, stall_producer = -1;
     if (stall_for_load_use) {
-        total_stalls++;
+        ctx->total_stalls++;
+        stall_cause = cpi_stack_stall_cause(ctx, &stall_distance, &stall_producer);
+        if (ctx->pc_profile) pc_profile_stall(ctx, stall_producer);
+        if (ctx->kanata) {
+            kanata_annotate(ctx->kanata, ctx->pipeline[ID].seq, "load-use stall on R%d", get_dest_reg(ctx->pipeline[EX].instr));
+            kanata_dependency(ctx->kanata, ctx->pipeline[ID].seq, ctx->pipeline[EX].seq);
+        }
     }
+    STAGE_PROBE(PROBE_HAZARD);
 
     // --- Pipeline Stage Advancement (Shift Registers) ---
     // Order matters: WB gets old MEM, MEM gets old EX, etc.
-    pipeline[WB] = pipeline[MEM];
-    pipeline[MEM] = pipeline[EX];
+    ctx->pipeline[WB] = ctx->pipeline[MEM];
+    ctx->pipeline[MEM] = ctx->pipeline[EX];
 
     // ─── Decide what goes into EX next ─────────────────────────────
     if (stall_for_load_use) {
         // We have to insert a bubble (NOP) in EX and keep ID as-is
-        insert_nop(EX, pipeline);
+        insert_bubble(EX, ctx->pipeline, stall_cause, stall_distance);
     } else if (flush_for_branch) {
         // Branch was taken in EX: forcibly squash the next instruction in EX
-        insert_nop(EX, pipeline);
+        if (ctx->pc_profile) pc_profile_flush(ctx->pc_profile, ctx->pipeline[MEM].pc, 2); // ID and IF (the target is fetched this cycle)
+        insert_bubble(EX, ctx->pipeline, CPI_BRANCH_FLUSH, 0);
     } else {
         // Normal pipeline advance
-        pipeline[EX] = pipeline[ID];
+        ctx->pipeline[EX] = ctx->pipeline[ID];
     }
 
     // ─── Now handle flushing ID/IF ─────────────────────────────────
     if (flush_for_branch) {
         // We already forced EX = NOP above. Now squash ID and IF.
-        insert_nop(ID, pipeline);
-        insert_nop(IF, pipeline);
+        insert_bubble(ID, ctx->pipeline, CPI_BRANCH_FLUSH, 0);
+        insert_bubble(IF, ctx->pipeline, CPI_BRANCH_FLUSH, 0);
         flush_for_branch = 0;  // done handling the flush
     } else if (stall_for_load_use) {
         // Do nothing: keep ID/IF as they were (so ID still holds the consumer waiting on load)
     } else {
         // Normal, no-stall, no-branch: push IF→ID, then IF = NOP
-        pipeline[ID] = pipeline[IF];
-        insert_nop(IF, pipeline);
+        ctx->pipeline[ID] = ctx->pipeline[IF];
+        insert_nop(IF, ctx->pipeline);
     }
+    STAGE_PROBE(PROBE_ADVANCE);
     // --- IF (Instruction Fetch) Stage ---
     if (stall_for_load_use) {
         // IF stage is stalled, pipeline_pc does not advance. pipeline[IF] holds its current instruction.
@@ -389,23 +414,28 @@ static void simulate_one_cycle_with_forwarding_internal() {
         // IF stage has been NOPped above. pipeline_pc is already pointing to branch target.
         // Fetch will happen from new PC in the next cycle's IF stage.
     } else {  // Not stalling for load-use, not flushing this cycle
-        if (!pipeline_halt_seen && pipeline_pc < (MAX_MEMORY_LINES * WORD_SIZE)) {
-            uint32_t instr_word_fetched = state.memory[pipeline_pc / 4];
-            DecodedInstruction fetched = decode_instruction(instr_word_fetched);
-            pipeline[IF].instr = fetched;
-            pipeline[IF].valid = 1;
-            pipeline[IF].pc = pipeline_pc;
+        if (!ctx->pipeline_halt_seen && ctx->pipeline_pc < (MAX_MEMORY_LINES * WORD_SIZE)) {
+            DecodedInstruction fetched = fetch_instruction(ctx, ctx->pipeline_pc);  // Predecoded when available
+            ctx->pipeline[IF].instr = fetched;
+            ctx->pipeline[IF].valid = 1;
+            ctx->pipeline[IF].pc = ctx->pipeline_pc;
+            ctx->pipeline[IF].seq = ++ctx->pipeline_fetch_seq;
             if (fetched.opcode == HALT) {
-                pipeline_halt_seen = 1;
+                ctx->pipeline_halt_seen = 1;
             }
-            pipeline_pc += 4;  // Advance fetch PC for next instruction
+            ctx->pipeline_pc += 4;  // Advance fetch PC for next instruction
         } else {
-            insert_nop(IF, pipeline);  // PC out of bounds or halt already seen
-            if (pipeline_pc >= (MAX_MEMORY_LINES * WORD_SIZE) && !pipeline_halt_seen) {
-                pipeline_halt_seen = 1;
+            insert_bubble(IF, ctx->pipeline, CPI_DRAIN, 0);  // PC out of bounds or halt already seen
+            if (ctx->pipeline_pc >= (MAX_MEMORY_LINES * WORD_SIZE) && !ctx->pipeline_halt_seen) {
+                ctx->pipeline_halt_seen = 1;
             }
         }
     }
+    STAGE_PROBE(PROBE_FETCH);
+
+    // Charge this cycle to what has reached WB
+    cpi_stack_account(ctx);
+    STAGE_PROBE(PROBE_ACCOUNT);
 }
 
 /*
@@ -414,38 +444,55 @@ static void simulate_one_cycle_with_forwarding_internal() {
 * It processes instructions in the pipeline, handling stalls and flushes as needed.
 * It continues until a HALT instruction is encountered or no active instructions remain.
 */
-void simulate_pipeline_with_forwarding() {
-    initialize_pipeline_fwd();
+void simulate_pipeline_with_forwarding(SimContext *ctx) {
+    initialize_pipeline_fwd(ctx);
 
-    while (1) {
+    while (!step_pipeline_with_forwarding(ctx)) {
+        // One clock cycle per step
+    }
+
+    print_final_state(ctx);  // Print final state after simulation ends
+}
+
+/*
+* Advances the forwarding pipeline by one clock cycle.
+* If HALT has reached WB afterwards it is retired, and the run is marked finished
+* (also when the pipeline has drained or the watchdog stops the run).
+* Returns 1 once the run has finished (ctx->halted), 0 otherwise.
+*/
+int step_pipeline_with_forwarding(SimContext *ctx) {
+    if (ctx->halted) return 1;
+
+    simulate_one_cycle_with_forwarding_internal(ctx);
+
+    int finished = 0;
+    if (watchdog_expired(ctx, WATCHDOG_WF_DEFAULT_CYCLES)) { // Cycle or instruction budget, or infinite loop
+        finished = 1;
+    } else if (ctx->pipeline[WB].valid && ctx->pipeline[WB].instr.opcode == HALT) {
+        // Retire HALT (this will bump all counters and advance PC by 4 inside simulate_instruction)
+        simulate_instruction(ctx, ctx->pipeline[WB].instr);
+        if (ctx->pc_profile) pc_profile_commit(ctx->pc_profile, &ctx->pipeline[WB].instr, ctx->pipeline[WB].pc);
+        finished = 1;
+    } else {
         int active_instructions_remaining = 0;
         for (int i = 0; i < PIPELINE_DEPTH; i++) {
-            if (pipeline[i].valid && pipeline[i].instr.opcode != NOP) {
+            if (ctx->pipeline[i].valid && ctx->pipeline[i].instr.opcode != NOP) {
                 active_instructions_remaining = 1;
                 break;
             }
         }
-
-        if (pipeline[WB].valid && pipeline[WB].instr.opcode == HALT) {
-            // 1) Retire HALT (this will bump all counters and advance PC by 4 inside simulate_instruction)
-            simulate_instruction(pipeline[WB].instr);
-            // 2) Now stop the pipeline loop
-            break;
-        }
-
-        if (!active_instructions_remaining && (pipeline_halt_seen || pipeline_pc >= (MAX_MEMORY_LINES * WORD_SIZE))) {
-            break;
-        }
-
-        simulate_one_cycle_with_forwarding_internal();
-
-        if (clock_cycles > 100000) {
-            fprintf(stderr, "Simulator possibly in infinite loop, breaking.\n");
-            break;
+        if (!active_instructions_remaining && (ctx->pipeline_halt_seen || ctx->pipeline_pc >= (MAX_MEMORY_LINES * WORD_SIZE))) {
+            finished = 1;
         }
     }
-    // Fix state PC stuff
-    state.pc += 4;
 
-    print_final_state();  // Print final state after simulation ends
+    if (finished) {
+        // Fix state PC stuff
+        ctx->state.pc += 4;
+        ctx->halted = 1;
+    } else {
+        PROGRESS_UPDATE(ctx);
+        LIVE_STATS_UPDATE(ctx);
+    }
+    return finished;
 }